@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "CountingBloomFilter.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<uint64_t>> {
+        size_t operator()(bloom::HashParams<uint64_t> const& s) const {
+            uint64_t h = (s.a ^ (uint64_t(s.b) << 56)) * 0x9e3779b97f4a7c15ull;
+            return h ^ (h >> 29);
+        }
+    };
+}
+
+/** Counts data TLB read misses of the calling thread, where the kernel
+ *  permits it.
+ */
+class TlbMissCounter {
+
+public:
+
+    TlbMissCounter(){
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        m_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~TlbMissCounter(){
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+    }
+
+    void Start(){
+        if(m_fd >= 0){
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    /** Returns the number of misses since Start(), or -1 if unavailable
+     */
+    long long Stop(){
+        long long count = -1;
+        if(m_fd >= 0){
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if(read(m_fd, &count, sizeof(count)) != sizeof(count)){
+                count = -1;
+            }
+        }
+        return count;
+    }
+
+private:
+
+    int m_fd;
+
+};
+
+/** Queries a bank of filters, each probe landing in a random filter, so
+ *  that the working set spans many pages.
+ */
+void Run(const char *name, bloom::AllocationPolicy const& policy){
+    const size_t numFilters = 256;
+    const size_t numQueries = 4000000;
+
+    std::vector<bloom::CountingBloomFilter<uint64_t>> filters;
+    for(size_t i = 0; i < numFilters; i++){
+        filters.emplace_back(4, 65535, policy);
+        for(uint64_t k = 0; k < 2000; k++){
+            filters.back().Insert(i * 1000003 + k);
+        }
+    }
+
+    TlbMissCounter tlb;
+    size_t positives = 0;
+    uint64_t x = 1;
+    tlb.Start();
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < numQueries; i++){
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        positives += filters[(x >> 33) % numFilters].Query(x);
+    }
+    auto end = std::chrono::steady_clock::now();
+    long long misses = tlb.Stop();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name << ": " << ns / numQueries << " ns/query, dTLB misses/query ";
+    if(misses >= 0){
+        std::cout << (double) misses / numQueries;
+    }
+    else {
+        std::cout << "n/a";
+    }
+    std::cout << " (" << positives << " positives)" << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    bloom::AllocationPolicy policy;
+    Run("default pages     ", policy);
+
+    policy.pageSize = bloom::AllocationPolicy::HugePages2M;
+    Run("2M pages          ", policy);
+
+    policy.placement = bloom::AllocationPolicy::Interleave;
+    Run("2M pages, interlv ", policy);
+
+    return 0;
+}
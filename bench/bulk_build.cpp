@@ -0,0 +1,51 @@
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+
+/** Builds a BF from the keys by calling Insert in a loop, then by BuildFrom
+ *  with each number of threads, and reports the time per key.
+ */
+template <typename BF>
+void Run(const char *name, std::vector<uint64_t> const& keys){
+    auto start = std::chrono::steady_clock::now();
+    BF bf(7, 65520);
+    for(uint64_t k : keys){
+        bf.Insert(k);
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << " Insert loop: "
+              << std::chrono::duration<double, std::nano>(end - start).count() / keys.size()
+              << " ns/key" << std::endl;
+
+    for(unsigned numThreads = 1; numThreads <= std::thread::hardware_concurrency(); numThreads *= 2){
+        start = std::chrono::steady_clock::now();
+        BF built = BF::BuildFrom(7, 65520, keys, numThreads);
+        end = std::chrono::steady_clock::now();
+        std::cout << name << " BuildFrom, " << numThreads << " thread(s): "
+                  << std::chrono::duration<double, std::nano>(end - start).count() / keys.size()
+                  << " ns/key" << std::endl;
+        if(!built.Query(keys[0])){
+            std::cout << "build failed" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]){
+
+    const size_t numKeys = 20000000;
+
+    std::vector<uint64_t> keys;
+    for(uint64_t i = 0; i < numKeys; i++){
+        keys.push_back(i * 0x9E3779B97F4A7C15ull);
+    }
+
+    std::cout << "k = 7, m = 65520, " << numKeys << " keys" << std::endl;
+
+    Run<bloom::OrdinaryBloomFilter<uint64_t>>("ordinary", keys);
+    Run<bloom::CountingBloomFilter<uint64_t>>("counting", keys);
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include "PairedBloomFilter.hpp"
+#include "InterleavedPairedBloomFilter.hpp"
+
+/** Inserts the first numInserted keys and deletes every fourth of them,
+ *  then measures query throughput over a mix of present, deleted and
+ *  absent keys.
+ */
+template <typename BF>
+void Run(const char *name, BF bf, std::vector<uint64_t> const& keys, size_t numInserted){
+    for(size_t i = 0; i < numInserted; i++){
+        bf.Insert(keys[i]);
+    }
+    for(size_t i = 0; i < numInserted; i += 4){
+        bf.Delete(keys[i]);
+    }
+
+    size_t positives = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int rep = 0; rep < 4; rep++){
+        for(size_t i = 0; i < keys.size(); i++){
+            positives += bf.Query(keys[i]);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    size_t numQueries = 4 * keys.size();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name
+              << ": positive " << (double) positives / numQueries
+              << ", " << ns / numQueries << " ns/query" << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    const uint8_t numHashes = 8;
+    const uint16_t numBits = 65520;
+    const size_t numInserted = 4096;
+    const size_t numKeys = 1000000;
+
+    std::vector<uint64_t> keys;
+    for(uint64_t i = 0; i < numKeys; i++){
+        keys.push_back(i * 0x9E3779B97F4A7C15ull);
+    }
+
+    std::cout << "k = " << (int) numHashes << ", m = " << numBits
+              << ", n = " << numInserted << std::endl;
+
+    Run("paired     ", bloom::PairedBloomFilter<uint64_t>(numHashes, numBits), keys, numInserted);
+    Run("interleaved", bloom::InterleavedPairedBloomFilter<uint64_t>(numHashes, numBits), keys, numInserted);
+
+    return 0;
+}
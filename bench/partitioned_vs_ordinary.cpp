@@ -0,0 +1,62 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "PartitionedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+/** Inserts the first numInserted keys, then measures the false positive
+ *  ratio and query throughput over the remaining ones.
+ */
+template <typename BF>
+void Run(const char *name, BF bf, std::vector<std::string> const& keys, size_t numInserted){
+    for(size_t i = 0; i < numInserted; i++){
+        bf.Insert(keys[i]);
+    }
+
+    size_t positives = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = numInserted; i < keys.size(); i++){
+        positives += bf.Query(keys[i]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    size_t numQueries = keys.size() - numInserted;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name
+              << ": fpr " << (double) positives / numQueries
+              << ", " << ns / numQueries << " ns/query" << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    const uint8_t numHashes = 8;
+    const uint16_t numBits = 65520;
+    const size_t numInserted = 4096;
+    const size_t numQueries = 2000000;
+
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < numInserted + numQueries; i++){
+        keys.push_back("key-" + std::to_string(i));
+    }
+
+    std::cout << "k = " << (int) numHashes << ", m = " << numBits
+              << ", n = " << numInserted << std::endl;
+
+    Run("ordinary   ", bloom::OrdinaryBloomFilter<std::string>(numHashes, numBits), keys, numInserted);
+    Run("partitioned", bloom::PartitionedBloomFilter<std::string>(numHashes, numBits), keys, numInserted);
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "RangeBloomFilter.hpp"
+
+int main(int argc, char *argv[]){
+
+    const uint8_t numHashes = 6;
+    const uint16_t numBits = 65535;
+    const uint8_t numLevels = 16;
+    const size_t numInserted = 500;
+    const size_t numQueries = 20000;
+
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys;
+    for(size_t i = 0; i < numInserted; i++){
+        keys.push_back(rng() >> 24);
+    }
+
+    bloom::OrdinaryBloomFilter<uint64_t> point(numHashes, numBits);
+    bloom::RangeBloomFilter<uint64_t> range(numHashes, numBits, numLevels);
+    for(uint64_t k : keys){
+        point.Insert(k);
+        range.Insert(k);
+    }
+
+    std::cout << "k = " << (int) numHashes << ", m = " << numBits << ", L = " << (int) numLevels
+              << ", n = " << numInserted << std::endl;
+
+    for(uint64_t length : {16, 256, 4096}){
+        std::vector<uint64_t> starts;
+        for(size_t i = 0; i < numQueries; i++){
+            starts.push_back(rng() >> 24);
+        }
+
+        size_t pointPositives = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(uint64_t a : starts){
+            for(uint64_t o = a; o < a + length; o++){
+                if(point.Query(o)){
+                    pointPositives++;
+                    break;
+                }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double pointNs = std::chrono::duration<double, std::nano>(end - start).count() / numQueries;
+
+        size_t rangePositives = 0;
+        start = std::chrono::steady_clock::now();
+        for(uint64_t a : starts){
+            rangePositives += range.QueryRange(a, a + length - 1);
+        }
+        end = std::chrono::steady_clock::now();
+        double rangeNs = std::chrono::duration<double, std::nano>(end - start).count() / numQueries;
+
+        std::cout << "length " << length
+                  << ": point loop " << pointNs << " ns/range, positive " << (double) pointPositives / numQueries
+                  << "; QueryRange " << rangeNs << " ns/range, positive " << (double) rangePositives / numQueries
+                  << std::endl;
+    }
+
+    return 0;
+}
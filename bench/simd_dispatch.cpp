@@ -0,0 +1,73 @@
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "SimdKernels.hpp"
+
+/** Calls a kernel repeatedly and prints its throughput in bytes of input
+ *  per nanosecond
+ */
+template <typename F>
+void Run(const char *name, size_t bytes, F kernel){
+    const int reps = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for(int rep = 0; rep < reps; rep++){
+        kernel();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": " << bytes * reps / ns << " B/ns" << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    const size_t numCounters = 1 << 16;
+    const size_t numWords = numCounters / 64;
+    const size_t numProbes = 16;
+
+    std::mt19937 rng(1);
+    std::vector<uint8_t> a(numCounters), b(numCounters);
+    for(size_t i = 0; i < numCounters; i++){
+        a[i] = rng() % 4 == 0 ? rng() % 256 : 0;
+        b[i] = rng() % 4 == 0 ? rng() % 256 : 0;
+    }
+    std::vector<uint64_t> x(numWords), y(numWords), changed(numWords / 64 + 1);
+    for(size_t i = 0; i < numWords; i++){
+        x[i] = (uint64_t(rng()) << 32) | rng();
+        y[i] = (uint64_t(rng()) << 32) | rng();
+    }
+    std::vector<uint32_t> found(numCounters);
+    // a partitioned probe of 16 bits, all set, to time full-depth queries
+    std::vector<uint32_t> bitArray(numWords * 2, ~uint32_t(0));
+    std::vector<uint16_t> bits(numProbes);
+    for(uint16_t &bit : bits){
+        bit = rng() % (numWords * 64);
+    }
+
+    std::cout << "detected " << bloom::simd::IsaName(bloom::simd::DetectIsa())
+              << ", " << numCounters << " counters, " << numWords << " words" << std::endl;
+
+    for(int i = 0; i < bloom::simd::NumIsas; i++){
+        bloom::simd::Isa isa = (bloom::simd::Isa) i;
+        if(!bloom::simd::SetIsa(isa)){
+            continue;
+        }
+        std::cout << bloom::simd::IsaName(isa) << std::endl;
+
+        std::vector<uint8_t> c(a);
+        Run("CountersToBits    ", numCounters, [&]{ bloom::simd::CountersToBits(a.data(), numCounters, x.data()); });
+        Run("SaturatingAdd     ", numCounters, [&]{ bloom::simd::SaturatingAdd(c.data(), b.data(), numCounters); });
+        Run("SaturatingSubtract", numCounters, [&]{ bloom::simd::SaturatingSubtract(c.data(), b.data(), numCounters); });
+        Run("FindAtLeast       ", numCounters, [&]{ bloom::simd::FindAtLeast(a.data(), numCounters, 1, found.data()); });
+        Run("PopCountAndOr     ", 16 * numWords, [&]{
+            uint64_t andCount, orCount;
+            bloom::simd::PopCountAndOr(x.data(), y.data(), numWords, andCount, orCount);
+        });
+        // after the first call, the union leaves every word unchanged
+        Run("UnionWords        ", 8 * numWords, [&]{ bloom::simd::UnionWords(x.data(), y.data(), numWords, changed.data()); });
+        Run("OrWords           ", 8 * numWords, [&]{ bloom::simd::OrWords(bitArray.data(), bitArray.data() + numWords, numWords); });
+        Run("TestBits          ", 2 * numProbes, [&]{ bloom::simd::TestBits(bitArray.data(), bits.data(), numProbes); });
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+
+/** Computes the all-pairs similarity matrix of a set of shards with the
+ *  given number of threads and reports the time per pair.
+ */
+double Run(std::vector<bloom::OrdinaryBloomFilter<uint64_t>> const& filters, unsigned numThreads){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> matrix = bloom::OrdinaryBloomFilter<uint64_t>::EstimateJaccardMatrix(filters, numThreads);
+    auto end = std::chrono::steady_clock::now();
+
+    size_t numPairs = filters.size() * (filters.size() + 1) / 2;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << numThreads << " thread(s): " << ns / numPairs << " ns/pair" << std::endl;
+    return matrix[1];
+}
+
+int main(int argc, char *argv[]){
+
+    const uint8_t numHashes = 4;
+    const uint16_t numBits = 65520;
+    const size_t numFilters = 512;
+    const size_t numInserted = 4096;
+
+    // neighbouring shards share half of their keys
+    std::vector<bloom::OrdinaryBloomFilter<uint64_t>> filters;
+    for(size_t f = 0; f < numFilters; f++){
+        filters.emplace_back(numHashes, numBits);
+        for(uint64_t i = 0; i < numInserted; i++){
+            filters.back().Insert((f * numInserted / 2 + i) * 0x9E3779B97F4A7C15ull);
+        }
+    }
+
+    std::cout << "k = " << (int) numHashes << ", m = " << numBits
+              << ", n = " << numInserted << ", " << numFilters << " filters" << std::endl;
+
+    double similarity = Run(filters, 1);
+    unsigned numThreads = std::thread::hardware_concurrency();
+    if(numThreads > 1){
+        Run(filters, numThreads);
+    }
+    std::cout << "neighbour similarity " << similarity << std::endl;
+
+    return 0;
+}
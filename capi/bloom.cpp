@@ -0,0 +1,238 @@
+#define BLOOM_BUILDING_CAPI
+#include "bloom.h"
+
+#include <new>
+#include <string>
+#include <cstring>
+#include <sstream>
+#include <variant>
+#include <string_view>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+
+namespace {
+
+typedef bloom::OrdinaryBloomFilter<std::string> Ordinary;
+typedef bloom::CountingBloomFilter<std::string> Counting;
+typedef bloom::PairedBloomFilter<std::string> Paired;
+
+/** Returns key i of a batch
+ *  @see bloom_insert_batch
+ */
+std::string_view Key(void const *data, uint64_t const *offsets, uint64_t const *lengths, size_t i){
+    uint64_t len = lengths ? lengths[i] : offsets[i + 1] - offsets[i];
+    return std::string_view((char const *) data + offsets[i], len);
+}
+
+/** Returns true if every key of a batch lies within its buffer, and its
+ *  offsets are nondecreasing when they also mark the ends of the keys
+ *  @see bloom_insert_batch
+ */
+bool KeysInBounds(size_t dataLen, uint64_t const *offsets, uint64_t const *lengths, size_t n){
+    for(size_t i = 0; i < n; i++){
+        uint64_t end = lengths ? lengths[i] : offsets[i + 1];
+        if(offsets[i] > dataLen || (lengths ? end > dataLen - offsets[i] : end < offsets[i] || end > dataLen)){
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Returns the size of a serialized filter of the given type and geometry
+ */
+size_t SerializedSize(bloom_kind_t kind, uint16_t numBits){
+    switch(kind){
+        case BLOOM_ORDINARY: return 3 + (numBits + 7u) / 8;
+        case BLOOM_COUNTING: return 3 + numBits;
+        case BLOOM_PAIRED: return 3 + (2u * numBits + 7) / 8;
+    }
+    return 0;
+}
+
+template <typename BF>
+BF Deserialize(void const *buf, size_t len){
+    std::istringstream is(std::string((char const *) buf, len));
+    return BF::Deserialize(is);
+}
+
+template <typename BF>
+constexpr bool IsDeletable(){
+    return !std::is_same<BF, Ordinary>::value;
+}
+
+} // namespace
+
+struct bloom_filter {
+    bloom_kind_t kind;
+    std::variant<Ordinary, Counting, Paired> bf;
+};
+
+extern "C" {
+
+int bloom_abi_version(void){
+    return BLOOM_ABI_VERSION;
+}
+
+bloom_filter_t *bloom_create(bloom_kind_t kind, uint8_t num_hashes, uint16_t num_bits){
+    if(num_hashes == 0 || num_bits == 0){
+        return nullptr;
+    }
+    try {
+        switch(kind){
+            case BLOOM_ORDINARY: return new bloom_filter{kind, Ordinary(num_hashes, num_bits)};
+            case BLOOM_COUNTING: return new bloom_filter{kind, Counting(num_hashes, num_bits)};
+            case BLOOM_PAIRED: return new bloom_filter{kind, Paired(num_hashes, num_bits)};
+        }
+    }
+    catch(std::bad_alloc const&){
+    }
+    return nullptr;
+}
+
+void bloom_destroy(bloom_filter_t *bf){
+    delete bf;
+}
+
+bloom_kind_t bloom_kind(bloom_filter_t const *bf){
+    return bf->kind;
+}
+
+uint8_t bloom_num_hashes(bloom_filter_t const *bf){
+    return std::visit([](auto const& f){ return f.GetNumHashes(); }, bf->bf);
+}
+
+uint16_t bloom_num_bits(bloom_filter_t const *bf){
+    return std::visit([](auto const& f){ return f.GetNumBits(); }, bf->bf);
+}
+
+int bloom_insert(bloom_filter_t *bf, void const *key, size_t len){
+    if(!bf || (!key && len)){
+        return BLOOM_EINVAL;
+    }
+    std::visit([&](auto &f){ f.Insert(std::string_view((char const *) key, len)); }, bf->bf);
+    return BLOOM_OK;
+}
+
+int bloom_query(bloom_filter_t const *bf, void const *key, size_t len){
+    if(!bf || (!key && len)){
+        return BLOOM_EINVAL;
+    }
+    return std::visit([&](auto const& f){ return f.Query(std::string_view((char const *) key, len)); }, bf->bf);
+}
+
+int bloom_delete(bloom_filter_t *bf, void const *key, size_t len){
+    if(!bf || (!key && len)){
+        return BLOOM_EINVAL;
+    }
+    return std::visit([&](auto &f) -> int {
+        if constexpr (IsDeletable<std::decay_t<decltype(f)>>()){
+            return f.Delete(std::string_view((char const *) key, len));
+        }
+        return BLOOM_ENOTSUP;
+    }, bf->bf);
+}
+
+int bloom_insert_batch(bloom_filter_t *bf, void const *data, size_t data_len,
+                       uint64_t const *offsets, uint64_t const *lengths, size_t n){
+    if(!bf || (n && (!data || !offsets)) || !KeysInBounds(data_len, offsets, lengths, n)){
+        return BLOOM_EINVAL;
+    }
+    std::visit([&](auto &f){
+        for(size_t i = 0; i < n; i++){
+            f.Insert(Key(data, offsets, lengths, i));
+        }
+    }, bf->bf);
+    return BLOOM_OK;
+}
+
+int bloom_query_batch(bloom_filter_t const *bf, void const *data, size_t data_len,
+                      uint64_t const *offsets, uint64_t const *lengths, size_t n, uint8_t *results){
+    if(!bf || (n && (!data || !offsets || !results)) || !KeysInBounds(data_len, offsets, lengths, n)){
+        return BLOOM_EINVAL;
+    }
+    std::visit([&](auto const& f){
+        for(size_t i = 0; i < n; i++){
+            results[i] = f.Query(Key(data, offsets, lengths, i));
+        }
+    }, bf->bf);
+    return BLOOM_OK;
+}
+
+int bloom_delete_batch(bloom_filter_t *bf, void const *data, size_t data_len,
+                       uint64_t const *offsets, uint64_t const *lengths, size_t n, uint8_t *results){
+    if(!bf || (n && (!data || !offsets)) || !KeysInBounds(data_len, offsets, lengths, n)){
+        return BLOOM_EINVAL;
+    }
+    return std::visit([&](auto &f) -> int {
+        if constexpr (IsDeletable<std::decay_t<decltype(f)>>()){
+            for(size_t i = 0; i < n; i++){
+                bool deleted = f.Delete(Key(data, offsets, lengths, i));
+                if(results){
+                    results[i] = deleted;
+                }
+            }
+            return BLOOM_OK;
+        }
+        return BLOOM_ENOTSUP;
+    }, bf->bf);
+}
+
+int bloom_union(bloom_filter_t *dst, bloom_filter_t const *src){
+    if(!dst || !src || dst->kind != src->kind
+       || bloom_num_hashes(dst) != bloom_num_hashes(src) || bloom_num_bits(dst) != bloom_num_bits(src)){
+        return BLOOM_EINVAL;
+    }
+    switch(dst->kind){
+        case BLOOM_ORDINARY: std::get<Ordinary>(dst->bf).Union(std::get<Ordinary>(src->bf)); break;
+        case BLOOM_COUNTING: std::get<Counting>(dst->bf).Add(std::get<Counting>(src->bf)); break;
+        case BLOOM_PAIRED: std::get<Paired>(dst->bf).Union(std::get<Paired>(src->bf)); break;
+    }
+    return BLOOM_OK;
+}
+
+int bloom_serialize(bloom_filter_t const *bf, void *buf, size_t cap, size_t *len){
+    if(!bf || !len){
+        return BLOOM_EINVAL;
+    }
+    *len = SerializedSize(bf->kind, bloom_num_bits(bf));
+    if(*len > cap){
+        return BLOOM_ENOSPC;
+    }
+    if(!buf){
+        return BLOOM_EINVAL;
+    }
+    try {
+        std::ostringstream os;
+        std::visit([&](auto const& f){ f.Serialize(os); }, bf->bf);
+        std::memcpy(buf, os.str().data(), *len);
+    }
+    catch(std::bad_alloc const&){
+        return BLOOM_ENOMEM;
+    }
+    return BLOOM_OK;
+}
+
+bloom_filter_t *bloom_deserialize(bloom_kind_t kind, void const *buf, size_t len){
+    // the C++ Deserialize does not validate, so check the size here
+    uint16_t numBits;
+    if(!buf || len < 3){
+        return nullptr;
+    }
+    std::memcpy(&numBits, (char const *) buf + 1, sizeof(uint16_t));
+    if(((uint8_t const *) buf)[0] == 0 || numBits == 0 || SerializedSize(kind, numBits) != len){
+        return nullptr;
+    }
+    try {
+        switch(kind){
+            case BLOOM_ORDINARY: return new bloom_filter{kind, Deserialize<Ordinary>(buf, len)};
+            case BLOOM_COUNTING: return new bloom_filter{kind, Deserialize<Counting>(buf, len)};
+            case BLOOM_PAIRED: return new bloom_filter{kind, Deserialize<Paired>(buf, len)};
+        }
+    }
+    catch(std::bad_alloc const&){
+    }
+    return nullptr;
+}
+
+} // extern "C"
@@ -0,0 +1,127 @@
+#ifndef BLOOM_CAPI_H
+#define BLOOM_CAPI_H
+
+/** C interface to the ordinary, counting and paired Bloom filters, indexing
+ *  byte strings. Keys are hashed exactly as std::string keys of the C++
+ *  classes with the default hash, bloom::DefaultHash, so filters
+ *  serialized by either side can be read by the other. The serialized
+ *  format does not record the hash: a filter written by a C++ program
+ *  which specializes std::hash<bloom::HashParams<std::string>> loads
+ *  without error, but queries for the keys it holds will miss.
+ *
+ *  Functions return BLOOM_OK or a negative error code, unless documented
+ *  otherwise. As with the C++ classes, a filter must not be modified
+ *  concurrently with any other operation on it.
+ *
+ *  The ABI is stable: functions are only ever added, and
+ *  bloom_abi_version() is incremented when they are.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(BLOOM_BUILDING_CAPI)
+#define BLOOM_API __attribute__((visibility("default")))
+#else
+#define BLOOM_API
+#endif
+
+#define BLOOM_ABI_VERSION 1
+
+/** Filter types */
+typedef enum {
+    BLOOM_ORDINARY = 0,
+    BLOOM_COUNTING = 1,
+    BLOOM_PAIRED = 2
+} bloom_kind_t;
+
+/** Error codes */
+enum {
+    BLOOM_OK = 0,
+    BLOOM_EINVAL = -1,  /* invalid argument */
+    BLOOM_ENOTSUP = -2, /* operation not supported by the filter type */
+    BLOOM_ENOSPC = -3,  /* output buffer too small */
+    BLOOM_ENOMEM = -4   /* allocation failed */
+};
+
+typedef struct bloom_filter bloom_filter_t;
+
+/** Returns BLOOM_ABI_VERSION as of the library's build */
+BLOOM_API int bloom_abi_version(void);
+
+/** Creates an empty filter, or returns NULL on failure.
+ *
+ *  @param kind        Filter type
+ *  @param num_hashes  Number of hashes, at least 1
+ *  @param num_bits    Number of bits, at least 1
+ */
+BLOOM_API bloom_filter_t *bloom_create(bloom_kind_t kind, uint8_t num_hashes, uint16_t num_bits);
+
+/** Destroys a filter. NULL is ignored. */
+BLOOM_API void bloom_destroy(bloom_filter_t *bf);
+
+BLOOM_API bloom_kind_t bloom_kind(bloom_filter_t const *bf);
+BLOOM_API uint8_t bloom_num_hashes(bloom_filter_t const *bf);
+BLOOM_API uint16_t bloom_num_bits(bloom_filter_t const *bf);
+
+/** Inserts a key of len bytes. */
+BLOOM_API int bloom_insert(bloom_filter_t *bf, void const *key, size_t len);
+
+/** Returns 1 if the key may be present, 0 if it is not. */
+BLOOM_API int bloom_query(bloom_filter_t const *bf, void const *key, size_t len);
+
+/** Deletes a key from a counting or paired filter. Returns 1 if the key was
+ *  present and deleted, 0 if not, or BLOOM_ENOTSUP for ordinary filters.
+ */
+BLOOM_API int bloom_delete(bloom_filter_t *bf, void const *key, size_t len);
+
+/* Batch calls operate on n keys stored in one buffer of data_len bytes:
+ * key i is the lengths[i] bytes at data + offsets[i]. If lengths is NULL,
+ * offsets must hold n + 1 nondecreasing entries and key i ends at
+ * offsets[i + 1], as in the Apache Arrow large binary layout. If any key
+ * lies outside the buffer, or the offsets decrease, BLOOM_EINVAL is
+ * returned before any key is processed.
+ */
+
+/** Inserts n keys. */
+BLOOM_API int bloom_insert_batch(bloom_filter_t *bf, void const *data, size_t data_len,
+                                 uint64_t const *offsets, uint64_t const *lengths, size_t n);
+
+/** Queries n keys, setting results[i] to 1 if key i may be present and 0
+ *  otherwise.
+ */
+BLOOM_API int bloom_query_batch(bloom_filter_t const *bf, void const *data, size_t data_len,
+                                uint64_t const *offsets, uint64_t const *lengths, size_t n, uint8_t *results);
+
+/** Deletes n keys from a counting or paired filter, setting results[i] to
+ *  1 if key i was deleted and 0 otherwise. results may be NULL.
+ */
+BLOOM_API int bloom_delete_batch(bloom_filter_t *bf, void const *data, size_t data_len,
+                                 uint64_t const *offsets, uint64_t const *lengths, size_t n, uint8_t *results);
+
+/** Merges src into dst, which must have the same type and geometry.
+ *  Counting filters are merged by adding their counters.
+ */
+BLOOM_API int bloom_union(bloom_filter_t *dst, bloom_filter_t const *src);
+
+/** Serializes a filter, in the format of the C++ Serialize, into buf. The
+ *  size of the output is stored in *len, also when it is larger than cap,
+ *  in which case BLOOM_ENOSPC is returned and buf is left untouched; buf
+ *  may then be NULL.
+ */
+BLOOM_API int bloom_serialize(bloom_filter_t const *bf, void *buf, size_t cap, size_t *len);
+
+/** Creates a filter of the given type from len bytes written by
+ *  bloom_serialize or by the C++ Serialize, or returns NULL on failure.
+ */
+BLOOM_API bloom_filter_t *bloom_deserialize(bloom_kind_t kind, void const *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "bloom.h"
+
+#define CHECK(cond, msg) do { if(!(cond)){ printf("Error: %s\n", msg); return 1; } } while(0)
+
+int main(void){
+
+    static const char data[] = "applebananacherrydate";
+    uint64_t offsets[] = {0, 5, 11, 17, 21};
+    uint64_t lengths[] = {5, 6, 6, 4};
+    uint64_t bad_offsets[] = {UINT64_MAX - 2, 11, 5};
+    uint8_t results[4];
+    int kind;
+
+    CHECK(bloom_abi_version() == BLOOM_ABI_VERSION, "ABI version mismatch.");
+    CHECK(bloom_create(BLOOM_ORDINARY, 0, 100) == NULL, "Filter with no hashes was created.");
+
+    for(kind = BLOOM_ORDINARY; kind <= BLOOM_PAIRED; kind++){
+        bloom_filter_t *bf = bloom_create((bloom_kind_t) kind, 4, 1024);
+        bloom_filter_t *other = bloom_create((bloom_kind_t) kind, 4, 1024);
+        bloom_filter_t *copy;
+        unsigned char *buf;
+        size_t len;
+
+        CHECK(bf && other, "Filter creation failed.");
+        CHECK(bloom_kind(bf) == kind && bloom_num_hashes(bf) == 4 && bloom_num_bits(bf) == 1024,
+              "Filter geometry is wrong.");
+
+        /* first two keys with explicit lengths, last two in Arrow layout */
+        CHECK(bloom_insert_batch(bf, data, 21, offsets, lengths, 2) == BLOOM_OK, "Batch insert failed.");
+        CHECK(bloom_insert_batch(other, data, 21, offsets + 2, NULL, 2) == BLOOM_OK, "Arrow batch insert failed.");
+        CHECK(bloom_query(bf, "apple", 5) == 1 && bloom_query(bf, "cherry", 6) == 0, "Query was wrong.");
+
+        CHECK(bloom_union(bf, other) == BLOOM_OK, "Union failed.");
+        CHECK(bloom_query_batch(bf, data, 21, offsets, NULL, 4, results) == BLOOM_OK, "Batch query failed.");
+        CHECK(results[0] && results[1] && results[2] && results[3], "Batch query missed an inserted key.");
+
+        /* keys past the end of the buffer, or decreasing Arrow offsets */
+        CHECK(bloom_query_batch(bf, data, 20, offsets, NULL, 4, results) == BLOOM_EINVAL
+              && bloom_query_batch(bf, data, 21, offsets + 3, lengths + 2, 1, results) == BLOOM_EINVAL
+              && bloom_insert_batch(bf, data, 21, bad_offsets, lengths, 1) == BLOOM_EINVAL
+              && bloom_insert_batch(bf, data, 21, bad_offsets + 1, NULL, 1) == BLOOM_EINVAL
+              && bloom_delete_batch(bf, data, 21, bad_offsets, lengths, 1, NULL) == BLOOM_EINVAL,
+              "Batch with keys outside the buffer was accepted.");
+
+        CHECK(bloom_insert(bf, "", 0) == BLOOM_OK && bloom_query(bf, NULL, 0) == 1, "Empty key was not found.");
+
+        if(kind == BLOOM_ORDINARY){
+            CHECK(bloom_delete(bf, "apple", 5) == BLOOM_ENOTSUP, "Delete on an ordinary filter did not fail.");
+        }
+        else {
+            CHECK(bloom_delete(bf, "apple", 5) == 1 && bloom_query(bf, "apple", 5) == 0, "Delete failed.");
+            CHECK(bloom_delete_batch(bf, data, 21, offsets + 1, lengths + 1, 1, results) == BLOOM_OK && results[0],
+                  "Batch delete failed.");
+        }
+
+        CHECK(bloom_serialize(bf, NULL, 0, &len) == BLOOM_ENOSPC && len > 3, "Size query failed.");
+        buf = malloc(len);
+        CHECK(bloom_serialize(bf, buf, len, &len) == BLOOM_OK, "Serialize failed.");
+        CHECK(bloom_deserialize((bloom_kind_t) kind, buf, len - 1) == NULL, "Truncated filter was accepted.");
+        copy = bloom_deserialize((bloom_kind_t) kind, buf, len);
+        CHECK(copy && bloom_query(copy, "date", 4) == bloom_query(bf, "date", 4)
+              && bloom_query(copy, "apple", 5) == bloom_query(bf, "apple", 5), "Deserialized filter differs.");
+
+        free(buf);
+        bloom_destroy(copy);
+        bloom_destroy(other);
+        bloom_destroy(bf);
+    }
+
+    printf("Tests passed.\n");
+
+    return 0;
+}
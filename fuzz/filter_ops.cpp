@@ -0,0 +1,278 @@
+#include <deque>
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "InterleavedPairedBloomFilter.hpp"
+#include "ConcurrentPairedBloomFilter.hpp"
+#include "PartitionedBloomFilter.hpp"
+#include "SlidingWindowBloomFilter.hpp"
+
+/** Fuzz target which interprets its input as a sequence of operations on
+ *  every filter type, and checks the filters against exact sets:
+ *
+ *  - ordinary, partitioned, counting and sliding-window filters never give
+ *    false negatives, also after Union, Compress and Serialize
+ *  - the three paired layouts give identical answers and serialize to
+ *    identical bytes
+ *  - every filter serializes to the same bytes after a round trip
+ *
+ *  Built with clang's -fsanitize=fuzzer by `make fuzz`. Built with
+ *  BLOOM_FUZZ_STANDALONE, it instead runs the files given as arguments, or
+ *  a fixed set of random inputs, which `make sanitize_tests` uses.
+ */
+
+namespace {
+
+typedef uint64_t Key;
+
+void Check(bool condition, const char *what, Key key = 0){
+    if(!condition){
+        std::cerr << "Invariant violated: " << what << " (key " << key << ")" << std::endl;
+        std::abort();
+    }
+}
+
+class Reader {
+
+public:
+
+    Reader(const uint8_t *data, size_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_pos(0)
+    {}
+
+    bool Done() const {
+        return m_pos >= m_size;
+    }
+
+    uint8_t Byte(){
+        return m_pos < m_size ? m_data[m_pos++] : 0;
+    }
+
+private:
+
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_pos;
+
+};
+
+template <typename BF>
+std::string Bytes(BF const& bf){
+    std::ostringstream os;
+    bf.Serialize(os);
+    return os.str();
+}
+
+template <typename BF>
+BF RoundTrip(BF const& bf){
+    std::istringstream is(Bytes(bf));
+    return BF::Deserialize(is);
+}
+
+class FilterOps {
+
+public:
+
+    FilterOps(uint8_t numHashes, uint16_t numBits, uint8_t numGenerations)
+    : m_ordinary(numHashes, numBits)
+    , m_ordinarySide(numHashes, numBits)
+    , m_partitioned(numHashes, numBits)
+    , m_partitionedSide(numHashes, numBits)
+    , m_counting(numHashes, numBits)
+    , m_paired(numHashes, numBits)
+    , m_pairedSide(numHashes, numBits)
+    , m_interleaved(numHashes, numBits)
+    , m_interleavedSide(numHashes, numBits)
+    , m_concurrent(numHashes, numBits)
+    , m_window(numHashes, numBits, numGenerations)
+    , m_generations(1)
+    {}
+
+    void Insert(Key key){
+        m_ordinary.Insert(key);
+        m_partitioned.Insert(key);
+        m_counting.Insert(key);
+        m_paired.Insert(key);
+        m_interleaved.Insert(key);
+        m_concurrent.Insert(key);
+        m_window.Insert(key);
+        m_inserted.insert(key);
+        m_counts[key]++;
+        m_generations.back().insert(key);
+    }
+
+    void InsertSide(Key key){
+        m_ordinarySide.Insert(key);
+        m_partitionedSide.Insert(key);
+        m_pairedSide.Insert(key);
+        m_interleavedSide.Insert(key);
+        m_side.insert(key);
+    }
+
+    void Delete(Key key){
+        // deleting an object which was never inserted may delete others
+        if(m_counts[key] > 0){
+            Check(m_counting.Delete(key), "counting delete of a present key failed", key);
+            m_counts[key]--;
+        }
+        bool paired = m_paired.Delete(key);
+        Check(m_interleaved.Delete(key) == paired, "interleaved delete differs from paired", key);
+        Check(m_concurrent.Delete(key) == paired, "concurrent delete differs from paired", key);
+    }
+
+    void Query(Key key) const {
+        if(m_inserted.count(key)){
+            Check(m_ordinary.Query(key), "ordinary false negative", key);
+            Check(m_partitioned.Query(key), "partitioned false negative", key);
+        }
+        auto it = m_counts.find(key);
+        if(it != m_counts.end() && it->second > 0){
+            Check(m_counting.Query(key), "counting false negative", key);
+            Check(m_counting.Count(key) >= std::min(it->second, 255u), "counting undercount", key);
+        }
+        for(auto const& generation : m_generations){
+            if(generation.count(key)){
+                Check(m_window.Query(key), "sliding-window false negative", key);
+            }
+        }
+        bool paired = m_paired.Query(key);
+        Check(m_interleaved.Query(key) == paired, "interleaved query differs from paired", key);
+        Check(m_concurrent.Query(key) == paired, "concurrent query differs from paired", key);
+    }
+
+    void Union(){
+        m_ordinary.Union(m_ordinarySide);
+        m_partitioned.Union(m_partitionedSide);
+        m_paired.Union(m_pairedSide);
+        m_interleaved.Union(m_interleavedSide);
+        m_concurrent.Union(m_pairedSide);
+        m_inserted.insert(m_side.begin(), m_side.end());
+    }
+
+    void Serialize(){
+        std::string paired = Bytes(m_paired);
+        Check(Bytes(m_interleaved) == paired, "interleaved serialization differs from paired");
+        Check(Bytes(m_concurrent) == paired, "concurrent serialization differs from paired");
+        Check(Bytes(RoundTrip(m_concurrent)) == paired, "concurrent round trip changed the filter");
+
+        m_ordinary = CheckRoundTrip(m_ordinary, "ordinary");
+        m_partitioned = CheckRoundTrip(m_partitioned, "partitioned");
+        m_counting = CheckRoundTrip(m_counting, "counting");
+        m_paired = CheckRoundTrip(m_paired, "paired");
+        m_interleaved = CheckRoundTrip(m_interleaved, "interleaved");
+        m_window = CheckRoundTrip(m_window, "sliding-window");
+    }
+
+    void Compress() const {
+        bloom::OrdinaryBloomFilter<Key> ordinary = m_ordinary.Compress();
+        bloom::PartitionedBloomFilter<Key> partitioned = m_partitioned.Compress();
+        for(Key key : m_inserted){
+            Check(ordinary.Query(key), "compressed ordinary false negative", key);
+            Check(partitioned.Query(key), "compressed partitioned false negative", key);
+        }
+    }
+
+    void Advance(){
+        m_window.Advance();
+        m_generations.emplace_back();
+        if(m_generations.size() > m_window.GetNumGenerations()){
+            m_generations.pop_front();
+        }
+    }
+
+private:
+
+    template <typename BF>
+    static BF CheckRoundTrip(BF const& bf, const char *what){
+        std::string bytes = Bytes(bf);
+        BF copy = RoundTrip(bf);
+        Check(Bytes(copy) == bytes, what);
+        return copy;
+    }
+
+    bloom::OrdinaryBloomFilter<Key> m_ordinary, m_ordinarySide;
+    bloom::PartitionedBloomFilter<Key> m_partitioned, m_partitionedSide;
+    bloom::CountingBloomFilter<Key> m_counting;
+    bloom::PairedBloomFilter<Key> m_paired, m_pairedSide;
+    bloom::InterleavedPairedBloomFilter<Key> m_interleaved, m_interleavedSide;
+    bloom::ConcurrentPairedBloomFilter<Key> m_concurrent;
+    bloom::SlidingWindowBloomFilter<Key> m_window;
+
+    /** Exact contents: of the ordinary and partitioned filters, of the side
+     *  filters not yet merged, of the counting filter, and of each live
+     *  generation of the sliding-window filter, oldest first
+     */
+    std::unordered_set<Key> m_inserted, m_side;
+    std::unordered_map<Key, unsigned> m_counts;
+    std::deque<std::unordered_set<Key>> m_generations;
+
+};
+
+} // namespace
+
+/** The first three bytes choose the geometry, so that the slice size of the
+ *  partitioned filter is even and both filters can be compressed. Every
+ *  further pair of bytes is an operation and a key; keys are drawn from a
+ *  small range so that operations often hit the same objects.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size){
+    Reader in(data, size);
+    uint8_t numHashes = 1 + in.Byte() % 8;
+    uint16_t numBits = 2 * numHashes * (4 + in.Byte());
+    uint8_t numGenerations = 1 + in.Byte() % 4;
+
+    FilterOps ops(numHashes, numBits, numGenerations);
+    while(!in.Done()){
+        uint8_t op = in.Byte();
+        Key key = in.Byte();
+        switch(op % 8){
+            case 0: case 1: ops.Insert(key); break;
+            case 2: ops.InsertSide(key); break;
+            case 3: ops.Delete(key); break;
+            case 4: ops.Query(key); break;
+            case 5: ops.Union(); break;
+            case 6: ops.Serialize(); break;
+            case 7: (op & 8) ? ops.Compress() : ops.Advance(); break;
+        }
+    }
+    for(Key key = 0; key < 256; key++){
+        ops.Query(key);
+    }
+    return 0;
+}
+
+#ifdef BLOOM_FUZZ_STANDALONE
+int main(int argc, char *argv[]){
+
+    if(argc > 1){
+        for(int i = 1; i < argc; i++){
+            std::ifstream f(argv[i], std::ios::binary);
+            std::string input((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput((const uint8_t *) input.data(), input.size());
+        }
+    }
+    else {
+        std::mt19937 rng(1);
+        for(int i = 0; i < 400; i++){
+            std::vector<uint8_t> input(rng() % 1024);
+            for(uint8_t &b : input){
+                b = rng();
+            }
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+    }
+
+    std::cout << "Tests passed." << std::endl;
+
+    return 0;
+}
+#endif
@@ -3,24 +3,152 @@
 
 #include <cstdbool>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <functional>
+#include <type_traits>
+#include "FastHash.hpp"
 
 namespace bloom {
 
-/** Container type for a hashable object and a salt
+/** Container type for a hashable object and a salt. The object is held by
+ *  reference, so constructing one never copies the object being hashed.
  *
  *  @param T Contained type being hashed
  */
 template <typename T>
 struct HashParams {
-    T a;        //!< Object to hash
+    T const& a; //!< Object to hash
     uint8_t b;  //!< 8-bit salt
 };
 
+namespace detail {
+
+/** Base of the default std::hash specialization for HashParams<T>, by which
+ *  it can be told apart from a user specialization
+ */
+struct DefaultHashSpecialization {};
+
+} // namespace detail
+
+} // namespace bloom
+
+namespace std {
+
+/** Default hash for HashParams<T>, using bloom::DefaultHash. A full
+ *  specialization of std::hash<bloom::HashParams<T>> for a particular T
+ *  takes precedence over this one.
+ */
+template <typename T>
+struct hash<bloom::HashParams<T>> : bloom::detail::DefaultHashSpecialization {
+    size_t operator()(bloom::HashParams<T> const& p) const {
+        return bloom::DefaultHash<T>{}(p.a, p.b);
+    }
+};
+
+} // namespace std
+
+namespace bloom {
+
+/** A precomputed 64-bit digest of an object, used in place of the object by
+ *  the InsertHash and QueryHash family of operations. The k indexes are
+ *  derived from the digest by double hashing, so objects inserted by digest
+ *  must also be queried by digest.
+ */
+struct HashDigest {
+    uint64_t value; //!< 64-bit digest
+};
+
+/** True if objects of type T are hashed by the default std::hash
+ *  specialization for HashParams<T>, that is, by DefaultHash<T>.
+ */
+template <typename T>
+using UsesDefaultHash = std::is_base_of<detail::DefaultHashSpecialization, std::hash<HashParams<T>>>;
+
+namespace detail {
+
+/** Key types which are hashed by DefaultHash as the equivalent T is
+ */
+template <typename T, typename K>
+struct IsDefaultTransparentKey : std::false_type {};
+
+template <>
+struct IsDefaultTransparentKey<std::string, std::string_view> : std::true_type {};
+
+template <>
+struct IsDefaultTransparentKey<std::string, char const*> : std::true_type {};
+
+} // namespace detail
+
+/** Declares that key type K may be used in place of T for heterogeneous
+ *  lookups, which requires std::hash<HashParams<K>> to give every K the
+ *  same hash as the equivalent T. It holds for std::string_view and
+ *  char const* keys of std::string if both are hashed by DefaultHash, and
+ *  for no other pair unless declared by specializing TransparentKey<T, K>
+ *  as std::true_type, which must also be done if either hash is
+ *  specialized by the user.
+ */
+template <typename T, typename K>
+struct TransparentKey : std::conjunction<detail::IsDefaultTransparentKey<T, K>,
+                                         UsesDefaultHash<T>, UsesDefaultHash<K>> {};
+
+namespace detail {
+
+template <typename K, typename T>
+struct CheckTransparentKey : std::true_type {
+    static_assert(TransparentKey<T, K>::value,
+                  "K is not a transparent key of T, and may be hashed differently from T. "
+                  "Specialize bloom::TransparentKey<T, K> if both hashes agree");
+};
+
+} // namespace detail
+
+/** Enabled for key types K which are a TransparentKey of T, and which may
+ *  then be used in place of T without constructing one. Lookups by other
+ *  key types which are not implicitly convertible to T are rejected at
+ *  compile time, rather than silently hashing them differently from T.
+ */
+template <typename K, typename T>
+using EnableIfTransparent = typename std::enable_if<
+    std::disjunction<TransparentKey<T, K>,
+                     std::conjunction<std::negation<std::is_convertible<K const&, T const&>>,
+                                      detail::CheckTransparentKey<K, T>>>::value>::type;
+
+/** Returns the index in [0, range) associated with the given (object, salt)
+ *  pair. Every filter derives its indexes through HashIndex, so that
+ *  structures built from filters of equal geometry, such as
+ *  BloomFilterBank, probe the same bits. It can be evaluated at compile
+ *  time if the std::hash specialization for HashParams<K> is constexpr.
+ *
+ *  @param  o     Object to hash
+ *  @param  salt  Salt to allow creating multiple hashes for an object
+ *  @param  range Number of distinct indexes which may be returned
+ *  @return Index corresponding to the (object, salt) pair
+ */
+template <typename K>
+constexpr uint16_t HashIndex(K const& o, uint8_t salt, uint16_t range) {
+    return std::hash<HashParams<K>>{}({o, salt}) % range;
+}
+
+/** Returns the index in [0, range) associated with the given (digest, salt)
+ *  pair, using double hashing on the two halves of the digest.
+ *
+ *  @param  d     Precomputed digest
+ *  @param  salt  Index of the hash to compute
+ *  @param  range Number of distinct indexes which may be returned
+ *  @return Index corresponding to the (digest, salt) pair
+ */
+constexpr uint16_t HashIndex(HashDigest const& d, uint8_t salt, uint16_t range) {
+    uint64_t h1 = d.value & 0xffffffff;
+    uint64_t h2 = (d.value >> 32) | 1;
+    return (h1 + salt * h2) % range;
+}
+
 /** Abstract class from which all BloomFilter types inherit. Contains common
  *  functionality for constructors, getters, and hashing and defines interface
- *  for insertions, queries, and serialization. One must specialize std::hash
- *  for HashParams<T> in order for T to be indexed in a Bloom filter.
+ *  for insertions, queries, and serialization. T is hashed with
+ *  std::hash<HashParams<T>>, which defaults to DefaultHash<T> and may be
+ *  specialized for types it does not cover or to change the hash.
  *
  *  @param T Contained type being indexed
  */
@@ -82,7 +210,7 @@ public:
     virtual void Serialize(std::ostream &os) const = 0;
 
 protected:
-    
+
     /** Returns the bit array index associated with the given (object, salt)
      *  pair. Result is guaranteed to be between 0 and GetNumBits() - 1
      *  (inclusive).
@@ -91,8 +219,35 @@ protected:
      *  @param  salt Salt to allow creating multiple hashes for an object
      *  @return Index in bit array corresponding to the (object, salt) pair
      */
-    uint16_t ComputeHash(T const& o, uint8_t salt) const {
-        return std::hash<HashParams<T>>{}({o, salt}) % GetNumBits();
+    template <typename K>
+    uint16_t ComputeHash(K const& o, uint8_t salt) const {
+        return HashIndex(o, salt, GetNumBits());
+    }
+
+    /** Returns the bit array index associated with the given (digest, salt)
+     *  pair, using double hashing on the two halves of the digest.
+     *
+     *  @param  d    Precomputed digest
+     *  @param  salt Index of the hash to compute
+     *  @return Index in bit array corresponding to the (digest, salt) pair
+     */
+    uint16_t ComputeHash(HashDigest const& d, uint8_t salt) const {
+        return HashIndex(d, salt, GetNumBits());
+    }
+
+    /** Returns the index associated with the given (object, salt) pair
+     *  within a caller-specified range, for filters which do not address
+     *  their whole bit array with every hash. Result is guaranteed to be
+     *  between 0 and range - 1 (inclusive).
+     *
+     *  @param  o     Object to hash
+     *  @param  salt  Salt to allow creating multiple hashes for an object
+     *  @param  range Number of distinct indexes which may be returned
+     *  @return Index corresponding to the (object, salt) pair
+     */
+    template <typename K>
+    uint16_t ComputeHash(K const& o, uint8_t salt, uint16_t range) const {
+        return HashIndex(o, salt, range);
     }
 
 private:
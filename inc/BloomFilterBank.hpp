@@ -0,0 +1,442 @@
+#ifndef BloomFilterBank_hpp
+#define BloomFilterBank_hpp
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "AbstractBloomFilter.hpp"
+#include "OrdinaryBloomFilter.hpp"
+#include "SimdKernels.hpp"
+
+namespace bloom {
+
+/** Layout of the serialized form of a BloomFilterBank, all fields in
+ *  native byte order. The header is padded to 64 bytes so that the rows
+ *  which follow it are aligned for direct use from a memory-mapped file.
+ */
+struct BloomFilterBankHeader {
+    char magic[8];          //!< "BFBANK1" with a terminating NUL
+    uint8_t numHashes;
+    uint8_t reserved0;
+    uint16_t numBits;
+    uint32_t reserved1;
+    uint64_t numFilters;
+    uint64_t rowWords;      //!< Words per row, ceil(numFilters / 64)
+    uint8_t reserved2[32];
+};
+
+static_assert(sizeof(BloomFilterBankHeader) == 64, "BloomFilterBankHeader must be 64 bytes");
+
+/** Converts a bitmap returned by a bank query into the indexes of the
+ *  filters it selects, in increasing order.
+ */
+inline std::vector<size_t> ToFilterIndexes(std::vector<uint64_t> const& bitmap){
+    std::vector<size_t> res;
+    for(size_t w = 0; w < bitmap.size(); w++){
+        for(uint64_t bits = bitmap[w]; bits; bits &= bits - 1){
+            res.push_back(64 * w + __builtin_ctzll(bits));
+        }
+    }
+    return res;
+}
+
+/** Read-only view of a bit-sliced bank of Bloom filters held in external
+ *  memory, such as a memory-mapped file written by
+ *  BloomFilterBank::Serialize. The memory must outlive the view.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class BloomFilterBankView {
+
+public:
+
+    /** Constructor: validates and wraps a serialized bank.
+     *
+     *  @param data Start of the serialized bank, aligned to 8 bytes
+     *  @param len  Length of the buffer in bytes
+     *  @throws std::invalid_argument if the buffer does not hold a bank
+     */
+    BloomFilterBankView(void const *data, size_t len){
+        BloomFilterBankHeader h;
+        if(len < sizeof(h) || reinterpret_cast<uintptr_t>(data) % alignof(uint64_t)){
+            throw std::invalid_argument("buffer too short or misaligned for a Bloom filter bank");
+        }
+        std::memcpy(&h, data, sizeof(h));
+        if(std::memcmp(h.magic, Magic, sizeof(h.magic)) != 0 || h.numHashes == 0 || h.numBits == 0
+           || h.rowWords != (h.numFilters + 63) / 64
+           || (len - sizeof(h)) / sizeof(uint64_t) / h.numBits < h.rowWords){
+            throw std::invalid_argument("buffer does not hold a Bloom filter bank");
+        }
+        m_numHashes = h.numHashes;
+        m_numBits = h.numBits;
+        m_numFilters = h.numFilters;
+        m_rowWords = h.rowWords;
+        m_rows = reinterpret_cast<uint64_t const *>(static_cast<char const *>(data) + sizeof(h));
+    }
+
+    uint8_t GetNumHashes() const {
+        return m_numHashes;
+    }
+
+    uint16_t GetNumBits() const {
+        return m_numBits;
+    }
+
+    /** Returns the number of filters in the bank
+     */
+    size_t GetNumFilters() const {
+        return m_numFilters;
+    }
+
+    /** Returns the filters which may contain an object, by hashing the
+     *  object once and ANDing the k rows it selects.
+     *
+     *  @param  o Object to query
+     *  @return Bitmap of (GetNumFilters() + 63) / 64 words in which bit j
+     *          (counting from the least significant bit of word 0) is set
+     *          iff filter j may contain the object
+     */
+    std::vector<uint64_t> Query(T const& o) const {
+        return QueryKey(o);
+    }
+
+    /** Queries for an object given by an equivalent key type.
+     *  @see BloomFilterBankView::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    std::vector<uint64_t> Query(K const& key) const {
+        return QueryKey(key);
+    }
+
+    /** Queries for an object by its precomputed digest.
+     *  @see BloomFilterBankView::Query
+     */
+    std::vector<uint64_t> QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+
+private:
+
+    template <typename U>
+    friend class BloomFilterBank;
+
+    static constexpr char Magic[8] = "BFBANK1";
+
+    BloomFilterBankView(uint8_t numHashes, uint16_t numBits, size_t numFilters,
+                        size_t rowWords, uint64_t const *rows)
+    : m_numHashes(numHashes)
+    , m_numBits(numBits)
+    , m_numFilters(numFilters)
+    , m_rowWords(rowWords)
+    , m_rows(rows)
+    {}
+
+    template <typename K>
+    std::vector<uint64_t> QueryKey(K const& key) const {
+        uint16_t indexes[256];
+        for(uint8_t i = 0; i < m_numHashes; i++){
+            indexes[i] = HashIndex(key, i, m_numBits);
+            __builtin_prefetch(m_rows + indexes[i] * m_rowWords);
+        }
+
+        size_t words = (m_numFilters + 63) / 64;
+        uint64_t const *first = m_rows + indexes[0] * m_rowWords;
+        std::vector<uint64_t> res(first, first + words);
+        for(uint8_t i = 1; i < m_numHashes; i++){
+            uint64_t const *row = m_rows + indexes[i] * m_rowWords;
+            uint64_t any = 0;
+            for(size_t w = 0; w < words; w++){
+                res[w] &= row[w];
+                any |= res[w];
+            }
+            if(!any){
+                break;
+            }
+        }
+        return res;
+    }
+
+    uint8_t m_numHashes;
+    uint16_t m_numBits;
+    size_t m_numFilters;
+
+    /** Stride between consecutive rows, in words
+     */
+    size_t m_rowWords;
+
+    uint64_t const *m_rows;
+
+}; // class BloomFilterBankView
+
+/** A bank of ordinary Bloom filters of equal geometry, stored bit-sliced:
+ *  row i holds bit i of every filter, one bit per filter. A query hashes
+ *  the object once and ANDs k rows to find every filter which may contain
+ *  it, instead of querying each filter in turn (as in BitFunnel and COBS).
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class BloomFilterBank {
+
+public:
+
+    /** Constructor: creates an empty bank.
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @throws std::invalid_argument if numHashes or numBits is 0, as for
+     *          a BloomFilterBankView
+     */
+    BloomFilterBank(uint8_t numHashes, uint16_t numBits)
+    : m_numHashes(numHashes)
+    , m_numBits(numBits)
+    , m_numFilters(0)
+    , m_rowWords(0)
+    {
+        if(numHashes == 0 || numBits == 0){
+            throw std::invalid_argument("a Bloom filter bank needs at least one hash and one bit");
+        }
+    }
+
+    uint8_t GetNumHashes() const {
+        return m_numHashes;
+    }
+
+    uint16_t GetNumBits() const {
+        return m_numBits;
+    }
+
+    /** Returns the number of filters in the bank
+     */
+    size_t GetNumFilters() const {
+        return m_numFilters;
+    }
+
+    /** Makes room for a total of numFilters filters without further
+     *  reallocation.
+     */
+    void Reserve(size_t numFilters){
+        if(numFilters > 64 * m_rowWords){
+            Restride((numFilters + 63) / 64);
+        }
+    }
+
+    /** Appends a copy of an ordinary BF to the bank.
+     *
+     *  @param  bf BF with the same geometry as the bank
+     *  @return Index of the new filter within the bank
+     *  @throws std::invalid_argument if the geometry differs
+     */
+    size_t Add(OrdinaryBloomFilter<T> const& bf){
+        CheckGeometry(bf);
+        size_t j = m_numFilters;
+        Grow(j + 1);
+        uint64_t bit = uint64_t(1) << (j % 64);
+        for(size_t w = 0; w < bf.m_words.size(); w++){
+            for(uint64_t bits = bf.m_words[w]; bits; bits &= bits - 1){
+                size_t row = 64 * w + __builtin_ctzll(bits);
+                m_rows[row * m_rowWords + j / 64] |= bit;
+            }
+        }
+        m_numFilters++;
+        return j;
+    }
+
+    /** Appends copies of a sequence of ordinary BFs to the bank. Whole
+     *  groups of 64 filters starting at a word boundary are transposed as
+     *  64x64 bit matrices, which is much faster than adding them one at a
+     *  time when the filters are dense.
+     *
+     *  @param  first Iterator to the first BF
+     *  @param  last  Iterator past the last BF
+     *  @return Index of the first new filter within the bank
+     *  @throws std::invalid_argument if the geometry of any BF differs, in
+     *          which case none are added
+     */
+    template <typename It>
+    size_t Add(It first, It last){
+        for(It it = first; it != last; ++it){
+            CheckGeometry(*it);
+        }
+        size_t start = m_numFilters;
+        Grow(start + std::distance(first, last));
+
+        while(first != last && m_numFilters % 64){
+            Add(*first++);
+        }
+        std::vector<OrdinaryBloomFilter<T> const *> group;
+        uint64_t block[64];
+        while(std::distance(first, last) >= 64){
+            group.clear();
+            for(unsigned f = 0; f < 64; f++){
+                group.push_back(&*first++);
+            }
+            size_t col = m_numFilters / 64;
+            for(size_t w = 0; w < group[0]->m_words.size(); w++){
+                for(unsigned f = 0; f < 64; f++){
+                    block[f] = group[f]->m_words[w];
+                }
+                simd::Transpose64(block);
+                for(unsigned b = 0; b < 64 && 64 * w + b < m_numBits; b++){
+                    m_rows[(64 * w + b) * m_rowWords + col] = block[b];
+                }
+            }
+            m_numFilters += 64;
+        }
+        while(first != last){
+            Add(*first++);
+        }
+        return start;
+    }
+
+    /** Inserts an object into one filter of the bank.
+     *
+     *  @param filter Index of the filter
+     *  @param o      Object to insert
+     */
+    void Insert(size_t filter, T const& o){
+        InsertKey(filter, o);
+    }
+
+    /** Inserts an object given by an equivalent key type into one filter.
+     *  @see BloomFilterBank::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(size_t filter, K const& key){
+        InsertKey(filter, key);
+    }
+
+    /** Inserts an object by its precomputed digest into one filter.
+     *  @see BloomFilterBank::Insert
+     */
+    void InsertHash(size_t filter, uint64_t digest){
+        InsertKey(filter, HashDigest{digest});
+    }
+
+    /** @see BloomFilterBankView::Query
+     */
+    std::vector<uint64_t> Query(T const& o) const {
+        return GetView().Query(o);
+    }
+
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    std::vector<uint64_t> Query(K const& key) const {
+        return GetView().Query(key);
+    }
+
+    std::vector<uint64_t> QueryHash(uint64_t digest) const {
+        return GetView().QueryHash(digest);
+    }
+
+    /** Returns a read-only view of the bank, valid until it is next
+     *  modified.
+     */
+    BloomFilterBankView<T> GetView() const {
+        return BloomFilterBankView<T>(m_numHashes, m_numBits, m_numFilters, m_rowWords, m_rows.data());
+    }
+
+    /** Extracts one filter of the bank as an ordinary BF.
+     *
+     *  @param  filter Index of the filter
+     *  @return Copy of the filter
+     */
+    OrdinaryBloomFilter<T> GetFilter(size_t filter) const {
+        OrdinaryBloomFilter<T> res(m_numHashes, m_numBits);
+        for(uint16_t row = 0; row < m_numBits; row++){
+            if((m_rows[row * m_rowWords + filter / 64] >> (filter % 64)) & 1){
+                res.SetBit(row);
+            }
+        }
+        return res;
+    }
+
+    /** Writes the bank in a form which BloomFilterBankView can use in
+     *  place, e.g. from a memory-mapped file: a 64-byte
+     *  BloomFilterBankHeader followed by the rows, each of
+     *  ceil(GetNumFilters() / 64) native-endian words.
+     *
+     *  @param os output stream to serialize the bank into
+     */
+    void Serialize(std::ostream &os) const {
+        BloomFilterBankHeader h = {};
+        std::memcpy(h.magic, BloomFilterBankView<T>::Magic, sizeof(h.magic));
+        h.numHashes = m_numHashes;
+        h.numBits = m_numBits;
+        h.numFilters = m_numFilters;
+        h.rowWords = (m_numFilters + 63) / 64;
+        os.write((const char *) &h, sizeof(h));
+        for(uint16_t row = 0; row < m_numBits; row++){
+            os.write((const char *) (m_rows.data() + row * m_rowWords), h.rowWords * sizeof(uint64_t));
+        }
+    }
+
+    /** Create a BloomFilterBank from the content of a binary input stream.
+     *  No validation is performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized BloomFilterBank
+     */
+    static BloomFilterBank<T> Deserialize(std::istream &is){
+        BloomFilterBankHeader h;
+        is.read((char *) &h, sizeof(h));
+
+        BloomFilterBank<T> r(h.numHashes, h.numBits);
+        r.Reserve(h.numFilters);
+        r.m_numFilters = h.numFilters;
+        is.read((char *) r.m_rows.data(), r.m_rows.size() * sizeof(uint64_t));
+        return r;
+    }
+
+private:
+
+    void CheckGeometry(OrdinaryBloomFilter<T> const& bf) const {
+        if(bf.GetNumHashes() != m_numHashes || bf.GetNumBits() != m_numBits){
+            throw std::invalid_argument("Bloom filter geometry differs from that of the bank");
+        }
+    }
+
+    /** Ensures there is room for numFilters filters, at least doubling
+     *  the row stride when it must grow.
+     */
+    void Grow(size_t numFilters){
+        if(numFilters > 64 * m_rowWords){
+            Restride(std::max((numFilters + 63) / 64, 2 * m_rowWords));
+        }
+    }
+
+    void Restride(size_t rowWords){
+        std::vector<uint64_t> rows(m_numBits * rowWords, 0);
+        for(uint16_t row = 0; row < m_numBits; row++){
+            std::copy_n(m_rows.data() + row * m_rowWords, m_rowWords, rows.data() + row * rowWords);
+        }
+        m_rows.swap(rows);
+        m_rowWords = rowWords;
+    }
+
+    template <typename K>
+    void InsertKey(size_t filter, K const& key){
+        for(uint8_t i = 0; i < m_numHashes; i++){
+            uint16_t row = HashIndex(key, i, m_numBits);
+            m_rows[row * m_rowWords + filter / 64] |= uint64_t(1) << (filter % 64);
+        }
+    }
+
+    uint8_t m_numHashes;
+    uint16_t m_numBits;
+    size_t m_numFilters;
+
+    /** Stride between consecutive rows, in words; 64 * m_rowWords is the
+     *  capacity of the bank in filters
+     */
+    size_t m_rowWords;
+
+    /** Row-major bit matrix of m_numBits rows
+     */
+    std::vector<uint64_t> m_rows;
+
+}; // class BloomFilterBank
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef BulkBuild_hpp
+#define BulkBuild_hpp
+
+#include <thread>
+#include <vector>
+#include <iterator>
+
+namespace bloom {
+
+namespace detail {
+
+/** Inserts every object of a random-access range into an empty BF,
+ *  splitting the range into contiguous partitions, one per thread. Each
+ *  thread but the calling one inserts into a private copy of the BF, so no
+ *  writes are shared, and the copies are then merged into the BF in order.
+ *
+ *  @param bf         Empty BF to insert into
+ *  @param objects    Range of objects, or of equivalent keys
+ *  @param numThreads Number of threads to split the range across
+ *  @param merge      Called as merge(bf, part) to add a private copy into bf
+ *  @return The BF, containing every object
+ */
+template <typename BF, typename Range, typename Merge>
+BF BuildFrom(BF bf, Range const& objects, unsigned numThreads, Merge merge){
+    // below this many objects per thread, copying the BF costs more than
+    // the insertions saved
+    const size_t minPartition = 4096;
+
+    auto first = std::begin(objects);
+    size_t n = std::size(objects);
+    if(numThreads > n / minPartition){
+        numThreads = n / minPartition;
+    }
+    if(numThreads < 2){
+        for(auto it = first; it != std::end(objects); ++it){
+            bf.Insert(*it);
+        }
+        return bf;
+    }
+
+    std::vector<BF> parts(numThreads - 1, bf);
+    auto insert = [&](BF &part, size_t begin, size_t end){
+        for(auto it = first + begin; it != first + end; ++it){
+            part.Insert(*it);
+        }
+    };
+
+    size_t step = (n + numThreads - 1) / numThreads;
+    std::vector<std::thread> threads;
+    for(unsigned t = 1; t < numThreads; t++){
+        size_t end = (t + 1) * step < n ? (t + 1) * step : n;
+        threads.emplace_back(insert, std::ref(parts[t - 1]), t * step, end);
+    }
+    insert(bf, 0, step);
+    for(unsigned t = 1; t < numThreads; t++){
+        threads[t - 1].join();
+        merge(bf, parts[t - 1]);
+    }
+    return bf;
+}
+
+} // namespace detail
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef ConcurrentPairedBloomFilter_hpp
+#define ConcurrentPairedBloomFilter_hpp
+
+#include <atomic>
+#include <memory>
+#include "AbstractDeletableBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "Statistics.hpp"
+
+namespace bloom {
+
+/** A paired Bloom filter which may be inserted into, deleted from, queried
+ *  and merged by any number of threads concurrently. Each word of the
+ *  positive and negative arrays is an atomic, updated with fetch-or (and
+ *  fetch-and for the negative array in Union), so no update is lost and no
+ *  word is ever read half-written. Queries only load words and are
+ *  wait-free.
+ *
+ *  Operations on different objects are independent. Operations on the same
+ *  object are ordered by the words they touch: a query running concurrently
+ *  with a deletion of the same object may report it either present or
+ *  absent, and two concurrent deletions of the same object may both
+ *  report success. Once a deletion has returned, every later query for the
+ *  object reports it absent, unless a Union clears its negative bits.
+ *
+ *  The storage layout and Serialize format are the same as those of
+ *  PairedBloomFilter.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class ConcurrentPairedBloomFilter : public AbstractDeletableBloomFilter<T> {
+
+public:
+
+    /** Constructor
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     */
+    explicit
+    ConcurrentPairedBloomFilter(uint8_t numHashes, uint16_t numBits)
+    : AbstractDeletableBloomFilter<T>(numHashes, numBits)
+    , m_halfWords((numBits + 63) / 64)
+    , m_words(new std::atomic<uint64_t>[2 * m_halfWords])
+    {
+        for(size_t i = 0; i < 2 * m_halfWords; i++){
+            m_words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /** Copy constructor. The copy is not an atomic snapshot if other is
+     *  being modified concurrently, but every word of it is consistent.
+     */
+    ConcurrentPairedBloomFilter(ConcurrentPairedBloomFilter<T> const& other)
+    : AbstractDeletableBloomFilter<T>(other)
+    , m_halfWords(other.m_halfWords)
+    , m_words(new std::atomic<uint64_t>[2 * m_halfWords])
+    {
+        for(size_t i = 0; i < 2 * m_halfWords; i++){
+            m_words[i].store(other.m_words[i].load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentPairedBloomFilter<T>& operator=(ConcurrentPairedBloomFilter<T> const& other) = delete;
+
+    virtual void Insert(T const& o) {
+        InsertKey(o);
+    }
+
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
+    }
+
+    /** Queries whether an object is indexed by this Bloom filter. Both false
+     *  negatives and false positives are possible.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    virtual bool Query(T const& o) const {
+        return QueryKey(o);
+    }
+
+    /** Queries for an object given by an equivalent key type.
+     *  @see ConcurrentPairedBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+
+    /** Queries for an object by its precomputed digest.
+     *  @see ConcurrentPairedBloomFilter::Query
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+
+    /** Deletes the object from the index.
+     *
+     * @param  o Object to delete
+     * @return true if the object was present and this call set at least one
+     *         of its negative bits; false otherwise.
+     */
+    virtual bool Delete(T const& o) {
+        return DeleteKey(o);
+    }
+
+    /** Deletes an object given by an equivalent key type.
+     *  @see ConcurrentPairedBloomFilter::Delete
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Delete(K const& key) {
+        return DeleteKey(key);
+    }
+
+    /** Deletes an object by its precomputed digest.
+     *  @see ConcurrentPairedBloomFilter::Delete
+     */
+    bool DeleteHash(uint64_t digest) {
+        return DeleteKey(HashDigest{digest});
+    }
+
+    /** Writes this BF in the PairedBloomFilter format. If the BF is being
+     *  modified concurrently, the output reflects some of the modifications.
+     *
+     *  @param os output stream to serialize the BF into
+     */
+    virtual void Serialize(std::ostream &os) const {
+        uint8_t numHashes = super::GetNumHashes();
+        uint16_t numBits = super::GetNumBits();
+
+        os.write((const char *) &numHashes, sizeof(uint8_t));
+        os.write((const char *) &numBits, sizeof(uint16_t));
+
+        for(unsigned i = 0; i < (2u * numBits + 7) / 8; i++){
+            uint8_t byte = 0;
+            for(unsigned j = 0; j < 8 && 8 * i + j < 2u * numBits; j++){
+                byte |= GetBit(8 * i + j) << (7 - j);
+            }
+            os.write((const char *) &byte, sizeof(uint8_t));
+        }
+    }
+
+    /** Create a ConcurrentPairedBloomFilter from the content of a binary
+     *  input stream in the PairedBloomFilter format. No validation is
+     *  performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized ConcurrentPairedBloomFilter
+     */
+    static ConcurrentPairedBloomFilter<T> Deserialize(std::istream &is){
+        PairedBloomFilter<T> bf = PairedBloomFilter<T>::Deserialize(is);
+        ConcurrentPairedBloomFilter<T> r(bf.GetNumHashes(), bf.GetNumBits());
+        for(size_t i = 0; i < 2 * r.m_halfWords; i++){
+            r.m_words[i].store(bf.m_words[i], std::memory_order_relaxed);
+        }
+        return r;
+    }
+
+    /** Update this Bloom filter by adding the contents of a paired BF with
+     *  the same geometry, such as a remote replica, while other threads
+     *  continue to use this one. The positive arrays are combined by OR
+     *  and the negative arrays by AND, as in PairedBloomFilter::Union.
+     *
+     *  @param other BF to combine into this one
+     */
+    void Union(PairedBloomFilter<T> const& other){
+        for(size_t i = 0; i < m_halfWords; i++){
+            m_words[i].fetch_or(other.m_words[i], std::memory_order_release);
+            m_words[m_halfWords + i].fetch_and(other.m_words[m_halfWords + i], std::memory_order_release);
+        }
+    }
+
+    /** Update this Bloom filter by adding the contents of another
+     *  concurrent paired BF with the same geometry. Both may be in use by
+     *  other threads.
+     *  @see ConcurrentPairedBloomFilter::Union
+     */
+    void Union(ConcurrentPairedBloomFilter<T> const& other){
+        for(size_t i = 0; i < m_halfWords; i++){
+            m_words[i].fetch_or(other.m_words[i].load(std::memory_order_acquire), std::memory_order_release);
+            m_words[m_halfWords + i].fetch_and(other.m_words[m_halfWords + i].load(std::memory_order_acquire),
+                                               std::memory_order_release);
+        }
+    }
+
+private:
+
+    typedef AbstractDeletableBloomFilter<T> super;
+
+    /** Computes the k indexes of an object, shared by its positive and
+     *  negative bits.
+     */
+    template <typename K>
+    void ComputeIndexes(K const& key, uint16_t *indexes) const {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            indexes[i] = super::ComputeHash(key, i);
+        }
+    }
+
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::ConcurrentPaired);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            unsigned bit = super::ComputeHash(key, i);
+            m_words[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_release);
+        }
+    }
+
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        uint16_t indexes[256];
+        ComputeIndexes(key, indexes);
+        unsigned depth;
+        bool rejected;
+        bool result = TestIndexes(indexes, depth, rejected);
+        stats::RecordQuery(stats::ConcurrentPaired, depth, result);
+        if(rejected){
+            stats::RecordNegativeReject(stats::ConcurrentPaired);
+        }
+        return result;
+    }
+
+    /** Tests membership of an object given its indexes.
+     *  @see PairedBloomFilter::TestKey
+     */
+    bool TestIndexes(uint16_t const *indexes, unsigned &depth, bool &rejected) const {
+        rejected = false;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!TestBit(indexes[i] / 64, indexes[i] % 64)){
+                depth = i + 1;
+                return false;
+            }
+        }
+        depth = super::GetNumHashes();
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!TestBit(m_halfWords + indexes[i] / 64, indexes[i] % 64)){
+                return true;
+            }
+        }
+        rejected = true;
+        return false;
+    }
+
+    template <typename K>
+    bool DeleteKey(K const& key) {
+        uint16_t indexes[256];
+        ComputeIndexes(key, indexes);
+        unsigned depth;
+        bool rejected;
+        bool deleted = false;
+        if(TestIndexes(indexes, depth, rejected)){
+            for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+                uint64_t mask = uint64_t(1) << (indexes[i] % 64);
+                uint64_t old = m_words[m_halfWords + indexes[i] / 64].fetch_or(mask, std::memory_order_acq_rel);
+                deleted |= !(old & mask);
+            }
+        }
+        stats::RecordDelete(stats::ConcurrentPaired, deleted);
+        return deleted;
+    }
+
+    bool TestBit(size_t word, unsigned offset) const {
+        return (m_words[word].load(std::memory_order_acquire) >> offset) & 1;
+    }
+
+    /** Reads a bit in the numbering of PairedBloomFilter::GetBit
+     */
+    bool GetBit(unsigned bit) const {
+        return bit < super::GetNumBits() ? TestBit(bit / 64, bit % 64)
+                                         : TestBit(m_halfWords + (bit - super::GetNumBits()) / 64,
+                                                   (bit - super::GetNumBits()) % 64);
+    }
+
+    /** Number of words in each of the positive and negative arrays
+     */
+    size_t m_halfWords;
+
+    /** Positive bit array in words [0, m_halfWords), followed by the
+     *  negative bit array in words [m_halfWords, 2 * m_halfWords), as in
+     *  PairedBloomFilter
+     */
+    std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+
+}; // class ConcurrentPairedBloomFilter
+
+} // namespace bloom
+
+#endif
@@ -2,7 +2,14 @@
 #define CountingBloomFilter_hpp
 
 #include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
 #include "AbstractDeletableBloomFilter.hpp"
+#include "SimdKernels.hpp"
+#include "PageAllocator.hpp"
+#include "BulkBuild.hpp"
+#include "Statistics.hpp"
 
 // forward decl
 namespace bloom {
@@ -16,7 +23,12 @@ namespace bloom {
 
 /** A counting Bloom filter. Instead of an array of bits, maintains an array of
  *  bytes. Each byte is incremented for an added item, or decremented for a
- *  deleted item, thereby supporting a delete operation.
+ *  deleted item, thereby supporting a delete operation. Counters saturate at
+ *  255, after which they are no longer incremented or decremented.
+ *
+ *  The counters also support frequency queries, as in a spectral Bloom
+ *  filter or count-min sketch: Count returns an upper bound on the number
+ *  of times an object was inserted.
  *
  *  @param T Contained type being indexed
  */
@@ -27,40 +39,232 @@ public:
 
     /** Constructor
      *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @param policy How to allocate the storage of this BF
      */
     explicit
-    CountingBloomFilter(uint8_t numHashes, uint16_t numBits)
+    CountingBloomFilter(uint8_t numHashes, uint16_t numBits, AllocationPolicy const& policy = AllocationPolicy())
     : AbstractDeletableBloomFilter<T>(numHashes, numBits)
-    {
-        m_bitarray.reserve(numBits);
-        for(uint16_t i = 0; i < super::GetNumBits(); i++){
-            m_bitarray[i] = 0;
-        }
+    , m_bitarray(numBits, 0, PageAllocator<uint8_t>(policy))
+    {}
+    
+    /** Copy constructor which places the copy's storage according to a
+     *  different allocation policy, e.g. to replicate a BF onto another NUMA
+     *  node.
+     *
+     *  @param other  BF to copy
+     *  @param policy How to allocate the storage of the copy
+     */
+    CountingBloomFilter(CountingBloomFilter<T> const& other, AllocationPolicy const& policy)
+    : AbstractDeletableBloomFilter<T>(other)
+    , m_bitarray(other.m_bitarray, PageAllocator<uint8_t>(policy))
+    {}
+    
+    /** Returns the policy with which the storage of this BF was allocated
+     */
+    AllocationPolicy GetAllocationPolicy() const {
+        return m_bitarray.get_allocator().GetPolicy();
+    }
+    
+    /** Creates a CountingBloomFilter containing every object of a range,
+     *  such as a std::vector, inserting from several threads at once. Each
+     *  thread fills a private copy of the counter array, which fits in
+     *  cache, and the copies are merged by saturating addition; the result
+     *  is the same as inserting the objects one by one.
+     *
+     *  @param  numHashes  Number of hashes
+     *  @param  numBits    Number of bits
+     *  @param  objects    Random-access range of objects, or of equivalent keys
+     *  @param  numThreads Number of threads to split the range across
+     *  @param  policy     How to allocate the storage of the BF
+     *  @return A new CountingBloomFilter
+     */
+    template <typename Range>
+    static CountingBloomFilter<T> BuildFrom(uint8_t numHashes, uint16_t numBits, Range const& objects,
+            unsigned numThreads = 1, AllocationPolicy const& policy = AllocationPolicy()){
+        return detail::BuildFrom(CountingBloomFilter<T>(numHashes, numBits, policy), objects, numThreads,
+                                 [](CountingBloomFilter<T> &bf, CountingBloomFilter<T> const& part){ bf.Add(part); });
     }
     
     virtual void Insert(T const& o) {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            m_bitarray[super::ComputeHash(o, i)] += 1;
-        }
+        InsertKey(o);
+    }
+    
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+    
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
+    }
+    
+    /** Inserts an object by conservative update (minimum increase): only
+     *  the object's counters equal to their minimum are incremented. Count
+     *  then overestimates frequencies far less than after Insert, but
+     *  Delete can no longer be used, since it would decrement counters
+     *  which the insertion did not increment.
+     *
+     *  @param o Object to insert
+     */
+    void InsertConservative(T const& o) {
+        InsertConservativeKey(o);
+    }
+    
+    /** Inserts an object given by an equivalent key type by conservative
+     *  update.
+     *  @see CountingBloomFilter::InsertConservative
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void InsertConservative(K const& key) {
+        InsertConservativeKey(key);
     }
     
+    /** Inserts an object by its precomputed digest by conservative update.
+     *  @see CountingBloomFilter::InsertConservative
+     */
+    void InsertConservativeHash(uint64_t digest) {
+        InsertConservativeKey(HashDigest{digest});
+    }
+    
+    /** Deletes the object from the index. Each hash is computed once and
+     *  reused for both the membership check and the decrement.
+     *
+     * @param  o Object to delete
+     * @return true if the object was present and deleted; false otherwise.
+     */
     virtual bool Delete(T const& o) {
-        if(Query(o)){
-            for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-                m_bitarray[super::ComputeHash(o, i)] -= 1;
-            }
-            return true;
-        }
-        return false;
+        return DeleteKey(o);
+    }
+    
+    /** Deletes an object given by an equivalent key type.
+     *  @see CountingBloomFilter::Delete
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Delete(K const& key) {
+        return DeleteKey(key);
+    }
+    
+    /** Deletes an object by its precomputed digest.
+     *  @see CountingBloomFilter::Delete
+     */
+    bool DeleteHash(uint64_t digest) {
+        return DeleteKey(HashDigest{digest});
     }
     
     virtual bool Query(T const& o) const {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            if(m_bitarray[super::ComputeHash(o, i)] == 0){
-                return false;
-            }
+        return QueryKey(o);
+    }
+    
+    /** Queries for an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+    
+    /** Queries for an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::QueryHash
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+    
+    /** Returns an upper bound on the number of times an object was
+     *  inserted, less the number of times it was deleted: the minimum of
+     *  its counters. Zero means the object is absent.
+     *
+     *  @param  o Object to count
+     *  @return Estimated count, at most 255
+     */
+    uint8_t Count(T const& o) const {
+        return CountKey(o);
+    }
+    
+    /** Counts an object given by an equivalent key type.
+     *  @see CountingBloomFilter::Count
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    uint8_t Count(K const& key) const {
+        return CountKey(key);
+    }
+    
+    /** Counts an object by its precomputed digest.
+     *  @see CountingBloomFilter::Count
+     */
+    uint8_t CountHash(uint64_t digest) const {
+        return CountKey(HashDigest{digest});
+    }
+    
+    /** Counts a batch of objects. All counter indexes of a group of objects
+     *  are computed and prefetched before any counter is read, so that the
+     *  memory accesses of different objects overlap.
+     *
+     *  @param objects Objects to count
+     *  @param n       Number of objects
+     *  @param counts  Output array receiving Count(objects[i]) at index i
+     */
+    void CountBatch(T const *objects, size_t n, uint8_t *counts) const {
+        CountKeys(n, [objects](size_t i) -> T const& { return objects[i]; }, counts);
+    }
+    
+    /** Counts a batch of objects by their precomputed digests.
+     *  @see CountingBloomFilter::CountBatch
+     */
+    void CountHashBatch(uint64_t const *digests, size_t n, uint8_t *counts) const {
+        CountKeys(n, [digests](size_t i){ return HashDigest{digests[i]}; }, counts);
+    }
+    
+    /** Returns the cells with the largest counters, for finding heavy
+     *  hitters: the objects inserted most often are those whose counters
+     *  are all among the top cells.
+     *
+     *  @param  n Maximum number of cells to return
+     *  @return (index, counter) pairs of the n largest nonzero counters,
+     *          largest first, and in increasing index order among equal
+     *          counters
+     */
+    std::vector<std::pair<uint16_t, uint8_t>> TopCells(size_t n) const {
+        if(n == 0){
+            return {};
         }
-        return true;
+        std::vector<uint64_t> hist = GetCounterHistogram();
+        
+        // smallest counter value which must be reported
+        unsigned threshold = 256;
+        size_t above = 0;
+        while(threshold > 1 && above < n){
+            above += hist[--threshold];
+        }
+        
+        std::vector<uint32_t> cells(m_bitarray.size());
+        cells.resize(simd::FindAtLeast(m_bitarray.data(), m_bitarray.size(), threshold, cells.data()));
+        std::stable_sort(cells.begin(), cells.end(), [this](uint32_t a, uint32_t b){
+            return m_bitarray[a] > m_bitarray[b];
+        });
+        
+        std::vector<std::pair<uint16_t, uint8_t>> res;
+        for(size_t i = 0; i < cells.size() && i < n; i++){
+            res.emplace_back(cells[i], m_bitarray[cells[i]]);
+        }
+        return res;
+    }
+    
+    /** Returns the number of counters holding each value
+     *
+     *  @return Histogram of 256 entries, indexed by counter value
+     */
+    std::vector<uint64_t> GetCounterHistogram() const {
+        std::vector<uint64_t> hist(256, 0);
+        simd::Histogram(m_bitarray.data(), m_bitarray.size(), hist.data());
+        return hist;
     }
     
     virtual void Serialize(std::ostream &os) const {
@@ -106,18 +310,259 @@ public:
      *  @return The new OrdinaryBloomFilter
      */
     OrdinaryBloomFilter<T> ToOrdinaryBloomFilter() const {
-        OrdinaryBloomFilter<T> res(super::GetNumHashes(), super::GetNumBits());
-        for(int i = 0; i < super::GetNumBits(); i++){
-            res.m_bitarray[i] = m_bitarray[i] > 0;
+        OrdinaryBloomFilter<T> res(super::GetNumHashes(), super::GetNumBits(), GetAllocationPolicy());
+        simd::CountersToBits(m_bitarray.data(), m_bitarray.size(), res.m_words.data());
+        for(size_t i = 0; i < res.m_words.size(); i++){
+            if(res.m_words[i]){
+                res.MarkDirty(i);
+            }
         }
         return res;
     }
     
+    /** Update this Bloom filter by adding the counters of a second one
+     *  with the same geometry, so that it represents the multiset union of
+     *  both. Counters saturate at 255; a saturated counter no longer tracks
+     *  deletions exactly.
+     *
+     *  @param other      BF to add into this one
+     *  @param numThreads Number of threads to split the counter array across
+     */
+    void Add(CountingBloomFilter<T> const& other, unsigned numThreads = 1){
+        ForEachRange(numThreads, [&](size_t begin, size_t end){
+            simd::SaturatingAdd(m_bitarray.data() + begin, other.m_bitarray.data() + begin, end - begin);
+        });
+    }
+    
+    /** Update this Bloom filter by subtracting the counters of a second one
+     *  with the same geometry, e.g. to remove a batch of objects which was
+     *  previously added. Counters saturate at 0.
+     *
+     *  @param other      BF to subtract from this one
+     *  @param numThreads Number of threads to split the counter array across
+     */
+    void Subtract(CountingBloomFilter<T> const& other, unsigned numThreads = 1){
+        ForEachRange(numThreads, [&](size_t begin, size_t end){
+            simd::SaturatingSubtract(m_bitarray.data() + begin, other.m_bitarray.data() + begin, end - begin);
+        });
+    }
+    
+    /** Update this Bloom filter by taking the elementwise minimum of its
+     *  counters and those of a second one with the same geometry. The
+     *  result indexes the objects present in both BFs, plus any new false
+     *  positives.
+     *
+     *  @param other      BF to intersect with this one
+     *  @param numThreads Number of threads to split the counter array across
+     */
+    void Intersect(CountingBloomFilter<T> const& other, unsigned numThreads = 1){
+        ForEachRange(numThreads, [&](size_t begin, size_t end){
+            simd::Minimum(m_bitarray.data() + begin, other.m_bitarray.data() + begin, end - begin);
+        });
+    }
+    
+    template <typename BF>
+    friend class PersistentBloomFilter;
+    
 private:
     
     typedef AbstractDeletableBloomFilter<T> super;
     
-    std::vector<uint8_t> m_bitarray;
+    /** Number of objects whose counters are prefetched together by the
+     *  batch operations
+     */
+    static constexpr size_t BatchSize = 16;
+    
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::Counting);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            uint8_t &c = m_bitarray[super::ComputeHash(key, i)];
+            c += c != 255;
+        }
+    }
+    
+    template <typename K>
+    void InsertConservativeKey(K const& key) {
+        stats::RecordInsert(stats::Counting);
+        uint16_t indexes[256];
+        uint8_t min = 255;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            indexes[i] = super::ComputeHash(key, i);
+            min = std::min(min, m_bitarray[indexes[i]]);
+        }
+        if(min == 255){
+            return;
+        }
+        // a counter shared by two of the hashes is only incremented once
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(m_bitarray[indexes[i]] == min){
+                m_bitarray[indexes[i]] = min + 1;
+            }
+        }
+    }
+    
+    template <typename K>
+    bool DeleteKey(K const& key) {
+        uint16_t indexes[256];
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            indexes[i] = super::ComputeHash(key, i);
+            if(m_bitarray[indexes[i]] == 0){
+                stats::RecordDelete(stats::Counting, false);
+                return false;
+            }
+        }
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            uint8_t &c = m_bitarray[indexes[i]];
+            c -= c != 255;
+        }
+        stats::RecordDelete(stats::Counting, true);
+        return true;
+    }
+    
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(m_bitarray[super::ComputeHash(key, i)] == 0){
+                stats::RecordQuery(stats::Counting, i + 1, false);
+                return false;
+            }
+        }
+        stats::RecordQuery(stats::Counting, super::GetNumHashes(), true);
+        return true;
+    }
+    
+    template <typename K>
+    uint8_t CountKey(K const& key) const {
+        uint8_t min = 255;
+        for(uint8_t i = 0; i < super::GetNumHashes() && min; i++){
+            min = std::min(min, m_bitarray[super::ComputeHash(key, i)]);
+        }
+        return min;
+    }
+    
+    /** Counts n objects, where key(i) returns the i-th object or digest.
+     */
+    template <typename F>
+    void CountKeys(size_t n, F key, uint8_t *counts) const {
+        uint8_t numHashes = super::GetNumHashes();
+        std::vector<uint16_t> indexes(BatchSize * numHashes);
+        for(size_t base = 0; base < n; base += BatchSize){
+            size_t m = std::min(BatchSize, n - base);
+            for(size_t j = 0; j < m; j++){
+                auto const& k = key(base + j);
+                for(uint8_t i = 0; i < numHashes; i++){
+                    uint16_t idx = super::ComputeHash(k, i);
+                    indexes[j * numHashes + i] = idx;
+                    __builtin_prefetch(&m_bitarray[idx]);
+                }
+            }
+            for(size_t j = 0; j < m; j++){
+                uint8_t min = 255;
+                for(uint8_t i = 0; i < numHashes; i++){
+                    min = std::min(min, m_bitarray[indexes[j * numHashes + i]]);
+                }
+                counts[base + j] = min;
+            }
+        }
+    }
+    
+    /** Computes the counter indexes of an object, for the index-level
+     *  operations used by PersistentBloomFilter.
+     */
+    void ComputeIndexes(T const& o, uint16_t *indexes) const {
+        ComputeIndexesOf(o, indexes);
+    }
+    
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void ComputeIndexes(K const& key, uint16_t *indexes) const {
+        ComputeIndexesOf(key, indexes);
+    }
+    
+    template <typename K>
+    void ComputeIndexesOf(K const& key, uint16_t *indexes) const {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            indexes[i] = super::ComputeHash(key, i);
+        }
+    }
+    
+    /** Inserts an object given by its counter indexes.
+     */
+    void InsertIndexes(uint16_t const *indexes) {
+        stats::RecordInsert(stats::Counting);
+        ReplayInsert(indexes, 0, 1);
+    }
+    
+    /** Deletes an object given by its counter indexes.
+     *
+     *  @return true if the object was present and deleted; false otherwise.
+     */
+    bool DeleteIndexes(uint16_t const *indexes) {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(m_bitarray[indexes[i]] == 0){
+                stats::RecordDelete(stats::Counting, false);
+                return false;
+            }
+        }
+        ReplayDelete(indexes, 0, 1);
+        stats::RecordDelete(stats::Counting, true);
+        return true;
+    }
+    
+    /** Increments the counters at the given indexes which lie in blocks of
+     *  64 counters numbered part modulo numParts. Each counter depends only
+     *  on the updates applied to it, in order, so numParts threads can each
+     *  replay the same sequence of updates for their part, without sharing
+     *  a cache line, and reach the state of a sequential replay.
+     */
+    void ReplayInsert(uint16_t const *indexes, unsigned part, unsigned numParts) {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(indexes[i] / 64 % numParts == part){
+                uint8_t &c = m_bitarray[indexes[i]];
+                c += c != 255;
+            }
+        }
+    }
+    
+    /** Decrements the counters at the given indexes which lie in the given
+     *  part, for a deletion which is known to have succeeded.
+     *  @see CountingBloomFilter::ReplayInsert
+     */
+    void ReplayDelete(uint16_t const *indexes, unsigned part, unsigned numParts) {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(indexes[i] / 64 % numParts == part){
+                uint8_t &c = m_bitarray[indexes[i]];
+                c -= c != 255;
+            }
+        }
+    }
+    
+    /** Splits the counter array into numThreads contiguous ranges and
+     *  calls f(begin, end) on each, using one thread per range. The calling
+     *  thread handles the first range.
+     */
+    template <typename F>
+    void ForEachRange(unsigned numThreads, F f) const {
+        size_t n = m_bitarray.size();
+        if(numThreads < 2 || n < numThreads){
+            f(0, n);
+            return;
+        }
+        
+        // keep ranges on 64-byte boundaries so threads never share a line
+        size_t step = (n / numThreads + 63) / 64 * 64;
+        std::vector<std::thread> threads;
+        for(size_t begin = step; begin < n; begin += step){
+            size_t end = begin + step < n ? begin + step : n;
+            threads.emplace_back(f, begin, end);
+        }
+        f(0, step < n ? step : n);
+        for(std::thread &t : threads){
+            t.join();
+        }
+    }
+    
+    std::vector<uint8_t, PageAllocator<uint8_t>> m_bitarray;
     
 
 }; // class CountingBloomFilter
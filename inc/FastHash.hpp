@@ -0,0 +1,204 @@
+#ifndef FastHash_hpp
+#define FastHash_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+
+namespace bloom {
+
+template <typename T>
+struct HashParams;
+
+/** Class implementing a fast 64-bit hash of a byte buffer, built from the
+ *  XXH64 round and avalanche functions. Input is consumed eight bytes at a
+ *  time; unlike FnvHash32 the whole buffer must be passed at once.
+ */
+class FastHash64 {
+
+public:
+
+    static const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    static const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+    static const uint64_t Prime3 = 0x165667B19E3779F9ull;
+    static const uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+    static const uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+    /** Hashes a buffer.
+     *
+     *  @param buf  Buffer of bytes to hash
+     *  @param len  Number of bytes in buffer
+     *  @param seed Seed, such as a Bloom filter salt
+     *  @return Raw hash digest, 64 bits
+     */
+    static uint64_t Hash(const void *buf, size_t len, uint64_t seed){
+        const uint8_t *p = static_cast<const uint8_t *>(buf);
+        uint64_t h = seed + Prime5 + len;
+        for(; len >= 8; p += 8, len -= 8){
+            h ^= Round(0, Read<uint64_t>(p));
+            h = Rotl(h, 27) * Prime1 + Prime4;
+        }
+        if(len >= 4){
+            h ^= Read<uint32_t>(p) * Prime1;
+            h = Rotl(h, 23) * Prime2 + Prime3;
+            p += 4;
+            len -= 4;
+        }
+        for(; len > 0; p++, len--){
+            h ^= *p * Prime5;
+            h = Rotl(h, 11) * Prime1;
+        }
+        return Avalanche(h);
+    }
+
+    /** Mixes a further 64-bit value into a hash, for hashing composite
+     *  objects element by element.
+     */
+    static uint64_t Combine(uint64_t h, uint64_t v){
+        h ^= Round(0, v);
+        return Avalanche(Rotl(h, 27) * Prime1 + Prime4);
+    }
+
+private:
+
+    template <typename U>
+    static U Read(const uint8_t *p){
+        U v;
+        std::memcpy(&v, p, sizeof(U));
+        return v;
+    }
+
+    static uint64_t Rotl(uint64_t x, unsigned r){
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t Round(uint64_t acc, uint64_t v){
+        acc += v * Prime2;
+        return Rotl(acc, 31) * Prime1;
+    }
+
+    static uint64_t Avalanche(uint64_t h){
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct IsContiguousRange : std::false_type {};
+
+template <typename T>
+struct IsContiguousRange<T, decltype((void) std::data(std::declval<T const&>()),
+                                     (void) std::size(std::declval<T const&>()))>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct IsTupleLike : std::false_type {};
+
+template <typename T>
+struct IsTupleLike<T, decltype((void) std::tuple_size<T>::value)> : std::true_type {};
+
+template <typename T>
+struct IsCharPointer
+    : std::integral_constant<bool, std::is_pointer<T>::value
+                                   && std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, char>::value> {};
+
+template <typename U>
+uint64_t HashElement(U const& o, uint8_t salt){
+    return std::hash<HashParams<U>>{}(HashParams<U>{o, salt});
+}
+
+template <typename T, size_t... I>
+uint64_t HashTuple(T const& o, uint8_t salt, std::index_sequence<I...>){
+    uint64_t h = FastHash64::Hash(nullptr, 0, salt);
+    ((h = FastHash64::Combine(h, HashElement(std::get<I>(o), salt))), ...);
+    return h;
+}
+
+} // namespace detail
+
+/** Default hash of an object with a salt, used by the std::hash
+ *  specialization for HashParams<T> unless it is specialized for T by the
+ *  user. Supported types are, in order of precedence:
+ *
+ *  - C strings (char pointers), hashed by their characters
+ *  - contiguous ranges such as std::string, std::string_view,
+ *    std::vector and arrays, hashed by their bytes if the element type
+ *    is hashed by its bytes and element by element otherwise. A
+ *    std::string and a std::string_view with the same characters have
+ *    the same hash, so they can be used for heterogeneous lookups.
+ *  - trivially copyable types without padding, such as integers, enums,
+ *    and packed structs of those, hashed by their bytes
+ *  - float and double, with -0 hashed as +0
+ *  - tuple-like types such as std::pair and std::tuple, hashed element by
+ *    element
+ *
+ *  Elements of ranges and tuples are hashed with std::hash<HashParams<U>>,
+ *  so user specializations for element types are respected.
+ *
+ *  @param T Type being hashed
+ */
+template <typename T>
+struct DefaultHash {
+
+    uint64_t operator()(T const& o, uint8_t salt) const {
+        if constexpr (detail::IsCharPointer<T>::value){
+            return FastHash64::Hash(o, std::strlen(o), salt);
+        }
+        else if constexpr (detail::IsContiguousRange<T>::value){
+            typedef typename std::remove_cv<typename std::remove_reference<decltype(*std::data(o))>::type>::type U;
+            if constexpr (IsBytewise<U>()){
+                return FastHash64::Hash(std::data(o), std::size(o) * sizeof(U), salt);
+            }
+            else {
+                uint64_t h = FastHash64::Hash(nullptr, 0, salt + std::size(o));
+                for(U const& e : o){
+                    h = FastHash64::Combine(h, detail::HashElement(e, salt));
+                }
+                return h;
+            }
+        }
+        else if constexpr (IsBytewise<T>()){
+            return FastHash64::Hash(&o, sizeof(T), salt);
+        }
+        else if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value){
+            T v = o == 0 ? T(0) : o;
+            return FastHash64::Hash(&v, sizeof(T), salt);
+        }
+        else if constexpr (detail::IsTupleLike<T>::value){
+            return detail::HashTuple(o, salt, std::make_index_sequence<std::tuple_size<T>::value>());
+        }
+        else {
+            static_assert(detail::IsTupleLike<T>::value,
+                          "No default hash for this type: specialize std::hash<bloom::HashParams<T>>");
+            return 0;
+        }
+    }
+
+private:
+
+    /** Returns true if equal objects of type U have equal bytes
+     */
+    template <typename U>
+    static constexpr bool IsBytewise(){
+        return std::is_trivially_copyable<U>::value
+            && std::has_unique_object_representations<U>::value
+            && !detail::IsCharPointer<U>::value;
+    }
+
+};
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,841 @@
+#ifndef FilterService_hpp
+#define FilterService_hpp
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <variant>
+#include <stdexcept>
+#include <string_view>
+#include <shared_mutex>
+#include <system_error>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "AbstractDeletableBloomFilter.hpp"
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+
+namespace bloom {
+
+/** Binary protocol spoken between FilterServer and RemoteBloomFilter over a
+ *  Unix domain socket. All integers are in native byte order, as both ends
+ *  run on the same host.
+ *
+ *  A request is a uint32 length, counting the bytes which follow it, a
+ *  uint32 tag, a uint8 op, a uint32 filter handle and an op-specific
+ *  payload. A response is a uint32 length, the tag of the request, a uint8
+ *  status and an op-specific payload. Requests on one connection are
+ *  answered in order, so a client may send any number of them before
+ *  reading the responses.
+ *
+ *  Keys are encoded as a uint32 count followed by, for each key, a uint32
+ *  length and that many bytes.
+ */
+namespace protocol {
+
+enum Op : uint8_t {
+    Open = 1,       //!< Payload: name. Response: uint32 handle, uint8 kind, uint8 hashes, uint16 bits
+    Insert = 2,     //!< Payload: keys. Response: nothing
+    Query = 3,      //!< Payload: keys. Response: one byte per key
+    Delete = 4,     //!< Payload: keys. Response: one byte per key
+    Serialize = 5   //!< Payload: nothing. Response: the filter in its Serialize format
+};
+
+enum Status : uint8_t {
+    Ok = 0,
+    NotFound = 1,       //!< No filter of that name or handle
+    NotSupported = 2,   //!< The filter does not support the op
+    BadRequest = 3      //!< Malformed payload or unknown op
+};
+
+/** Type of a served filter
+ */
+enum Kind : uint8_t {
+    Ordinary = 0,
+    Counting = 1,
+    Paired = 2
+};
+
+const size_t ResponseHeaderSize = 4 + 4 + 1;
+
+/** Frames longer than this are rejected, and the connection closed
+ */
+const uint32_t MaxFrameSize = uint32_t(64) << 20;
+
+template <typename U>
+void Put(std::string &buf, U value){
+    buf.append((const char *) &value, sizeof(U));
+}
+
+/** Reads a value at the given position of a buffer and advances past it,
+ *  returning false if the buffer is too short
+ */
+template <typename U>
+bool Get(std::string_view buf, size_t &pos, U &value){
+    if(buf.size() - pos < sizeof(U)){
+        return false;
+    }
+    std::memcpy(&value, buf.data() + pos, sizeof(U));
+    pos += sizeof(U);
+    return true;
+}
+
+} // namespace protocol
+
+/** Serves Bloom filters over a Unix domain socket to any number of local
+ *  processes, so that they share one copy of each filter rather than each
+ *  deserializing its own. Clients connect with RemoteBloomFilter.
+ *
+ *  Each worker thread runs its own epoll loop over the listening socket
+ *  and the connections it accepted; the listening socket is registered
+ *  with EPOLLEXCLUSIVE, so a new connection wakes a single worker. Workers
+ *  read whole batches of pipelined requests at a time and answer them in
+ *  one write. Filters are guarded by reader-writer locks, so queries run
+ *  in parallel across workers while insertions and deletions are
+ *  serialized per filter. A connection whose responses back up beyond
+ *  MaxBacklog is neither read from nor has its buffered requests answered
+ *  until they drain.
+ *
+ *  Filters index byte strings, hashed as std::string keys with the
+ *  default hash, so a filter built with OrdinaryBloomFilter<std::string>
+ *  and friends can be served as is if std::hash<HashParams<std::string>>
+ *  was not specialized when it was built. The serialized format does not
+ *  record the hash, so a filter built with a specialized one is served
+ *  without error but misses the keys it holds.
+ */
+class FilterServer {
+
+public:
+
+    typedef OrdinaryBloomFilter<std::string> OrdinaryFilter;
+    typedef CountingBloomFilter<std::string> CountingFilter;
+    typedef PairedBloomFilter<std::string> PairedFilter;
+    typedef std::variant<OrdinaryFilter, CountingFilter, PairedFilter> Filter;
+
+    /** Bytes of unsent responses above which a connection is not read from
+     */
+    static constexpr size_t MaxBacklog = size_t(4) << 20;
+
+    /** Constructor
+     *
+     *  @param socketPath Path of the Unix domain socket to listen on; a file
+     *                    already there is removed by Start()
+     *  @param numThreads Number of worker threads, by default one per core
+     */
+    explicit
+    FilterServer(std::string const& socketPath, unsigned numThreads = std::thread::hardware_concurrency())
+    : m_socketPath(socketPath)
+    , m_numThreads(numThreads ? numThreads : 1)
+    , m_listenFd(-1)
+    , m_stopFd(-1)
+    {}
+
+    FilterServer(FilterServer const&) = delete;
+    FilterServer &operator=(FilterServer const&) = delete;
+
+    ~FilterServer(){
+        Stop();
+    }
+
+    /** Adds a filter under the given name, replacing any of the same name.
+     *  Filters must be added before Start().
+     */
+    void Add(std::string const& name, Filter filter){
+        auto it = m_names.find(name);
+        if(it != m_names.end()){
+            m_filters[it->second]->bf = std::move(filter);
+            return;
+        }
+        m_names.emplace(name, m_filters.size());
+        m_filters.emplace_back(new Entry{std::move(filter), {}});
+    }
+
+    /** Writes the current state of a filter in its Serialize format. May be
+     *  called while the server is running.
+     *
+     *  @return false if there is no filter of that name
+     */
+    bool Serialize(std::string const& name, std::ostream &os) const {
+        auto it = m_names.find(name);
+        if(it == m_names.end()){
+            return false;
+        }
+        Entry &e = *m_filters[it->second];
+        std::shared_lock<std::shared_mutex> lock(e.lock);
+        std::visit([&](auto const& f){ f.Serialize(os); }, e.bf);
+        return true;
+    }
+
+    /** Binds the socket and starts the worker threads.
+     *
+     *  @throws std::system_error if the socket cannot be set up
+     */
+    void Start(){
+        sockaddr_un addr;
+        if(m_socketPath.size() >= sizeof(addr.sun_path)){
+            throw std::invalid_argument("socket path too long: " + m_socketPath);
+        }
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, m_socketPath.c_str(), m_socketPath.size());
+
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(m_listenFd < 0){
+            Fail("cannot create socket");
+        }
+        unlink(m_socketPath.c_str());
+        if(bind(m_listenFd, (sockaddr *) &addr, sizeof(addr)) != 0){
+            Fail("cannot bind " + m_socketPath);
+        }
+        if(listen(m_listenFd, SOMAXCONN) != 0){
+            Fail("cannot listen on " + m_socketPath);
+        }
+        m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(m_stopFd < 0){
+            Fail("cannot create eventfd");
+        }
+
+        for(unsigned t = 0; t < m_numThreads; t++){
+            int epfd = epoll_create1(EPOLL_CLOEXEC);
+            if(epfd < 0){
+                Fail("cannot create epoll instance");
+            }
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+            ev.data.ptr = &m_listenFd;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, m_listenFd, &ev);
+            ev.events = EPOLLIN;
+            ev.data.ptr = &m_stopFd;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, m_stopFd, &ev);
+            m_workers.emplace_back([this, epfd]{ Run(epfd); });
+        }
+    }
+
+    /** Stops the worker threads, closes every connection and removes the
+     *  socket. Does nothing if the server is not running.
+     */
+    void Stop(){
+        if(m_stopFd >= 0){
+            uint64_t one = 1;
+            (void) !write(m_stopFd, &one, sizeof(one));
+        }
+        for(std::thread &t : m_workers){
+            t.join();
+        }
+        m_workers.clear();
+        if(m_listenFd >= 0){
+            close(m_listenFd);
+            unlink(m_socketPath.c_str());
+            m_listenFd = -1;
+        }
+        if(m_stopFd >= 0){
+            close(m_stopFd);
+            m_stopFd = -1;
+        }
+    }
+
+private:
+
+    struct Entry {
+        Filter bf;
+        mutable std::shared_mutex lock;
+    };
+
+    struct Connection {
+        int fd;
+        uint32_t events;
+        std::string in;
+        std::string out;
+        size_t sent;    //!< Bytes of out already sent
+    };
+
+    [[noreturn]] void Fail(std::string const& what){
+        int err = errno;
+        Stop();
+        throw std::system_error(err, std::generic_category(), what);
+    }
+
+    /** Event loop of one worker
+     */
+    void Run(int epfd){
+        std::unordered_map<int, std::unique_ptr<Connection>> connections;
+        std::vector<std::string_view> keys;
+        epoll_event events[64];
+        bool running = true;
+
+        while(running){
+            int n = epoll_wait(epfd, events, 64, -1);
+            for(int i = 0; i < n; i++){
+                if(events[i].data.ptr == &m_stopFd){
+                    running = false;
+                }
+                else if(events[i].data.ptr == &m_listenFd){
+                    int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if(fd >= 0){
+                        Connection *c = new Connection{fd, EPOLLIN, {}, {}, 0};
+                        connections.emplace(fd, std::unique_ptr<Connection>(c));
+                        epoll_event ev;
+                        ev.events = EPOLLIN;
+                        ev.data.ptr = c;
+                        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+                    }
+                }
+                else {
+                    Connection *c = (Connection *) events[i].data.ptr;
+                    if(!Service(epfd, *c, events[i].events, keys)){
+                        close(c->fd);
+                        connections.erase(c->fd);
+                    }
+                }
+            }
+        }
+
+        for(auto &c : connections){
+            close(c.first);
+        }
+        close(epfd);
+    }
+
+    /** Reads and answers the requests available on a connection, and sends
+     *  as much of the responses as the socket accepts.
+     *
+     *  @return false if the connection should be closed
+     */
+    bool Service(int epfd, Connection &c, uint32_t events, std::vector<std::string_view> &keys){
+        if(events & (EPOLLERR | EPOLLHUP) && !(events & EPOLLIN)){
+            return false;
+        }
+        if(events & EPOLLIN){
+            char buf[65536];
+            // bounded, so that one client cannot hold up the others
+            for(int reads = 0; reads < 64 && c.out.size() - c.sent < MaxBacklog; reads++){
+                ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+                if(r == 0){
+                    return false;
+                }
+                if(r < 0){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    if(errno == EAGAIN || errno == EWOULDBLOCK){
+                        break;
+                    }
+                    return false;
+                }
+                c.in.append(buf, r);
+                if(!HandleFrames(c, keys)){
+                    return false;
+                }
+            }
+        }
+
+        for(;;){
+            while(c.sent < c.out.size()){
+                ssize_t w = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+                if(w < 0){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    if(errno == EAGAIN || errno == EWOULDBLOCK){
+                        break;
+                    }
+                    return false;
+                }
+                c.sent += w;
+            }
+            if(c.sent == c.out.size()){
+                c.out.clear();
+                c.sent = 0;
+            }
+            // answer the requests left unparsed while the backlog was full
+            size_t unparsed = c.in.size();
+            if(c.out.size() - c.sent >= MaxBacklog || unparsed < sizeof(uint32_t)){
+                break;
+            }
+            if(!HandleFrames(c, keys)){
+                return false;
+            }
+            if(c.in.size() == unparsed){
+                break;
+            }
+        }
+
+        uint32_t want = (c.out.size() - c.sent < MaxBacklog ? EPOLLIN : 0) | (c.sent < c.out.size() ? EPOLLOUT : 0);
+        if(want != c.events){
+            epoll_event ev;
+            ev.events = want;
+            ev.data.ptr = &c;
+            epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+            c.events = want;
+        }
+        return true;
+    }
+
+    /** Answers the complete requests at the start of the input buffer,
+     *  stopping once the responses not yet sent exceed MaxBacklog, and
+     *  leaves the rest in the buffer.
+     *
+     *  @return false if a request is too long to be accepted
+     */
+    bool HandleFrames(Connection &c, std::vector<std::string_view> &keys){
+        size_t pos = 0;
+        while(c.in.size() - pos >= sizeof(uint32_t) && c.out.size() - c.sent < MaxBacklog){
+            uint32_t len;
+            std::memcpy(&len, c.in.data() + pos, sizeof(uint32_t));
+            if(len > protocol::MaxFrameSize){
+                return false;
+            }
+            if(c.in.size() - pos - sizeof(uint32_t) < len){
+                break;
+            }
+            Handle(std::string_view(c.in.data() + pos + sizeof(uint32_t), len), c.out, keys);
+            pos += sizeof(uint32_t) + len;
+        }
+        c.in.erase(0, pos);
+        return true;
+    }
+
+    /** Answers one request, appending the response to out
+     */
+    void Handle(std::string_view request, std::string &out, std::vector<std::string_view> &keys) const {
+        size_t pos = 0;
+        uint32_t tag = 0, handle = 0;
+        uint8_t op = 0;
+        protocol::Get(request, pos, tag);
+        size_t start = out.size();
+        protocol::Put(out, uint32_t(0));
+        protocol::Put(out, tag);
+        protocol::Put(out, uint8_t(protocol::Ok));
+
+        uint8_t status = protocol::Ok;
+        if(!protocol::Get(request, pos, op) || !protocol::Get(request, pos, handle)){
+            status = protocol::BadRequest;
+        }
+        else if(op == protocol::Open){
+            auto it = m_names.find(std::string(request.substr(pos)));
+            if(it == m_names.end()){
+                status = protocol::NotFound;
+            } else {
+                Filter const& bf = m_filters[it->second]->bf;
+                protocol::Put(out, uint32_t(it->second));
+                protocol::Put(out, uint8_t(bf.index()));
+                std::visit([&](auto const& f){
+                    protocol::Put(out, f.GetNumHashes());
+                    protocol::Put(out, f.GetNumBits());
+                }, bf);
+            }
+        }
+        else if(handle >= m_filters.size()){
+            status = protocol::NotFound;
+        }
+        else if(op == protocol::Serialize){
+            Entry &e = *m_filters[handle];
+            std::ostringstream os;
+            {
+                std::shared_lock<std::shared_mutex> lock(e.lock);
+                std::visit([&](auto const& f){ f.Serialize(os); }, e.bf);
+            }
+            out += os.str();
+        }
+        else if(op == protocol::Insert || op == protocol::Query || op == protocol::Delete){
+            if(!ParseKeys(request, pos, keys)){
+                status = protocol::BadRequest;
+            } else {
+                status = Apply(*m_filters[handle], op, keys, out);
+            }
+        }
+        else {
+            status = protocol::BadRequest;
+        }
+
+        if(status != protocol::Ok){
+            out.resize(start + protocol::ResponseHeaderSize);
+            out[start + protocol::ResponseHeaderSize - 1] = status;
+        }
+        uint32_t len = out.size() - start - sizeof(uint32_t);
+        std::memcpy(&out[start], &len, sizeof(uint32_t));
+    }
+
+    /** Splits the keys of a request, checking that they lie within it
+     */
+    static bool ParseKeys(std::string_view request, size_t pos, std::vector<std::string_view> &keys){
+        uint32_t count;
+        if(!protocol::Get(request, pos, count) || count > (request.size() - pos) / sizeof(uint32_t)){
+            return false;
+        }
+        keys.clear();
+        for(uint32_t i = 0; i < count; i++){
+            uint32_t len;
+            if(!protocol::Get(request, pos, len) || request.size() - pos < len){
+                return false;
+            }
+            keys.push_back(request.substr(pos, len));
+            pos += len;
+        }
+        return pos == request.size();
+    }
+
+    static uint8_t Apply(Entry &e, uint8_t op, std::vector<std::string_view> const& keys, std::string &out){
+        if(op == protocol::Query){
+            std::shared_lock<std::shared_mutex> lock(e.lock);
+            std::visit([&](auto const& f){
+                for(std::string_view k : keys){
+                    out.push_back(f.Query(k));
+                }
+            }, e.bf);
+            return protocol::Ok;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(e.lock);
+        return std::visit([&](auto &f) -> uint8_t {
+            if(op == protocol::Insert){
+                for(std::string_view k : keys){
+                    f.Insert(k);
+                }
+                return protocol::Ok;
+            }
+            if constexpr (std::is_same<std::decay_t<decltype(f)>, OrdinaryFilter>::value){
+                return protocol::NotSupported;
+            } else {
+                for(std::string_view k : keys){
+                    out.push_back(f.Delete(k));
+                }
+                return protocol::Ok;
+            }
+        }, e.bf);
+    }
+
+    std::string m_socketPath;
+    unsigned m_numThreads;
+    int m_listenFd;
+
+    /** Readable once Stop() is called, waking every worker
+     */
+    int m_stopFd;
+
+    std::vector<std::unique_ptr<Entry>> m_filters;
+
+    /** Index in m_filters of each filter, which is its handle
+     */
+    std::unordered_map<std::string, size_t> m_names;
+
+    std::vector<std::thread> m_workers;
+
+}; // class FilterServer
+
+/** A filter served by a FilterServer, used through the usual Bloom filter
+ *  interface. Each instance holds its own connection to the server, so it
+ *  must not be used from several threads at once; open one per thread.
+ *
+ *  Single operations cost a round trip to the server. The batch
+ *  operations split the keys into requests of at most BatchSize keys and
+ *  keep up to Window of them in flight, so that the server is busy with
+ *  one request while the client sends the next and reads the previous
+ *  one's response.
+ */
+class RemoteBloomFilter : public AbstractDeletableBloomFilter<std::string> {
+
+public:
+
+    /** Maximum number of keys per request of a batch operation
+     */
+    static constexpr size_t BatchSize = 1024;
+
+    /** Maximum number of requests of a batch operation in flight
+     */
+    static constexpr size_t Window = 16;
+
+    /** Constructor: connects to a server and opens one of its filters.
+     *
+     *  @param socketPath Path of the server's socket
+     *  @param name       Name of the filter
+     *  @throws std::system_error if the server cannot be reached
+     *  @throws std::invalid_argument if the server has no such filter
+     */
+    explicit
+    RemoteBloomFilter(std::string const& socketPath, std::string const& name)
+    : RemoteBloomFilter(Connect(socketPath, name))
+    {}
+
+    RemoteBloomFilter(RemoteBloomFilter const&) = delete;
+    RemoteBloomFilter &operator=(RemoteBloomFilter const&) = delete;
+
+    virtual ~RemoteBloomFilter(){
+        close(m_session.fd);
+    }
+
+    /** Returns the type of the served filter
+     */
+    protocol::Kind GetKind() const {
+        return m_session.kind;
+    }
+
+    virtual void Insert(std::string const& o) {
+        InsertBatch(&o, &o + 1);
+    }
+
+    virtual bool Query(std::string const& o) const {
+        uint8_t result;
+        QueryBatch(&o, &o + 1, &result);
+        return result;
+    }
+
+    /** @throws std::invalid_argument if the served filter is an ordinary BF
+     */
+    virtual bool Delete(std::string const& o) {
+        uint8_t result;
+        DeleteBatch(&o, &o + 1, &result);
+        return result;
+    }
+
+    /** Inserts the keys in [first, last), which may be std::string or
+     *  std::string_view objects.
+     */
+    template <typename It>
+    void InsertBatch(It first, It last) {
+        Batch(protocol::Insert, first, last, nullptr);
+    }
+
+    /** Queries the keys in [first, last), setting results[i] to 1 for the
+     *  i-th key if it may be present and to 0 otherwise.
+     */
+    template <typename It>
+    void QueryBatch(It first, It last, uint8_t *results) const {
+        Batch(protocol::Query, first, last, results);
+    }
+
+    /** Deletes the keys in [first, last), setting results[i] to 1 for the
+     *  i-th key if it was present and deleted and to 0 otherwise.
+     *
+     *  @throws std::invalid_argument if the served filter is an ordinary BF
+     */
+    template <typename It>
+    void DeleteBatch(It first, It last, uint8_t *results) {
+        Batch(protocol::Delete, first, last, results);
+    }
+
+    /** Writes the current state of the served filter in its own Serialize
+     *  format, so that it can be read with the Deserialize of its type.
+     */
+    virtual void Serialize(std::ostream &os) const {
+        std::string request = Header(protocol::Serialize);
+        Finish(request);
+        Send(request);
+        std::string response = Receive(m_session.fd);
+        CheckStatus(response);
+        os.write(response.data() + protocol::ResponseHeaderSize - sizeof(uint32_t),
+                 response.size() - (protocol::ResponseHeaderSize - sizeof(uint32_t)));
+    }
+
+private:
+
+    struct Session {
+        int fd;
+        uint32_t handle;
+        protocol::Kind kind;
+        uint8_t numHashes;
+        uint16_t numBits;
+    };
+
+    explicit
+    RemoteBloomFilter(Session session)
+    : AbstractDeletableBloomFilter<std::string>(session.numHashes, session.numBits)
+    , m_session(session)
+    , m_nextTag(1)
+    {}
+
+    static Session Connect(std::string const& socketPath, std::string const& name){
+        sockaddr_un addr;
+        if(socketPath.size() >= sizeof(addr.sun_path)){
+            throw std::invalid_argument("socket path too long: " + socketPath);
+        }
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+
+        Session s{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0), 0, protocol::Ordinary, 0, 0};
+        if(s.fd < 0){
+            throw std::system_error(errno, std::generic_category(), "cannot create socket");
+        }
+        if(connect(s.fd, (sockaddr *) &addr, sizeof(addr)) != 0){
+            int err = errno;
+            close(s.fd);
+            throw std::system_error(err, std::generic_category(), "cannot connect to " + socketPath);
+        }
+
+        std::string request;
+        protocol::Put(request, uint32_t(0));
+        protocol::Put(request, uint32_t(0));
+        protocol::Put(request, uint8_t(protocol::Open));
+        protocol::Put(request, uint32_t(0));
+        request += name;
+        Finish(request);
+
+        std::string response;
+        uint8_t status = protocol::BadRequest, kind = 0;
+        try {
+            SendAll(s.fd, request);
+            response = Receive(s.fd);
+        } catch(...) {
+            close(s.fd);
+            throw;
+        }
+        size_t pos = sizeof(uint32_t);
+        protocol::Get(response, pos, status);
+        if(status != protocol::Ok || !protocol::Get(response, pos, s.handle) || !protocol::Get(response, pos, kind)
+           || !protocol::Get(response, pos, s.numHashes) || !protocol::Get(response, pos, s.numBits)){
+            close(s.fd);
+            throw std::invalid_argument("no filter named " + name + " on " + socketPath);
+        }
+        s.kind = (protocol::Kind) kind;
+        return s;
+    }
+
+    /** Starts a request, leaving its length to be filled in by Finish
+     */
+    std::string Header(uint8_t op) const {
+        std::string request;
+        protocol::Put(request, uint32_t(0));
+        protocol::Put(request, m_nextTag++);
+        protocol::Put(request, op);
+        protocol::Put(request, m_session.handle);
+        return request;
+    }
+
+    static void Finish(std::string &request){
+        uint32_t len = request.size() - sizeof(uint32_t);
+        std::memcpy(&request[0], &len, sizeof(uint32_t));
+    }
+
+    /** Sends the requests of a batch operation, keeping at most Window
+     *  unanswered, and copies the per-key results of each response
+     */
+    template <typename It>
+    void Batch(uint8_t op, It first, It last, uint8_t *results) const {
+        size_t n = std::distance(first, last);
+        size_t numRequests = (n + BatchSize - 1) / BatchSize;
+        size_t sent = 0;
+        It next = first;
+        uint8_t status = protocol::Ok;
+        for(size_t received = 0; received < numRequests; received++){
+            // after a failure, only drain the requests already in flight
+            while(status == protocol::Ok && sent < numRequests && sent - received < Window){
+                size_t count = std::min(BatchSize, n - sent * BatchSize);
+                std::string request = Header(op);
+                protocol::Put(request, uint32_t(count));
+                for(size_t i = 0; i < count; i++, ++next){
+                    std::string_view key(*next);
+                    protocol::Put(request, uint32_t(key.size()));
+                    request.append(key.data(), key.size());
+                }
+                Finish(request);
+                Send(request);
+                sent++;
+            }
+            if(received == sent){
+                break;
+            }
+
+            std::string response = Receive(m_session.fd);
+            if(status != protocol::Ok || response[sizeof(uint32_t)] != protocol::Ok){
+                status = status != protocol::Ok ? status : response[sizeof(uint32_t)];
+                continue;
+            }
+            if(results){
+                size_t count = std::min(BatchSize, n - received * BatchSize);
+                if(response.size() != protocol::ResponseHeaderSize - sizeof(uint32_t) + count){
+                    throw std::runtime_error("malformed response from filter server");
+                }
+                std::memcpy(results + received * BatchSize,
+                            response.data() + protocol::ResponseHeaderSize - sizeof(uint32_t), count);
+            }
+        }
+        CheckStatus(status);
+    }
+
+    void Send(std::string const& request) const {
+        SendAll(m_session.fd, request);
+    }
+
+    static void SendAll(int fd, std::string const& data){
+        size_t sent = 0;
+        while(sent < data.size()){
+            ssize_t w = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if(w < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "cannot send to filter server");
+            }
+            sent += w;
+        }
+    }
+
+    /** Reads one response, returning it without its length
+     */
+    static std::string Receive(int fd){
+        uint32_t len;
+        RecvAll(fd, (char *) &len, sizeof(uint32_t));
+        if(len < protocol::ResponseHeaderSize - sizeof(uint32_t) || len > protocol::MaxFrameSize){
+            throw std::runtime_error("malformed response from filter server");
+        }
+        std::string response(len, 0);
+        RecvAll(fd, &response[0], len);
+        return response;
+    }
+
+    static void RecvAll(int fd, char *buf, size_t len){
+        while(len > 0){
+            ssize_t r = recv(fd, buf, len, 0);
+            if(r == 0){
+                throw std::system_error(ECONNRESET, std::generic_category(), "filter server closed the connection");
+            }
+            if(r < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "cannot receive from filter server");
+            }
+            buf += r;
+            len -= r;
+        }
+    }
+
+    static void CheckStatus(std::string const& response){
+        CheckStatus(response[sizeof(uint32_t)]);
+    }
+
+    static void CheckStatus(uint8_t status){
+        if(status == protocol::NotSupported){
+            throw std::invalid_argument("operation not supported by the served filter");
+        }
+        if(status != protocol::Ok){
+            throw std::runtime_error("filter server rejected the request");
+        }
+    }
+
+    Session m_session;
+
+    /** Tag of the next request; responses come back in order, so tags only
+     *  serve to tell requests apart when debugging
+     */
+    mutable uint32_t m_nextTag;
+
+}; // class RemoteBloomFilter
+
+} // namespace bloom
+
+#endif
@@ -2,10 +2,12 @@
 #define FnvHash_hpp
 
 #include <cstdint>
+#include <cstddef>
 
 namespace bloom {
 
-/** Class implementing a 32-bit FNV-1 hash.
+/** Class implementing a 32-bit FNV-1 hash. It can be used in constant
+ *  expressions, e.g. to hash the objects of a StaticBloomFilter.
  */
 class FnvHash32 {
 
@@ -16,7 +18,7 @@ public:
 
     /** Constructor: Initializes the FNV hashing algorithm.
      */    
-    FnvHash32()
+    constexpr FnvHash32()
     : m_hash(Offset)
     {}
     
@@ -26,18 +28,32 @@ public:
      *  @param buf Buffer of bytes to hash
      *  @param len Number of bytes in buffer
      */
-    void Update(const uint8_t *buf, size_t len){
+    constexpr void Update(const uint8_t *buf, size_t len){
         for(size_t i = 0; i < len; i++){
             m_hash = m_hash * Prime;
             m_hash = m_hash ^ buf[i];
         }
     }
     
+    /** Consumes characters and updates the hash, as Update on their bytes.
+     *  Unlike a cast to const uint8_t *, this is allowed in constant
+     *  expressions, e.g. for string literals.
+     *
+     *  @param buf Buffer of characters to hash
+     *  @param len Number of characters in buffer
+     */
+    constexpr void Update(const char *buf, size_t len){
+        for(size_t i = 0; i < len; i++){
+            m_hash = m_hash * Prime;
+            m_hash = m_hash ^ uint8_t(buf[i]);
+        }
+    }
+    
     /** Returns the hash digest.
      *  
      *  @return Raw hash digest, 32 bits
      */
-    uint32_t Digest() const {
+    constexpr uint32_t Digest() const {
         return m_hash;
     }
 
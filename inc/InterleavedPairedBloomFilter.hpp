@@ -0,0 +1,269 @@
+#ifndef InterleavedPairedBloomFilter_hpp
+#define InterleavedPairedBloomFilter_hpp
+
+#include <vector>
+#include "AbstractDeletableBloomFilter.hpp"
+#include "Statistics.hpp"
+
+namespace bloom {
+
+/** A paired Bloom filter which stores the positive and negative bit of
+ *  each position together, as a 2-bit cell, instead of in two separate
+ *  arrays. A query then hashes an object once and reads one cell per
+ *  probe, touching at most k cache lines instead of 2k.
+ *
+ *  Apart from the layout, it behaves exactly as PairedBloomFilter, and it
+ *  reads and writes the same serialized format.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class InterleavedPairedBloomFilter : public AbstractDeletableBloomFilter<T> {
+
+public:
+
+    /** Constructor
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     */
+    explicit
+    InterleavedPairedBloomFilter(uint8_t numHashes, uint16_t numBits)
+    : AbstractDeletableBloomFilter<T>(numHashes, numBits)
+    , m_words((numBits + CellsPerWord - 1) / CellsPerWord, 0)
+    {}
+
+    virtual void Insert(T const& o) {
+        InsertKey(o);
+    }
+
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
+    }
+
+    /** Queries whether an object is indexed by this Bloom filter. Both false
+     *  negatives and false positives are possible.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    virtual bool Query(T const& o) const {
+        return QueryKey(o);
+    }
+
+    /** Queries for an object given by an equivalent key type.
+     *  @see InterleavedPairedBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+
+    /** Queries for an object by its precomputed digest.
+     *  @see InterleavedPairedBloomFilter::Query
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+
+    virtual bool Delete(T const& o) {
+        return DeleteKey(o);
+    }
+
+    /** Deletes an object given by an equivalent key type.
+     *  @see AbstractDeletableBloomFilter::Delete
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Delete(K const& key) {
+        return DeleteKey(key);
+    }
+
+    /** Deletes an object by its precomputed digest.
+     *  @see AbstractDeletableBloomFilter::Delete
+     */
+    bool DeleteHash(uint64_t digest) {
+        return DeleteKey(HashDigest{digest});
+    }
+
+    /** Writes this BF in the PairedBloomFilter format: the positive array
+     *  followed by the negative array.
+     *
+     *  @param os output stream to serialize the BF into
+     */
+    virtual void Serialize(std::ostream &os) const {
+        uint8_t numHashes = super::GetNumHashes();
+        uint16_t numBits = super::GetNumBits();
+
+        os.write((const char *) &numHashes, sizeof(uint8_t));
+        os.write((const char *) &numBits, sizeof(uint16_t));
+
+        for(unsigned i = 0; i < (2u * numBits + 7) / 8; i++){
+            uint8_t byte = 0;
+            for(unsigned j = 0; j < 8 && 8 * i + j < 2u * numBits; j++){
+                byte |= GetBit(8 * i + j) << (7 - j);
+            }
+            os.write((const char *) &byte, sizeof(uint8_t));
+        }
+    }
+
+    /** Create an InterleavedPairedBloomFilter from the content of a binary
+     *  input stream in the PairedBloomFilter format, such as one written
+     *  by PairedBloomFilter::Serialize. No validation is performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized InterleavedPairedBloomFilter
+     */
+    static InterleavedPairedBloomFilter<T> Deserialize(std::istream &is){
+        uint8_t numHashes;
+        uint16_t numBits;
+
+        is.read((char *) &numHashes, sizeof(uint8_t));
+        is.read((char *) &numBits, sizeof(uint16_t));
+
+        InterleavedPairedBloomFilter<T> r (numHashes, numBits);
+
+        for(unsigned i = 0; i < (2u * numBits + 7) / 8; i++){
+            uint8_t byte;
+            is.read((char *) &byte, sizeof(uint8_t));
+            for(unsigned j = 0; j < 8 && 8 * i + j < 2u * numBits; j++){
+                if(byte & (1 << (7 - j))){
+                    r.SetBit(8 * i + j);
+                }
+            }
+        }
+
+        return r;
+    }
+
+    /** Update this Bloom filter by adding the contents of a second one.
+     *  As in PairedBloomFilter::Union, the positive bits are combined by
+     *  logical OR and the negative bits by logical AND, a word at a time.
+     *
+     *  @param other new BF to combine into this one
+     */
+    void Union(InterleavedPairedBloomFilter<T> const& other){
+        for(size_t i = 0; i < m_words.size(); i++){
+            uint64_t a = m_words[i];
+            uint64_t b = other.m_words[i];
+            m_words[i] = ((a | b) & PositiveMask) | ((a & b) & ~PositiveMask);
+        }
+    }
+
+private:
+
+    typedef AbstractDeletableBloomFilter<T> super;
+
+    static const unsigned CellsPerWord = 32;
+
+    /** Positive bits of every cell in a word: the even bits
+     */
+    static const uint64_t PositiveMask = 0x5555555555555555ull;
+
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::InterleavedPaired);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            unsigned cell = super::ComputeHash(key, i);
+            m_words[cell / CellsPerWord] |= uint64_t(1) << (2 * (cell % CellsPerWord));
+        }
+    }
+
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        unsigned depth;
+        bool rejected;
+        bool result = TestKey(key, nullptr, depth, rejected);
+        stats::RecordQuery(stats::InterleavedPaired, depth, result);
+        if(rejected){
+            stats::RecordNegativeReject(stats::InterleavedPaired);
+        }
+        return result;
+    }
+
+    /** Tests membership in one pass over the object's cells: the object is
+     *  present if every positive bit is set and some negative bit is
+     *  clear.
+     *
+     *  @param cells    If not null, receives the object's cell indexes
+     *  @param depth    Set to the number of cells examined
+     *  @param rejected Set if all positive bits were set but the object
+     *                  has been deleted
+     */
+    template <typename K>
+    bool TestKey(K const& key, uint16_t *cells, unsigned &depth, bool &rejected) const {
+        rejected = false;
+        bool negative = true;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            uint16_t cell = super::ComputeHash(key, i);
+            if(cells){
+                cells[i] = cell;
+            }
+            unsigned pair = (m_words[cell / CellsPerWord] >> (2 * (cell % CellsPerWord))) & 3;
+            if(!(pair & 1)){
+                depth = i + 1;
+                return false;
+            }
+            negative &= pair >> 1;
+        }
+        depth = super::GetNumHashes();
+        rejected = negative;
+        return !negative;
+    }
+
+    template <typename K>
+    bool DeleteKey(K const& key) {
+        uint16_t cells[256];
+        unsigned depth;
+        bool rejected;
+        if(TestKey(key, cells, depth, rejected)){
+            for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+                m_words[cells[i] / CellsPerWord] |= uint64_t(2) << (2 * (cells[i] % CellsPerWord));
+            }
+            stats::RecordDelete(stats::InterleavedPaired, true);
+            return true;
+        }
+        stats::RecordDelete(stats::InterleavedPaired, false);
+        return false;
+    }
+
+    /** Returns the word index and shift of a bit in the numbering of
+     *  PairedBloomFilter, where bits [0, GetNumBits()) are the positive
+     *  array and bits [GetNumBits(), 2 * GetNumBits()) the negative array.
+     */
+    unsigned ShiftOf(unsigned bit) const {
+        bool negative = bit >= super::GetNumBits();
+        unsigned cell = negative ? bit - super::GetNumBits() : bit;
+        return 2 * (cell % CellsPerWord) + negative;
+    }
+
+    size_t WordOf(unsigned bit) const {
+        return (bit >= super::GetNumBits() ? bit - super::GetNumBits() : bit) / CellsPerWord;
+    }
+
+    bool GetBit(unsigned bit) const {
+        return (m_words[WordOf(bit)] >> ShiftOf(bit)) & 1;
+    }
+
+    void SetBit(unsigned bit) {
+        m_words[WordOf(bit)] |= uint64_t(1) << ShiftOf(bit);
+    }
+
+    /** Cells of 2 bits, 32 per word, least significant first; the low bit
+     *  of a cell is its positive bit and the high bit its negative bit
+     */
+    std::vector<uint64_t> m_words;
+
+}; // class InterleavedPairedBloomFilter
+
+} // namespace bloom
+
+#endif
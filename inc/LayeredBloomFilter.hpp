@@ -0,0 +1,242 @@
+#ifndef LayeredBloomFilter_hpp
+#define LayeredBloomFilter_hpp
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include "AbstractBloomFilter.hpp"
+#include "SimdKernels.hpp"
+#include "Statistics.hpp"
+
+namespace bloom {
+
+/** A Bloom filter which answers queries in two stages: a cheap front stage,
+ *  which rejects most absent objects without touching the backup BF, and
+ *  the backup BF itself, which is consulted only for objects the front
+ *  stage lets through. Both stages must accept an object for it to be
+ *  reported present, so there are no false negatives, and the false
+ *  positive rate is that of the backup BF multiplied by the probability
+ *  that an absent object passes the front stage.
+ *
+ *  The front stage is a small ordinary bit array of its own, intended to
+ *  fit in L1 cache, optionally preceded by a predicate such as a range
+ *  check or a learned model. An object the predicate accepts passes the
+ *  front stage immediately. The front bit array holds the inserted objects
+ *  which the predicate rejects, so the predicate may have false negatives;
+ *  without a predicate, it holds every inserted object.
+ *
+ *  The front bit array hashes objects with salts from FrontSalt upwards, so
+ *  that its false positives are independent of those of the backup BF,
+ *  which must use at most FrontSalt hashes. When the backup BF is itself a
+ *  LayeredBloomFilter, the salts continue after those of its front bit
+ *  array instead, so every layer of a nest probes independently; all the
+ *  front bit arrays of a nest then share the 128 salts from FrontSalt.
+ *
+ *  Copies would share the backup BF but not the front bit array, so a
+ *  LayeredBloomFilter can only be moved.
+ *
+ *  With BLOOM_STATISTICS, queries are recorded with a probe depth of 1 if
+ *  the front stage rejected them and 2 if they reached the backup BF. The
+ *  end-to-end false positive rate can be measured with stats::FprSampler.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class LayeredBloomFilter : public AbstractBloomFilter<T> {
+
+public:
+
+    /** Predicate which returns true for objects which may be present
+     */
+    typedef std::function<bool(T const&)> Predicate;
+
+    /** Salt of the first hash of the front bit array
+     */
+    static const uint8_t FrontSalt = 128;
+
+    /** Constructor
+     *
+     *  @param frontHashes Number of hashes of the front bit array, at most
+     *                     the salts left after those of nested front bit
+     *                     arrays
+     *  @param frontBits   Size of the front bit array
+     *  @param backup      BF consulted for objects passing the front stage;
+     *                     objects inserted into it directly are not seen
+     *                     by the front stage
+     *  @param predicate   Optional predicate evaluated before the front bit
+     *                     array
+     *  @throws std::invalid_argument if the front bit array or the backup BF
+     *          would use salts belonging to the other
+     */
+    explicit
+    LayeredBloomFilter(uint8_t frontHashes, uint16_t frontBits,
+                       std::shared_ptr<AbstractBloomFilter<T>> backup, Predicate predicate = Predicate())
+    : AbstractBloomFilter<T>(backup->GetNumHashes(), backup->GetNumBits())
+    , m_frontHashes(frontHashes)
+    , m_frontBits(frontBits)
+    , m_frontSalt(FirstFreeSalt(*backup))
+    , m_front((frontBits + 63) / 64, 0)
+    , m_backup(std::move(backup))
+    , m_predicate(std::move(predicate))
+    {
+        if(m_frontSalt + frontHashes > 256u){
+            throw std::invalid_argument("too many front hashes for the salts left");
+        }
+        if(m_backup->GetNumHashes() > FrontSalt){
+            throw std::invalid_argument("backup BF uses the salts of the front bit array");
+        }
+    }
+
+    LayeredBloomFilter(LayeredBloomFilter<T> const&) = delete;
+    LayeredBloomFilter<T> &operator=(LayeredBloomFilter<T> const&) = delete;
+    LayeredBloomFilter(LayeredBloomFilter<T> &&) = default;
+    LayeredBloomFilter<T> &operator=(LayeredBloomFilter<T> &&) = default;
+
+    /** Inserts an object into the backup BF, and into the front bit array
+     *  unless the predicate accepts it.
+     *
+     *  @param o Object to insert
+     */
+    virtual void Insert(T const& o) {
+        stats::RecordInsert(stats::Layered);
+        if(!m_predicate || !m_predicate(o)){
+            for(uint8_t i = 0; i < m_frontHashes; i++){
+                unsigned bit = HashIndex(o, m_frontSalt + i, m_frontBits);
+                m_front[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+        m_backup->Insert(o);
+    }
+
+    /** Queries whether an object is indexed by this Bloom filter. Can return
+     *  a false positive, but not a false negative.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    virtual bool Query(T const& o) const {
+        if(!PassesFront(o)){
+            stats::RecordQuery(stats::Layered, 1, false);
+            return false;
+        }
+        bool result = m_backup->Query(o);
+        stats::RecordQuery(stats::Layered, 2, result);
+        return result;
+    }
+
+    /** Returns the probability that an absent object which the predicate
+     *  rejects passes the front bit array, (t / m)^k for t of its m bits
+     *  set.
+     */
+    double GetFrontFalsePositiveRate() const {
+        double setBits = simd::PopCount(m_front.data(), m_front.size());
+        return std::pow(setBits / m_frontBits, m_frontHashes);
+    }
+
+    /** Returns the salt of the first hash of the front bit array
+     */
+    unsigned GetFrontSalt() const {
+        return m_frontSalt;
+    }
+
+    /** Returns the backup BF
+     */
+    std::shared_ptr<AbstractBloomFilter<T>> GetBackup() const {
+        return m_backup;
+    }
+
+    /** Writes the front bit array, in the format of an OrdinaryBloomFilter,
+     *  followed by the backup BF. The predicate is not written.
+     *
+     *  @param os output stream to serialize the BF into
+     */
+    virtual void Serialize(std::ostream &os) const {
+        os.write((const char *) &m_frontHashes, sizeof(uint8_t));
+        os.write((const char *) &m_frontBits, sizeof(uint16_t));
+
+        for(unsigned i = 0; i < (m_frontBits + 7u) / 8; i++){
+            uint8_t byte = 0;
+            for(unsigned j = 0; j < 8 && 8 * i + j < m_frontBits; j++){
+                byte |= ((m_front[(8 * i + j) / 64] >> ((8 * i + j) % 64)) & 1) << (7 - j);
+            }
+            os.write((const char *) &byte, sizeof(uint8_t));
+        }
+
+        m_backup->Serialize(os);
+    }
+
+    /** Create a LayeredBloomFilter from the content of a binary input
+     *  stream. No validation is performed.
+     *
+     *  @param  Backup    Type of the backup BF, which is read with
+     *                    Backup::Deserialize
+     *  @param  is        Input stream to read from
+     *  @param  predicate Predicate the BF was built with, if any
+     *  @return Deserialized LayeredBloomFilter
+     */
+    template <typename Backup>
+    static LayeredBloomFilter<T> Deserialize(std::istream &is, Predicate predicate = Predicate()){
+        uint8_t frontHashes;
+        uint16_t frontBits;
+
+        is.read((char *) &frontHashes, sizeof(uint8_t));
+        is.read((char *) &frontBits, sizeof(uint16_t));
+
+        std::vector<uint64_t> front((frontBits + 63) / 64, 0);
+        for(unsigned i = 0; i < (frontBits + 7u) / 8; i++){
+            uint8_t byte;
+            is.read((char *) &byte, sizeof(uint8_t));
+            for(unsigned j = 0; j < 8 && 8 * i + j < frontBits; j++){
+                if(byte & (1 << (7 - j))){
+                    front[(8 * i + j) / 64] |= uint64_t(1) << ((8 * i + j) % 64);
+                }
+            }
+        }
+
+        LayeredBloomFilter<T> r(frontHashes, frontBits, std::make_shared<Backup>(Backup::Deserialize(is)),
+                                std::move(predicate));
+        r.m_front = std::move(front);
+        return r;
+    }
+
+private:
+
+    /** Returns the first salt which no front bit array nested in a backup
+     *  BF uses
+     */
+    static unsigned FirstFreeSalt(AbstractBloomFilter<T> const& backup){
+        auto nested = dynamic_cast<LayeredBloomFilter<T> const *>(&backup);
+        return nested ? nested->m_frontSalt + nested->m_frontHashes : FrontSalt;
+    }
+
+    bool PassesFront(T const& o) const {
+        if(m_predicate && m_predicate(o)){
+            return true;
+        }
+        for(uint8_t i = 0; i < m_frontHashes; i++){
+            unsigned bit = HashIndex(o, m_frontSalt + i, m_frontBits);
+            if(!((m_front[bit / 64] >> (bit % 64)) & 1)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint8_t m_frontHashes;
+    uint16_t m_frontBits;
+    unsigned m_frontSalt;
+
+    /** Front bit array, packed least significant bit first
+     */
+    std::vector<uint64_t> m_front;
+
+    std::shared_ptr<AbstractBloomFilter<T>> m_backup;
+    Predicate m_predicate;
+
+}; // class LayeredBloomFilter
+
+} // namespace bloom
+
+#endif
@@ -1,8 +1,16 @@
 #ifndef OrdinaryBloomFilter_hpp
 #define OrdinaryBloomFilter_hpp
 
+#include <cmath>
 #include <vector>
+#include <thread>
+#include <algorithm>
 #include "AbstractBloomFilter.hpp"
+#include "PageAllocator.hpp"
+#include "BulkBuild.hpp"
+#include "SimdKernels.hpp"
+#include "Statistics.hpp"
+#include "WordDelta.hpp"
 
 // forward decl
 namespace bloom {
@@ -26,30 +34,98 @@ public:
 
     /** Constructor
      *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @param policy How to allocate the storage of this BF
      */
     explicit
-    OrdinaryBloomFilter(uint8_t numHashes, uint16_t numBits)
+    OrdinaryBloomFilter(uint8_t numHashes, uint16_t numBits, AllocationPolicy const& policy = AllocationPolicy())
     : AbstractBloomFilter<T>(numHashes, numBits)
-    {
-        m_bitarray.reserve(numBits);
-        for(uint16_t i = 0; i < super::GetNumBits(); i++){
-            m_bitarray[i] = 0;
-        }
+    , m_words((numBits + 63) / 64, 0, PageAllocator<uint64_t>(policy))
+    , m_dirty((m_words.size() + 63) / 64, 0)
+    {}
+    
+    /** Copy constructor which places the copy's storage according to a
+     *  different allocation policy, e.g. to replicate a BF onto another NUMA
+     *  node.
+     *
+     *  @param other  BF to copy
+     *  @param policy How to allocate the storage of the copy
+     */
+    OrdinaryBloomFilter(OrdinaryBloomFilter<T> const& other, AllocationPolicy const& policy)
+    : AbstractBloomFilter<T>(other)
+    , m_words(other.m_words, PageAllocator<uint64_t>(policy))
+    , m_dirty(other.m_dirty)
+    {}
+    
+    /** Returns the policy with which the storage of this BF was allocated
+     */
+    AllocationPolicy GetAllocationPolicy() const {
+        return m_words.get_allocator().GetPolicy();
+    }
+    
+    /** Creates an OrdinaryBloomFilter containing every object of a range,
+     *  such as a std::vector, inserting from several threads at once. Each
+     *  thread fills a private copy of the bit array, which fits in cache,
+     *  and the copies are merged by logical OR; the result is the same as
+     *  inserting the objects one by one.
+     *
+     *  @param  numHashes  Number of hashes
+     *  @param  numBits    Number of bits
+     *  @param  objects    Random-access range of objects, or of equivalent keys
+     *  @param  numThreads Number of threads to split the range across
+     *  @param  policy     How to allocate the storage of the BF
+     *  @return A new OrdinaryBloomFilter
+     */
+    template <typename Range>
+    static OrdinaryBloomFilter<T> BuildFrom(uint8_t numHashes, uint16_t numBits, Range const& objects,
+            unsigned numThreads = 1, AllocationPolicy const& policy = AllocationPolicy()){
+        return detail::BuildFrom(OrdinaryBloomFilter<T>(numHashes, numBits, policy), objects, numThreads,
+                                 [](OrdinaryBloomFilter<T> &bf, OrdinaryBloomFilter<T> const& part){ bf.Union(part); });
     }
     
     virtual void Insert(T const& o) {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            m_bitarray[super::ComputeHash(o, i)] = true;
-        }
+        InsertKey(o);
+    }
+    
+    /** Inserts an object given by an equivalent key type, such as a
+     *  std::string_view for a std::string filter, without constructing T.
+     *
+     *  @param key Key to insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+    
+    /** Inserts an object by its precomputed digest.
+     *
+     *  @param digest 64-bit digest of the object
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
     }
     
     virtual bool Query(T const& o) const {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            if(!m_bitarray[super::ComputeHash(o, i)]){
-                return false;
-            }
-        }
-        return true;
+        return QueryKey(o);
+    }
+    
+    /** Queries for an object given by an equivalent key type.
+     *
+     *  @param  key Key to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+    
+    /** Queries for an object by its precomputed digest.
+     *
+     *  @param  digest 64-bit digest of the object
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
     }
     
     virtual void Serialize(std::ostream &os) const {
@@ -59,10 +135,10 @@ public:
         os.write((const char *) &numHashes, sizeof(uint8_t));
         os.write((const char *) &numBits, sizeof(uint16_t));
         
-        for(uint16_t i = 0; i < (numBits + 7) / 8; i++){
+        for(unsigned i = 0; i < (numBits + 7u) / 8; i++){
             uint8_t byte = 0;
-            for(int j = 0; j < 8 && (i + j) < numBits; j++){
-                byte = (byte << 1) | m_bitarray[8*i+j];
+            for(unsigned j = 0; j < 8 && 8 * i + j < numBits; j++){
+                byte |= GetBit(8 * i + j) << (7 - j);
             }
             os.write((const char *) &byte, sizeof(uint8_t));
         }
@@ -83,11 +159,13 @@ public:
         
         OrdinaryBloomFilter<T> r (numHashes, numBits);
         
-        for(uint16_t i = 0; i < (numBits + 7) / 8; i++){
+        for(unsigned i = 0; i < (numBits + 7u) / 8; i++){
             uint8_t byte;
             is.read((char *) &byte, sizeof(uint8_t));
-            for(int j = 0; j < 8 && (i + j) < numBits; j++){
-                r.m_bitarray[8 * i + j] = byte & (1 << (7-j));
+            for(unsigned j = 0; j < 8 && 8 * i + j < numBits; j++){
+                if(byte & (1 << (7 - j))){
+                    r.SetBit(8 * i + j);
+                }
             }
         }
         
@@ -103,10 +181,12 @@ public:
         uint16_t oldNumBits = super::GetNumBits();
         uint16_t newNumBits = oldNumBits / 2;
         
-        OrdinaryBloomFilter<T> res(super::GetNumHashes(), newNumBits);
+        OrdinaryBloomFilter<T> res(super::GetNumHashes(), newNumBits, GetAllocationPolicy());
         
         for(unsigned i = 0; i < oldNumBits; i++){
-            res.m_bitarray[i % newNumBits] = res.m_bitarray[i % newNumBits] | m_bitarray[i];
+            if(GetBit(i)){
+                res.SetBit(i % newNumBits);
+            }
         }
         
         return res;
@@ -119,9 +199,12 @@ public:
      */
     PairedBloomFilter<T> ToPairedBloomFilter() const {
         uint16_t numBits = super::GetNumBits();
-        PairedBloomFilter<T> res(super::GetNumHashes(), numBits);
-        for(unsigned i = 0; i < numBits; i++){
-            res.m_bitarray[i] = m_bitarray[i];
+        PairedBloomFilter<T> res(super::GetNumHashes(), numBits, GetAllocationPolicy());
+        for(size_t i = 0; i < m_words.size(); i++){
+            if(m_words[i]){
+                res.m_words[i] = m_words[i];
+                res.MarkDirty(i);
+            }
         }
         return res;
     }
@@ -133,18 +216,219 @@ public:
      *  @param other BF to combine into this one
      */
     void Union(OrdinaryBloomFilter<T> const& other){
-        for(unsigned i = 0; i < super::GetNumBits(); i++){
-            m_bitarray[i] = m_bitarray[i] | other.m_bitarray[i];
+        simd::UnionWords(m_words.data(), other.m_words.data(), m_words.size(), m_dirty.data());
+    }
+    
+    /** Estimates the number of distinct objects inserted into this BF from
+     *  the number of bits set, as n = -(m / k) ln(1 - t / m) for t bits set
+     *  out of m with k hashes (Swamidass and Baldi). The estimate is
+     *  infinite once every bit is set.
+     *
+     *  @return Estimated number of objects
+     */
+    double EstimateSize() const {
+        return Cardinality(simd::PopCount(m_words.data(), m_words.size()));
+    }
+    
+    /** Estimates the number of distinct objects inserted into either this
+     *  BF or a second one with the same geometry, from the number of bits
+     *  set in their union.
+     *
+     *  @param  other BF to compare with
+     *  @return Estimated size of the union
+     */
+    double EstimateUnionSize(OrdinaryBloomFilter<T> const& other) const {
+        return Cardinality(simd::PopCountOr(m_words.data(), other.m_words.data(), m_words.size()));
+    }
+    
+    /** Estimates the number of distinct objects inserted into both this BF
+     *  and a second one with the same geometry, as the sum of their
+     *  estimated sizes minus the estimated size of their union.
+     *
+     *  @param  other BF to compare with
+     *  @return Estimated size of the intersection, at least 0
+     */
+    double EstimateIntersectionSize(OrdinaryBloomFilter<T> const& other) const {
+        uint64_t andCount, orCount, count;
+        simd::PopCountAndOr(m_words.data(), other.m_words.data(), m_words.size(), andCount, orCount, count);
+        return Intersection(count, andCount + orCount - count, orCount);
+    }
+    
+    /** Estimates the Jaccard similarity of the sets of objects inserted into
+     *  this BF and a second one with the same geometry: the size of their
+     *  intersection divided by the size of their union.
+     *
+     *  A BF with every bit set is compared as if one bit were clear, as its
+     *  estimated size is infinite.
+     *
+     *  @param  other BF to compare with
+     *  @return Estimated similarity in [0, 1]; 0 if both BFs are empty
+     */
+    double EstimateJaccard(OrdinaryBloomFilter<T> const& other) const {
+        uint64_t andCount, orCount, count;
+        simd::PopCountAndOr(m_words.data(), other.m_words.data(), m_words.size(), andCount, orCount, count);
+        return Jaccard(count, andCount + orCount - count, orCount);
+    }
+    
+    /** Estimates the Jaccard similarity of every pair of a set of BFs with
+     *  the same geometry, as by EstimateJaccard. The number of bits set in
+     *  each BF is counted once, so each pair costs a single pass over the
+     *  union of two bit arrays.
+     *
+     *  @param  filters    BFs to compare
+     *  @param  numThreads Number of threads to split the pairs across
+     *  @return Row-major N x N matrix of similarities, for N filters
+     */
+    static std::vector<double> EstimateJaccardMatrix(std::vector<OrdinaryBloomFilter<T>> const& filters,
+                                                     unsigned numThreads = 1){
+        size_t n = filters.size();
+        std::vector<uint64_t> counts(n);
+        for(size_t i = 0; i < n; i++){
+            counts[i] = simd::PopCount(filters[i].m_words.data(), filters[i].m_words.size());
+        }
+        
+        std::vector<double> res(n * n);
+        // rows are dealt out round-robin, since row i only computes the
+        // pairs (i, j) for j >= i and later rows are shorter
+        auto rows = [&](unsigned first, unsigned step){
+            for(size_t i = first; i < n; i += step){
+                OrdinaryBloomFilter<T> const& a = filters[i];
+                res[i * n + i] = a.Jaccard(counts[i], counts[i], counts[i]);
+                for(size_t j = i + 1; j < n; j++){
+                    uint64_t andCount, orCount;
+                    simd::PopCountAndOr(a.m_words.data(), filters[j].m_words.data(), a.m_words.size(),
+                                        andCount, orCount);
+                    res[i * n + j] = res[j * n + i] = a.Jaccard(counts[i], counts[j], orCount);
+                }
+            }
+        };
+        
+        if(numThreads < 2 || n < 2){
+            rows(0, 1);
+            return res;
         }
+        if(numThreads > n){
+            numThreads = n;
+        }
+        std::vector<std::thread> threads;
+        for(unsigned t = 1; t < numThreads; t++){
+            threads.emplace_back(rows, t, numThreads);
+        }
+        rows(0, numThreads);
+        for(std::thread &t : threads){
+            t.join();
+        }
+        return res;
+    }
+    
+    /** Writes a delta containing every word of the bit array modified since
+     *  the last call to Checkpoint(), or since construction. Applying the
+     *  delta to a replica of this BF as of that checkpoint brings the replica
+     *  up to date.
+     *
+     *  @param os Output stream to write the delta into
+     */
+    void WriteDelta(std::ostream &os) const {
+        detail::WriteWordDelta(os, m_words.data(), m_words.size(), m_dirty.data());
+    }
+    
+    /** Applies a delta written by WriteDelta() on a BF with the same
+     *  geometry, overwriting the words it contains. The words are also
+     *  marked as modified, so that deltas can be chained through replicas.
+     *  No validation is performed.
+     *
+     *  @param is Input stream to read the delta from
+     */
+    void ApplyDelta(std::istream &is){
+        detail::ApplyWordDelta(is, m_words.data(), m_words.size(), m_dirty.data());
+    }
+    
+    /** Marks the current state of this BF as the base for the next delta.
+     */
+    void Checkpoint(){
+        std::fill(m_dirty.begin(), m_dirty.end(), 0);
     }
     
     friend OrdinaryBloomFilter<T> CountingBloomFilter<T>::ToOrdinaryBloomFilter() const;
+    
+    template <typename U>
+    friend class BloomFilterBank;
 
 private:
     
     typedef AbstractBloomFilter<T> super;
     
-    std::vector<bool> m_bitarray;
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::Ordinary);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            SetBit(super::ComputeHash(key, i));
+        }
+    }
+    
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!GetBit(super::ComputeHash(key, i))){
+                stats::RecordQuery(stats::Ordinary, i + 1, false);
+                return false;
+            }
+        }
+        stats::RecordQuery(stats::Ordinary, super::GetNumHashes(), true);
+        return true;
+    }
+    
+    /** Estimates the number of objects which set the given number of bits
+     *  @see OrdinaryBloomFilter::EstimateSize
+     */
+    double Cardinality(uint64_t setBits) const {
+        double m = super::GetNumBits();
+        return -m / super::GetNumHashes() * std::log1p(-(setBits / m));
+    }
+    
+    /** Cardinality of a filter in which every bit but one is set; a
+     *  saturated filter counts as this large when comparing filters, whose
+     *  differences of infinite sizes would be undefined
+     */
+    double BoundedCardinality(uint64_t setBits) const {
+        uint64_t m = super::GetNumBits();
+        return Cardinality(setBits < m ? setBits : m - 1);
+    }
+    
+    double Intersection(uint64_t countA, uint64_t countB, uint64_t countUnion) const {
+        double n = BoundedCardinality(countA) + BoundedCardinality(countB) - BoundedCardinality(countUnion);
+        return n < 0 ? 0 : n;
+    }
+    
+    double Jaccard(uint64_t countA, uint64_t countB, uint64_t countUnion) const {
+        if(countUnion == 0){
+            return 0;
+        }
+        double j = Intersection(countA, countB, countUnion) / BoundedCardinality(countUnion);
+        return j > 1 ? 1 : j;
+    }
+    
+    bool GetBit(unsigned bit) const {
+        return (m_words[bit / 64] >> (bit % 64)) & 1;
+    }
+    
+    void SetBit(unsigned bit) {
+        m_words[bit / 64] |= uint64_t(1) << (bit % 64);
+        MarkDirty(bit / 64);
+    }
+    
+    void MarkDirty(size_t word) {
+        m_dirty[word / 64] |= uint64_t(1) << (word % 64);
+    }
+    
+    /** Bit array, packed least significant bit first
+     */
+    std::vector<uint64_t, PageAllocator<uint64_t>> m_words;
+    
+    /** One bit per word of m_words, set if the word was modified since the
+     *  last checkpoint
+     */
+    std::vector<uint64_t> m_dirty;
     
 
 }; // class OrdinaryBloomFilter
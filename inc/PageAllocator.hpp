@@ -0,0 +1,325 @@
+#ifndef PageAllocator_hpp
+#define PageAllocator_hpp
+
+#include <map>
+#include <new>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bloom {
+
+/** Describes how the storage of a Bloom filter should be allocated. The
+ *  default-constructed policy allocates from the ordinary heap.
+ */
+struct AllocationPolicy {
+
+    /** Page size to back the storage with
+     */
+    enum PageSize {
+        DefaultPages,   //!< Ordinary heap allocation
+        HugePages2M,    //!< 2 MiB pages
+        HugePages1G     //!< 1 GiB pages
+    };
+
+    /** NUMA placement of the storage
+     */
+    enum Placement {
+        LocalNode,      //!< Kernel default, normally the allocating thread's node
+        Interleave,     //!< Pages spread round-robin across all nodes
+        BindNode        //!< Pages placed on the node given by node
+    };
+
+    PageSize pageSize = DefaultPages;
+    Placement placement = LocalNode;
+    int node = 0;       //!< Target node when placement is BindNode
+
+    bool operator==(AllocationPolicy const& other) const {
+        return pageSize == other.pageSize && placement == other.placement && node == other.node;
+    }
+
+    bool operator!=(AllocationPolicy const& other) const {
+        return !(*this == other);
+    }
+
+};
+
+namespace detail {
+
+/** Applies the NUMA placement of a policy to a fresh mapping, before any of
+ *  its pages have been touched.
+ */
+inline void PlacePages(void *p, size_t len, AllocationPolicy const& policy){
+#ifdef SYS_mbind
+    // mempolicy modes from <linux/mempolicy.h>
+    const int MpolBind = 2, MpolInterleave = 3;
+    const size_t wordBits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask;
+    int mode;
+    if(policy.placement == AllocationPolicy::Interleave){
+        // the kernel restricts the mask to nodes which have memory
+        mask.assign(1, ~0ul);
+        mode = MpolInterleave;
+    }
+    else if(policy.placement == AllocationPolicy::BindNode){
+        // a node the kernel does not know fails the call, leaving the
+        // default placement
+        mask.assign(policy.node / wordBits + 1, 0);
+        mask.back() = 1ul << (policy.node % wordBits);
+        mode = MpolBind;
+    }
+    else {
+        return;
+    }
+    // maxnode is one past the highest bit the kernel reads
+    syscall(SYS_mbind, p, len, mode, mask.data(), mask.size() * wordBits + 1, 0);
+#else
+    (void) p;
+    (void) len;
+    (void) policy;
+#endif
+}
+
+/** Maps len bytes, a multiple of the page size, with the given page size
+ *  and the placement of a policy. Huge pages are requested from hugetlbfs
+ *  first, falling back to ordinary pages with a transparent huge page hint.
+ */
+inline void *MapPages(size_t len, AllocationPolicy::PageSize pageSize, AllocationPolicy const& policy){
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(pageSize != AllocationPolicy::DefaultPages){
+        // MAP_HUGE_SHIFT encoding of log2(page size)
+        int sizeFlag = (pageSize == AllocationPolicy::HugePages1G ? 30 : 21) << 26;
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | sizeFlag, -1, 0);
+    }
+#endif
+    if(p == MAP_FAILED){
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED){
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if(pageSize != AllocationPolicy::DefaultPages){
+            madvise(p, len, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    PlacePages(p, len, policy);
+    return p;
+}
+
+/** Shares 2 MiB pages between arrays smaller than half of one, so that a
+ *  bank of small filters fills whole huge pages instead of pinning one
+ *  each. Arrays are rounded up to a power of two of at least MinBlock bytes
+ *  and carved out of chunks of one page, with one set of chunks per NUMA
+ *  placement. Freed blocks are kept on per-size free lists for reuse, and
+ *  chunks are never unmapped.
+ */
+class SmallArrayPool {
+
+public:
+
+    static constexpr size_t ChunkSize = size_t(1) << 21;
+    static constexpr size_t MinBlock = size_t(1) << 12;
+    static constexpr size_t MaxBlock = ChunkSize / 2;
+
+    /** Returns the process-wide pool. It is never destroyed, so that static
+     *  filters may still free their arrays during exit.
+     */
+    static SmallArrayPool &Instance(){
+        static SmallArrayPool *pool = new SmallArrayPool();
+        return *pool;
+    }
+
+    /** Returns the size of the block holding an array of the given size,
+     *  which is at most MaxBlock
+     */
+    static size_t BlockSize(size_t bytes){
+        size_t block = MinBlock;
+        while(block < bytes){
+            block *= 2;
+        }
+        return block;
+    }
+
+    void *Allocate(size_t bytes, AllocationPolicy const& policy){
+        size_t block = BlockSize(bytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Arena &arena = m_arenas[Key(policy)];
+        std::vector<void *> &free = arena.free[SizeClass(block)];
+        if(!free.empty()){
+            void *p = free.back();
+            free.pop_back();
+            return p;
+        }
+        // blocks are carved in any order of sizes, so the tail of a chunk
+        // too short for the next one is left unused
+        if(arena.left < block){
+            arena.next = static_cast<char *>(MapPages(ChunkSize, AllocationPolicy::HugePages2M, policy));
+            arena.left = ChunkSize;
+        }
+        void *p = arena.next;
+        arena.next += block;
+        arena.left -= block;
+        return p;
+    }
+
+    void Free(void *p, size_t bytes, AllocationPolicy const& policy){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_arenas[Key(policy)].free[SizeClass(BlockSize(bytes))].push_back(p);
+    }
+
+private:
+
+    static constexpr unsigned NumSizeClasses = 10;  // MinBlock to MaxBlock
+
+    struct Arena {
+        char *next = nullptr;
+        size_t left = 0;
+        std::vector<void *> free[NumSizeClasses];
+    };
+
+    static std::tuple<int, int> Key(AllocationPolicy const& policy){
+        return std::make_tuple((int) policy.placement,
+                               policy.placement == AllocationPolicy::BindNode ? policy.node : 0);
+    }
+
+    static unsigned SizeClass(size_t block){
+        return __builtin_ctzll(block / MinBlock);
+    }
+
+    std::mutex m_mutex;
+    std::map<std::tuple<int, int>, Arena> m_arenas;
+
+};
+
+} // namespace detail
+
+/** Standard allocator which obtains memory according to an
+ *  AllocationPolicy. Huge pages are requested from hugetlbfs first; if none
+ *  are available the allocation falls back to ordinary pages with a
+ *  transparent huge page hint. NUMA placement is applied with mbind, and is
+ *  silently skipped on kernels or hosts which do not support it.
+ *
+ *  Any policy other than the default maps whole pages directly, except that
+ *  huge pages are never much larger than the array they hold: 1 GiB pages
+ *  fall back to 2 MiB ones for arrays below half a gigabyte, and arrays
+ *  below half of a 2 MiB page share pages through a pool. Every filter
+ *  array is small enough to be pooled.
+ *
+ *  @param U Allocated type
+ */
+template <typename U>
+class PageAllocator {
+
+public:
+
+    typedef U value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    PageAllocator() = default;
+
+    /** @throws std::invalid_argument if the policy binds to a negative
+     *          node
+     */
+    explicit
+    PageAllocator(AllocationPolicy const& policy)
+    : m_policy(policy)
+    {
+        if(policy.placement == AllocationPolicy::BindNode && policy.node < 0){
+            throw std::invalid_argument("NUMA node must be nonnegative");
+        }
+    }
+
+    template <typename V>
+    PageAllocator(PageAllocator<V> const& other)
+    : m_policy(other.GetPolicy())
+    {}
+
+    AllocationPolicy const& GetPolicy() const {
+        return m_policy;
+    }
+
+    /** Returns the page size used for an array of n objects
+     */
+    AllocationPolicy::PageSize GetPageSize(size_t n) const {
+        if(m_policy.pageSize == AllocationPolicy::HugePages1G && n * sizeof(U) < (size_t(1) << 29)){
+            return AllocationPolicy::HugePages2M;
+        }
+        return m_policy.pageSize;
+    }
+
+    /** Returns true if an array of n objects shares its pages with others
+     */
+    bool IsPooled(size_t n) const {
+        return GetPageSize(n) == AllocationPolicy::HugePages2M
+            && n * sizeof(U) <= detail::SmallArrayPool::MaxBlock;
+    }
+
+    /** Returns the number of bytes reserved for an array of n objects: its
+     *  pool block, or its own mapping rounded up to the page size. The same
+     *  length is used whether or not the huge page request succeeds, so
+     *  deallocate need not know which path was taken.
+     */
+    size_t GetMappedLength(size_t n) const {
+        size_t bytes = n * sizeof(U);
+        if(IsPooled(n)){
+            return detail::SmallArrayPool::BlockSize(bytes);
+        }
+        AllocationPolicy::PageSize pageSize = GetPageSize(n);
+        size_t page = pageSize == AllocationPolicy::HugePages1G ? (size_t(1) << 30)
+                    : pageSize == AllocationPolicy::HugePages2M ? (size_t(1) << 21)
+                    : (size_t) sysconf(_SC_PAGESIZE);
+        return (bytes + page - 1) / page * page;
+    }
+
+    U *allocate(size_t n){
+        if(m_policy == AllocationPolicy()){
+            return static_cast<U *>(::operator new(n * sizeof(U)));
+        }
+        if(IsPooled(n)){
+            return static_cast<U *>(detail::SmallArrayPool::Instance().Allocate(n * sizeof(U), m_policy));
+        }
+        return static_cast<U *>(detail::MapPages(GetMappedLength(n), GetPageSize(n), m_policy));
+    }
+
+    void deallocate(U *p, size_t n){
+        if(m_policy == AllocationPolicy()){
+            ::operator delete(p);
+        }
+        else if(IsPooled(n)){
+            detail::SmallArrayPool::Instance().Free(p, n * sizeof(U), m_policy);
+        }
+        else {
+            munmap(p, GetMappedLength(n));
+        }
+    }
+
+    template <typename V>
+    bool operator==(PageAllocator<V> const& other) const {
+        return m_policy == other.GetPolicy();
+    }
+
+    template <typename V>
+    bool operator!=(PageAllocator<V> const& other) const {
+        return !(*this == other);
+    }
+
+private:
+
+    AllocationPolicy m_policy;
+
+}; // class PageAllocator
+
+} // namespace bloom
+
+#endif
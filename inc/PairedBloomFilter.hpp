@@ -1,7 +1,13 @@
 #ifndef PairedBloomFilter_hpp
 #define PairedBloomFilter_hpp
 
+#include <vector>
+#include <algorithm>
 #include "AbstractDeletableBloomFilter.hpp"
+#include "PageAllocator.hpp"
+#include "SimdKernels.hpp"
+#include "Statistics.hpp"
+#include "WordDelta.hpp"
 
 // forward decl
 namespace bloom {
@@ -28,21 +34,54 @@ public:
 
     /** Constructor
      *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @param policy How to allocate the storage of this BF
      */
     explicit
-    PairedBloomFilter(uint8_t numHashes, uint16_t numBits)
+    PairedBloomFilter(uint8_t numHashes, uint16_t numBits, AllocationPolicy const& policy = AllocationPolicy())
     : AbstractDeletableBloomFilter<T>(numHashes, numBits)
-    {
-        m_bitarray.reserve(numBits * 2);
-        for(uint16_t i = 0; i < super::GetNumBits() * 2; i++){
-            m_bitarray[i] = 0;
-        }
+    , m_halfWords((numBits + 63) / 64)
+    , m_words(2 * m_halfWords, 0, PageAllocator<uint64_t>(policy))
+    , m_dirty((m_words.size() + 63) / 64, 0)
+    {}
+    
+    /** Copy constructor which places the copy's storage according to a
+     *  different allocation policy, e.g. to replicate a BF onto another NUMA
+     *  node.
+     *
+     *  @param other  BF to copy
+     *  @param policy How to allocate the storage of the copy
+     */
+    PairedBloomFilter(PairedBloomFilter<T> const& other, AllocationPolicy const& policy)
+    : AbstractDeletableBloomFilter<T>(other)
+    , m_halfWords(other.m_halfWords)
+    , m_words(other.m_words, PageAllocator<uint64_t>(policy))
+    , m_dirty(other.m_dirty)
+    {}
+    
+    /** Returns the policy with which the storage of this BF was allocated
+     */
+    AllocationPolicy GetAllocationPolicy() const {
+        return m_words.get_allocator().GetPolicy();
     }
     
     virtual void Insert(T const& o) {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            m_bitarray[super::ComputeHash(o, i)] = true;
-        }
+        InsertKey(o);
+    }
+    
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+    
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
     }
     
     /** Queries whether an object is indexed by this Bloom filter. Both false
@@ -52,27 +91,41 @@ public:
      *  @return true if object is indexed, false if the object is not indexed.
      */
     virtual bool Query(T const& o) const {
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            if(!m_bitarray[super::ComputeHash(o, i)]){
-                return false;
-            }
-        }
-        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-            if(!m_bitarray[super::GetNumBits() + super::ComputeHash(o, i)]){
-                return true;
-            }
-        }
-        return false;
+        return QueryKey(o);
+    }
+    
+    /** Queries for an object given by an equivalent key type.
+     *  @see PairedBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+    
+    /** Queries for an object by its precomputed digest.
+     *  @see PairedBloomFilter::Query
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
     }
     
     virtual bool Delete(T const& o) {
-        if(Query(o)){
-            for(uint8_t i = 0; i < super::GetNumHashes(); i++){
-                m_bitarray[super::GetNumBits() + super::ComputeHash(o, i)] = true;
-            }
-            return true;
-        }
-        return false;
+        return DeleteKey(o);
+    }
+    
+    /** Deletes an object given by an equivalent key type.
+     *  @see AbstractDeletableBloomFilter::Delete
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Delete(K const& key) {
+        return DeleteKey(key);
+    }
+    
+    /** Deletes an object by its precomputed digest.
+     *  @see AbstractDeletableBloomFilter::Delete
+     */
+    bool DeleteHash(uint64_t digest) {
+        return DeleteKey(HashDigest{digest});
     }
     
     virtual void Serialize(std::ostream &os) const {
@@ -82,10 +135,10 @@ public:
         os.write((const char *) &numHashes, sizeof(uint8_t));
         os.write((const char *) &numBits, sizeof(uint16_t));
         
-        for(uint16_t i = 0; i < (2 * numBits + 7) / 8; i++){
+        for(unsigned i = 0; i < (2u * numBits + 7) / 8; i++){
             uint8_t byte = 0;
-            for(int j = 0; j < 8 && (i + j) < 2 * numBits; j++){
-                byte = (byte << 1) | m_bitarray[8*i+j];
+            for(unsigned j = 0; j < 8 && 8 * i + j < 2u * numBits; j++){
+                byte |= GetBit(8 * i + j) << (7 - j);
             }
             os.write((const char *) &byte, sizeof(uint8_t));
         }
@@ -106,11 +159,13 @@ public:
         
         PairedBloomFilter<T> r (numHashes, numBits);
         
-        for(uint16_t i = 0; i < (2 * numBits + 7) / 8; i++){
+        for(unsigned i = 0; i < (2u * numBits + 7) / 8; i++){
             uint8_t byte;
             is.read((char *) &byte, sizeof(uint8_t));
-            for(int j = 0; j < 8 && (i + j) < 2 * numBits; j++){
-                r.m_bitarray[8 * i + j] = byte & (1 << (7-j));
+            for(unsigned j = 0; j < 8 && 8 * i + j < 2u * numBits; j++){
+                if(byte & (1 << (7 - j))){
+                    r.SetBit(8 * i + j);
+                }
             }
         }
         
@@ -125,22 +180,225 @@ public:
      *  @param other new BF to combine into this one
      */
     void Union(PairedBloomFilter<T> const& other){
-        uint16_t numBits = super::GetNumBits();
-        for(unsigned i = 0; i < numBits; i++){
-            m_bitarray[i] = m_bitarray[i] | other.m_bitarray[i];
-        }
-        for(unsigned i = 0; i < numBits; i++){
-            m_bitarray[numBits + i] = m_bitarray[numBits + i] & other.m_bitarray[numBits + i];
-        }
+        simd::UnionWords(m_words.data(), other.m_words.data(), m_halfWords, m_dirty.data());
+        simd::IntersectWords(m_words.data() + m_halfWords, other.m_words.data() + m_halfWords, m_halfWords,
+                             m_dirty.data(), m_halfWords);
+    }
+    
+    /** Writes a delta containing every word of the positive and negative bit
+     *  arrays modified since the last call to Checkpoint(), or since
+     *  construction. Applying the delta to a replica of this BF as of that
+     *  checkpoint brings the replica up to date.
+     *
+     *  @param os Output stream to write the delta into
+     */
+    void WriteDelta(std::ostream &os) const {
+        detail::WriteWordDelta(os, m_words.data(), m_words.size(), m_dirty.data());
+    }
+    
+    /** Applies a delta written by WriteDelta() on a BF with the same
+     *  geometry, overwriting the words it contains. The words are also
+     *  marked as modified, so that deltas can be chained through replicas.
+     *  No validation is performed.
+     *
+     *  @param is Input stream to read the delta from
+     */
+    void ApplyDelta(std::istream &is){
+        detail::ApplyWordDelta(is, m_words.data(), m_words.size(), m_dirty.data());
+    }
+    
+    /** Marks the current state of this BF as the base for the next delta.
+     */
+    void Checkpoint(){
+        std::fill(m_dirty.begin(), m_dirty.end(), 0);
     }
     
     friend PairedBloomFilter<T> OrdinaryBloomFilter<T>::ToPairedBloomFilter() const;
+    
+    template <typename U>
+    friend class ConcurrentPairedBloomFilter;
+    
+    template <typename BF>
+    friend class PersistentBloomFilter;
 
 private:
     
     typedef AbstractDeletableBloomFilter<T> super;
     
-    std::vector<bool> m_bitarray;
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::Paired);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            SetBit(super::ComputeHash(key, i));
+        }
+    }
+    
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        unsigned depth;
+        bool rejected;
+        bool result = TestKey(key, depth, rejected);
+        stats::RecordQuery(stats::Paired, depth, result);
+        if(rejected){
+            stats::RecordNegativeReject(stats::Paired);
+        }
+        return result;
+    }
+    
+    /** Tests membership without recording statistics.
+     *
+     *  @param depth    Set to the number of positive probes examined
+     *  @param rejected Set if all positive probes were set but the object
+     *                  has been deleted
+     */
+    template <typename K>
+    bool TestKey(K const& key, unsigned &depth, bool &rejected) const {
+        rejected = false;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!GetBit(super::ComputeHash(key, i))){
+                depth = i + 1;
+                return false;
+            }
+        }
+        depth = super::GetNumHashes();
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!GetBit(super::GetNumBits() + super::ComputeHash(key, i))){
+                return true;
+            }
+        }
+        rejected = true;
+        return false;
+    }
+    
+    template <typename K>
+    bool DeleteKey(K const& key) {
+        unsigned depth;
+        bool rejected;
+        if(TestKey(key, depth, rejected)){
+            for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+                SetBit(super::GetNumBits() + super::ComputeHash(key, i));
+            }
+            stats::RecordDelete(stats::Paired, true);
+            return true;
+        }
+        stats::RecordDelete(stats::Paired, false);
+        return false;
+    }
+    
+    /** Computes the bit indexes of an object in the positive array, for the
+     *  index-level operations used by PersistentBloomFilter.
+     */
+    void ComputeIndexes(T const& o, uint16_t *indexes) const {
+        ComputeIndexesOf(o, indexes);
+    }
+    
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void ComputeIndexes(K const& key, uint16_t *indexes) const {
+        ComputeIndexesOf(key, indexes);
+    }
+    
+    template <typename K>
+    void ComputeIndexesOf(K const& key, uint16_t *indexes) const {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            indexes[i] = super::ComputeHash(key, i);
+        }
+    }
+    
+    /** Inserts an object given by its bit indexes.
+     */
+    void InsertIndexes(uint16_t const *indexes) {
+        stats::RecordInsert(stats::Paired);
+        ReplayInsert(indexes, 0, 1);
+    }
+    
+    /** Deletes an object given by its bit indexes.
+     *
+     *  @return true if the object was present and deleted; false otherwise.
+     */
+    bool DeleteIndexes(uint16_t const *indexes) {
+        bool present = false;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(!GetBit(indexes[i])){
+                stats::RecordDelete(stats::Paired, false);
+                return false;
+            }
+        }
+        for(uint8_t i = 0; i < super::GetNumHashes() && !present; i++){
+            present = !GetBit(super::GetNumBits() + indexes[i]);
+        }
+        if(present){
+            ReplayDelete(indexes, 0, 1);
+        }
+        stats::RecordDelete(stats::Paired, present);
+        return present;
+    }
+    
+    /** Sets the positive bits at the given indexes which lie in blocks of
+     *  64 words of m_words numbered part modulo numParts, so that numParts
+     *  threads can each replay the same updates for their part without
+     *  sharing a word of m_words or of m_dirty.
+     */
+    void ReplayInsert(uint16_t const *indexes, unsigned part, unsigned numParts) {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            if(WordOf(indexes[i]) / 64 % numParts == part){
+                SetBit(indexes[i]);
+            }
+        }
+    }
+    
+    /** Sets the negative bits at the given indexes which lie in the given
+     *  part, for a deletion which is known to have succeeded.
+     *  @see PairedBloomFilter::ReplayInsert
+     */
+    void ReplayDelete(uint16_t const *indexes, unsigned part, unsigned numParts) {
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            unsigned bit = super::GetNumBits() + indexes[i];
+            if(WordOf(bit) / 64 % numParts == part){
+                SetBit(bit);
+            }
+        }
+    }
+    
+    /** Returns the word index within m_words and bit offset within that word
+     *  of a bit, where bits [0, GetNumBits()) are the positive array and
+     *  bits [GetNumBits(), 2 * GetNumBits()) are the negative array.
+     */
+    size_t WordOf(unsigned bit) const {
+        return bit < super::GetNumBits() ? bit / 64
+                                         : m_halfWords + (bit - super::GetNumBits()) / 64;
+    }
+    
+    unsigned OffsetOf(unsigned bit) const {
+        return bit < super::GetNumBits() ? bit % 64 : (bit - super::GetNumBits()) % 64;
+    }
+    
+    bool GetBit(unsigned bit) const {
+        return (m_words[WordOf(bit)] >> OffsetOf(bit)) & 1;
+    }
+    
+    void SetBit(unsigned bit) {
+        m_words[WordOf(bit)] |= uint64_t(1) << OffsetOf(bit);
+        MarkDirty(WordOf(bit));
+    }
+    
+    void MarkDirty(size_t word) {
+        m_dirty[word / 64] |= uint64_t(1) << (word % 64);
+    }
+    
+    /** Number of words in each of the positive and negative arrays
+     */
+    size_t m_halfWords;
+    
+    /** Positive bit array in words [0, m_halfWords), followed by the
+     *  negative bit array in words [m_halfWords, 2 * m_halfWords), each
+     *  packed least significant bit first
+     */
+    std::vector<uint64_t, PageAllocator<uint64_t>> m_words;
+    
+    /** One bit per word of m_words, set if the word was modified since the
+     *  last checkpoint
+     */
+    std::vector<uint64_t> m_dirty;
     
 
 }; // class PairedBloomFilter
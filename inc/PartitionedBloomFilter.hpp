@@ -0,0 +1,221 @@
+#ifndef PartitionedBloomFilter_hpp
+#define PartitionedBloomFilter_hpp
+
+#include <vector>
+#include "AbstractBloomFilter.hpp"
+#include "SimdKernels.hpp"
+#include "Statistics.hpp"
+
+namespace bloom {
+
+/** A partitioned Bloom filter. The bit array is split into one slice of
+ *  GetNumBits() / GetNumHashes() bits per hash function, and hash i only ever
+ *  addresses slice i. Since the k probes are independent of each other, a
+ *  query can fetch all of them at once; on CPUs with AVX2 or AVX-512, the
+ *  probes are checked with vector gathers.
+ *
+ *  The number of bits must be at least the number of hashes. Any bits left
+ *  over after dividing the array into equal slices are unused.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class PartitionedBloomFilter : public AbstractBloomFilter<T> {
+
+public:
+
+    /** Constructor
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     */
+    explicit
+    PartitionedBloomFilter(uint8_t numHashes, uint16_t numBits)
+    : AbstractBloomFilter<T>(numHashes, numBits)
+    , m_sliceBits(numBits / numHashes)
+    , m_words((numBits + 31) / 32, 0)
+    {}
+
+    /** Returns the number of bits in each per-hash slice
+     */
+    uint16_t GetSliceBits() const {
+        return m_sliceBits;
+    }
+
+    virtual void Insert(T const& o) {
+        InsertKey(o);
+    }
+
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
+    }
+
+    virtual bool Query(T const& o) const {
+        return QueryKey(o);
+    }
+
+    /** Queries for an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+
+    /** Queries for an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::QueryHash
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+
+    virtual void Serialize(std::ostream &os) const {
+        uint8_t numHashes = super::GetNumHashes();
+        uint16_t numBits = super::GetNumBits();
+
+        os.write((const char *) &numHashes, sizeof(uint8_t));
+        os.write((const char *) &numBits, sizeof(uint16_t));
+
+        for(unsigned i = 0; i < (numBits + 7u) / 8; i++){
+            uint8_t byte = 0;
+            for(unsigned j = 0; j < 8 && 8 * i + j < numBits; j++){
+                byte |= GetBit(8 * i + j) << (7 - j);
+            }
+            os.write((const char *) &byte, sizeof(uint8_t));
+        }
+    }
+
+    /** Create a PartitionedBloomFilter from the content of a binary input
+     *  stream. No validation is performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized PartitionedBloomFilter
+     */
+    static PartitionedBloomFilter<T> Deserialize(std::istream &is){
+        uint8_t numHashes;
+        uint16_t numBits;
+
+        is.read((char *) &numHashes, sizeof(uint8_t));
+        is.read((char *) &numBits, sizeof(uint16_t));
+
+        PartitionedBloomFilter<T> r (numHashes, numBits);
+
+        for(unsigned i = 0; i < (numBits + 7u) / 8; i++){
+            uint8_t byte;
+            is.read((char *) &byte, sizeof(uint8_t));
+            for(unsigned j = 0; j < 8 && 8 * i + j < numBits; j++){
+                if(byte & (1 << (7 - j))){
+                    r.m_words[(8 * i + j) / 32] |= uint32_t(1) << ((8 * i + j) % 32);
+                }
+            }
+        }
+
+        return r;
+    }
+
+    /** Halves this PartitionedBloomFilter by folding each slice onto its
+     *  own lower half, reducing its size at the cost of an increased false
+     *  positive ratio. The slice size must be even.
+     *
+     *  @return A new PartitionedBloomFilter with half as many bits.
+     */
+    PartitionedBloomFilter<T> Compress() const {
+        PartitionedBloomFilter<T> res(super::GetNumHashes(), super::GetNumBits() / 2);
+        uint16_t newSliceBits = res.m_sliceBits;
+
+        for(uint8_t s = 0; s < super::GetNumHashes(); s++){
+            for(unsigned j = 0; j < m_sliceBits; j++){
+                if(GetBit(s * m_sliceBits + j)){
+                    unsigned bit = s * newSliceBits + j % newSliceBits;
+                    res.m_words[bit / 32] |= uint32_t(1) << (bit % 32);
+                }
+            }
+        }
+
+        return res;
+    }
+
+    /** Update this Bloom filter by adding the contents of a second one with
+     *  the same geometry. Corresponding slices are combined by logical OR,
+     *  thus new false positives may be introduced.
+     *
+     *  @param other BF to combine into this one
+     */
+    void Union(PartitionedBloomFilter<T> const& other){
+        simd::OrWords(m_words.data(), other.m_words.data(), m_words.size());
+    }
+
+private:
+
+    typedef AbstractBloomFilter<T> super;
+
+    /** Size of the probe buffer: the largest possible number of hashes,
+     *  rounded up so that vector gathers never read past its end
+     */
+    static const unsigned MaxProbes = 256 + 16;
+
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::Partitioned);
+        uint16_t bits[MaxProbes];
+        ComputeBits(key, bits);
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            m_words[bits[i] / 32] |= uint32_t(1) << (bits[i] % 32);
+        }
+    }
+
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        uint16_t bits[MaxProbes];
+        ComputeBits(key, bits);
+        bool result = TestBits(bits);
+        // all probes are tested together, so every query has full depth
+        stats::RecordQuery(stats::Partitioned, super::GetNumHashes(), result);
+        return result;
+    }
+
+    /** Fills bits[0, k) with the bit index probed by each hash, and pads
+     *  the buffer to a whole vector by repeating the first probe.
+     */
+    template <typename K>
+    void ComputeBits(K const& key, uint16_t *bits) const {
+        uint8_t numHashes = super::GetNumHashes();
+        for(uint8_t i = 0; i < numHashes; i++){
+            bits[i] = i * m_sliceBits + super::ComputeHash(key, i, m_sliceBits);
+        }
+        for(unsigned i = numHashes; i < (numHashes + 15u) / 16 * 16; i++){
+            bits[i] = bits[0];
+        }
+    }
+
+    bool GetBit(unsigned bit) const {
+        return (m_words[bit / 32] >> (bit % 32)) & 1;
+    }
+
+    /** Returns true iff every bit in bits[0, k) is set.
+     */
+    bool TestBits(uint16_t const *bits) const {
+        return simd::TestBits(m_words.data(), bits, super::GetNumHashes());
+    }
+
+    /** Number of bits in each slice
+     */
+    uint16_t m_sliceBits;
+
+    std::vector<uint32_t> m_words;
+
+
+}; // class PartitionedBloomFilter
+
+} // namespace bloom
+
+#endif
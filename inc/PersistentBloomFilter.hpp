@@ -0,0 +1,570 @@
+#ifndef PersistentBloomFilter_hpp
+#define PersistentBloomFilter_hpp
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include "FastHash.hpp"
+
+namespace bloom {
+
+/** Describes how a PersistentBloomFilter trades throughput for durability.
+ *  The default policy makes every committed record durable.
+ */
+struct PersistencePolicy {
+
+    /** When the log is flushed to stable storage
+     */
+    enum Sync {
+        SyncNever,      //!< Left to the OS: survives a process crash, not a power loss
+        SyncPeriodic,   //!< On a commit at least syncInterval after the last flush
+        SyncAlways      //!< On every commit
+    };
+
+    Sync sync = SyncAlways;
+    std::chrono::milliseconds syncInterval{100};    //!< Interval for SyncPeriodic
+
+    size_t commitRecords = 256;                     //!< Records buffered before a commit
+    size_t checkpointRecords = size_t(1) << 20;     //!< Records logged between checkpoints; 0 for none
+
+    unsigned recoveryThreads = 1;                   //!< Threads replaying the log on recovery
+
+};
+
+/** A CountingBloomFilter or PairedBloomFilter which survives crashes. Each
+ *  effective insertion and deletion is recorded in an append-only
+ *  write-ahead log as the k indexes it touched, and the filter is
+ *  periodically written out whole as a checkpoint, after which the log
+ *  starts afresh. Reopening the filter loads the checkpoint and replays
+ *  the tail of the log.
+ *
+ *  Records are buffered and committed in groups of commitRecords, each
+ *  group with a single write and, depending on the policy, a single
+ *  fdatasync; Commit() and Sync() end a group early. Records still in the
+ *  buffer are lost in a crash, so a caller needing an update to be durable
+ *  before going on calls Sync(). Each group is checksummed, and a group
+ *  torn by a crash is discarded on recovery, along with anything after it.
+ *  A group which fails to be written whole, e.g. for lack of space, is cut
+ *  off the log again and stays buffered, so that a later commit retries
+ *  it; if the log cannot be cut back, the filter refuses further updates,
+ *  which recovery would otherwise discard after the torn group, until a
+ *  checkpoint replaces the log.
+ *
+ *  A checkpoint is written to a temporary file, flushed, and renamed into
+ *  place, and only then is the log replaced by an empty one. It holds the
+ *  sequence number of the last record it covers, so if a crash comes
+ *  between the two renames, recovery skips the records of the old log
+ *  which the checkpoint already contains. Deletions which found nothing to
+ *  delete are not logged.
+ *
+ *  Replay is split across threads by the blocks of the array each thread
+ *  owns; every thread scans the whole tail and applies the updates falling
+ *  into its blocks, in order, which yields the same array as a sequential
+ *  replay, since the effect of an update on a counter or bit depends on
+ *  that counter or bit alone.
+ *
+ *  The filter is kept in <path>.ckpt and <path>.log. As with the
+ *  underlying BF types, modifications must not run concurrently with other
+ *  operations.
+ *
+ *  @param BF CountingBloomFilter<T> or PairedBloomFilter<T>
+ */
+template <typename BF>
+class PersistentBloomFilter {
+
+public:
+
+    static constexpr uint32_t CheckpointMagic = 0x43464242;    // "BBFC"
+    static constexpr uint32_t LogMagic = 0x4c464242;           // "BBFL"
+
+    /** Constructor: opens the filter stored at the given path, recovering
+     *  it from its checkpoint and log, or creates an empty one there.
+     *
+     *  @param path      Path prefix of the checkpoint and log files
+     *  @param numHashes Number of hashes, which must match a stored filter
+     *  @param numBits   Number of bits, which must match a stored filter
+     *  @param policy    Durability and recovery settings
+     *  @throws std::invalid_argument if the stored files are not a filter
+     *          of this geometry
+     *  @throws std::system_error on I/O errors
+     */
+    explicit
+    PersistentBloomFilter(std::string const& path, uint8_t numHashes, uint16_t numBits,
+                          PersistencePolicy const& policy = PersistencePolicy())
+    : m_path(path)
+    , m_policy(policy)
+    , m_bf(numHashes, numBits)
+    , m_recordSize(1 + 2 * numHashes)
+    , m_fd(-1)
+    , m_logEnd(0)
+    , m_failed(false)
+    , m_buffer(FrameHeaderSize, 0)
+    , m_numBuffered(0)
+    , m_sequence(0)
+    , m_checkpointSequence(0)
+    , m_numReplayed(0)
+    , m_lastSync(std::chrono::steady_clock::now())
+    {
+        Recover();
+    }
+
+    PersistentBloomFilter(PersistentBloomFilter<BF> const&) = delete;
+    PersistentBloomFilter<BF> &operator=(PersistentBloomFilter<BF> const&) = delete;
+
+    /** Destructor: commits the buffered records and, unless the policy is
+     *  SyncNever, flushes them. Errors are ignored; call Sync() first to
+     *  observe them.
+     */
+    ~PersistentBloomFilter(){
+        try {
+            Commit();
+            if(m_policy.sync != PersistencePolicy::SyncNever){
+                SyncLog();
+            }
+        } catch(std::exception const&) {
+        }
+        close(m_fd);
+    }
+
+    /** Returns the in-memory filter
+     */
+    BF const& GetFilter() const {
+        return m_bf;
+    }
+
+    template <typename K>
+    bool Query(K const& key) const {
+        return m_bf.Query(key);
+    }
+
+    bool QueryHash(uint64_t digest) const {
+        return m_bf.QueryHash(digest);
+    }
+
+    /** Inserts an object and logs the insertion.
+     *
+     *  @param key Object to insert, or an equivalent key
+     */
+    template <typename K>
+    void Insert(K const& key) {
+        CheckUsable();
+        uint16_t indexes[256];
+        m_bf.ComputeIndexes(key, indexes);
+        m_bf.InsertIndexes(indexes);
+        Append(InsertRecord, indexes);
+    }
+
+    void InsertHash(uint64_t digest) {
+        Insert(HashDigest{digest});
+    }
+
+    /** Deletes an object, and logs the deletion if it took place.
+     *
+     *  @param  key Object to delete, or an equivalent key
+     *  @return true if the object was present and deleted; false otherwise.
+     */
+    template <typename K>
+    bool Delete(K const& key) {
+        CheckUsable();
+        uint16_t indexes[256];
+        m_bf.ComputeIndexes(key, indexes);
+        if(!m_bf.DeleteIndexes(indexes)){
+            return false;
+        }
+        Append(DeleteRecord, indexes);
+        return true;
+    }
+
+    bool DeleteHash(uint64_t digest) {
+        return Delete(HashDigest{digest});
+    }
+
+    /** Writes the buffered records to the log as one group, flushes the log
+     *  if the policy requires it, and takes a checkpoint if one is due.
+     */
+    void Commit(){
+        WriteGroup();
+        if(m_policy.checkpointRecords && m_sequence - m_checkpointSequence >= m_policy.checkpointRecords){
+            Checkpoint();
+        }
+    }
+
+    /** Commits the buffered records and flushes the log, regardless of the
+     *  policy. Every update made so far is durable on return.
+     */
+    void Sync(){
+        Commit();
+        SyncLog();
+    }
+
+    /** Writes the whole filter as a checkpoint and empties the log. The
+     *  checkpoint covers the buffered records too, so they are written to
+     *  the log only if it is usable.
+     */
+    void Checkpoint(){
+        if(!m_failed){
+            WriteGroup();
+        }
+
+        std::ostringstream os;
+        os.write((const char *) &CheckpointMagic, sizeof(uint32_t));
+        os.write((const char *) &m_sequence, sizeof(uint64_t));
+        m_bf.Serialize(os);
+        WriteFile(m_path + ".ckpt", os.str());
+
+        m_checkpointSequence = m_sequence;
+        ResetLog();
+        m_buffer.resize(FrameHeaderSize);
+        m_numBuffered = 0;
+    }
+
+    /** Returns the sequence number of the last record logged, counting
+     *  from 1 for the first record ever logged at this path
+     */
+    uint64_t GetSequenceNumber() const {
+        return m_sequence;
+    }
+
+    /** Returns the sequence number of the last record covered by the
+     *  latest checkpoint
+     */
+    uint64_t GetCheckpointSequenceNumber() const {
+        return m_checkpointSequence;
+    }
+
+    /** Returns the number of log records replayed when this filter was
+     *  opened
+     */
+    uint64_t GetNumReplayed() const {
+        return m_numReplayed;
+    }
+
+private:
+
+    enum RecordType : uint8_t {
+        InsertRecord = 1,
+        DeleteRecord = 2
+    };
+
+    /** Each group of records is preceded by its number of records and a
+     *  checksum of its records
+     */
+    static constexpr size_t FrameHeaderSize = 2 * sizeof(uint32_t);
+
+    /** Magic, number of hashes, number of bits, and the sequence number of
+     *  the record preceding the first one in the log
+     */
+    static constexpr size_t LogHeaderSize = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint64_t);
+
+    /** Below this many records per thread, starting a thread costs more
+     *  than the replay it takes over
+     */
+    static constexpr size_t MinReplayRecords = 4096;
+
+    void Append(RecordType type, uint16_t const *indexes){
+        m_buffer.push_back(type);
+        m_buffer.append((const char *) indexes, 2 * m_bf.GetNumHashes());
+        m_sequence++;
+        if(++m_numBuffered >= m_policy.commitRecords){
+            Commit();
+        }
+    }
+
+    /** Throws if a failed write left a torn group in the log
+     */
+    void CheckUsable() const {
+        if(m_failed){
+            throw std::system_error(EIO, std::generic_category(), m_path + ": log holds a torn group");
+        }
+    }
+
+    /** Writes the buffered records to the log as one group, and flushes
+     *  the log if the policy requires it. If the write fails, the log is
+     *  cut back to its previous end, and the records stay buffered.
+     */
+    void WriteGroup(){
+        if(m_numBuffered == 0){
+            return;
+        }
+        CheckUsable();
+        uint32_t numRecords = m_numBuffered;
+        uint32_t checksum = FastHash64::Hash(m_buffer.data() + FrameHeaderSize,
+                                             m_buffer.size() - FrameHeaderSize, numRecords);
+        std::memcpy(&m_buffer[0], &numRecords, sizeof(uint32_t));
+        std::memcpy(&m_buffer[sizeof(uint32_t)], &checksum, sizeof(uint32_t));
+        try {
+            WriteAll(m_fd, m_buffer.data(), m_buffer.size(), "cannot append to log");
+        } catch(std::system_error const&) {
+            if(ftruncate(m_fd, m_logEnd) != 0){
+                m_failed = true;
+            }
+            throw;
+        }
+        m_logEnd += m_buffer.size();
+        m_buffer.resize(FrameHeaderSize);
+        m_numBuffered = 0;
+
+        if(m_policy.sync == PersistencePolicy::SyncAlways
+           || (m_policy.sync == PersistencePolicy::SyncPeriodic
+               && std::chrono::steady_clock::now() - m_lastSync >= m_policy.syncInterval)){
+            SyncLog();
+        }
+    }
+
+    /** Loads the checkpoint, if any, and replays the valid records of the
+     *  log which follow it, then truncates the log after them
+     */
+    void Recover(){
+        std::ifstream ckpt(m_path + ".ckpt", std::ios::binary);
+        if(ckpt){
+            uint32_t magic = 0;
+            ckpt.read((char *) &magic, sizeof(uint32_t));
+            ckpt.read((char *) &m_checkpointSequence, sizeof(uint64_t));
+            if(!ckpt || magic != CheckpointMagic){
+                throw std::invalid_argument(m_path + ".ckpt is not a Bloom filter checkpoint");
+            }
+            BF bf = BF::Deserialize(ckpt);
+            if(!ckpt || bf.GetNumHashes() != m_bf.GetNumHashes() || bf.GetNumBits() != m_bf.GetNumBits()){
+                throw std::invalid_argument(m_path + ".ckpt does not hold a Bloom filter of this geometry");
+            }
+            m_bf = bf;
+        }
+        m_sequence = m_checkpointSequence;
+
+        std::ifstream is(m_path + ".log", std::ios::binary);
+        if(!is){
+            ResetLog();
+            return;
+        }
+        std::string log((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        is.close();
+
+        uint32_t magic = 0;
+        uint8_t numHashes = 0;
+        uint16_t numBits = 0;
+        uint64_t base = 0;
+        if(log.size() >= LogHeaderSize){
+            std::memcpy(&magic, &log[0], sizeof(uint32_t));
+            std::memcpy(&numHashes, &log[4], sizeof(uint8_t));
+            std::memcpy(&numBits, &log[5], sizeof(uint16_t));
+            std::memcpy(&base, &log[7], sizeof(uint64_t));
+        }
+        if(magic != LogMagic || numHashes != m_bf.GetNumHashes() || numBits != m_bf.GetNumBits()){
+            throw std::invalid_argument(m_path + ".log is not a log of a Bloom filter of this geometry");
+        }
+        if(base > m_checkpointSequence){
+            throw std::invalid_argument(m_path + ".log follows a checkpoint which is missing");
+        }
+
+        // gather the records following the checkpoint from the intact groups
+        std::string tail;
+        uint64_t sequence = base;
+        size_t end = LogHeaderSize;
+        while(log.size() - end >= FrameHeaderSize){
+            uint32_t numRecords, checksum;
+            std::memcpy(&numRecords, &log[end], sizeof(uint32_t));
+            std::memcpy(&checksum, &log[end + sizeof(uint32_t)], sizeof(uint32_t));
+            size_t len = (size_t) numRecords * m_recordSize;
+            if(numRecords == 0 || (log.size() - end - FrameHeaderSize) / m_recordSize < numRecords){
+                break;
+            }
+            const char *records = &log[end + FrameHeaderSize];
+            if(checksum != (uint32_t) FastHash64::Hash(records, len, numRecords)){
+                break;
+            }
+            for(uint32_t i = 0; i < numRecords; i++){
+                if(++sequence > m_checkpointSequence){
+                    tail.append(records + i * m_recordSize, m_recordSize);
+                }
+            }
+            end += FrameHeaderSize + len;
+        }
+        if(sequence > m_sequence){
+            m_sequence = sequence;
+        }
+
+        Replay(tail);
+
+        m_fd = open((m_path + ".log").c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(m_fd < 0){
+            Fail("cannot open log");
+        }
+        if(end < log.size() && ftruncate(m_fd, end) != 0){
+            Fail("cannot truncate log");
+        }
+        m_logEnd = end;
+    }
+
+    /** Applies the given records to the filter, using as many threads as
+     *  the policy allows and the number of records warrants
+     */
+    void Replay(std::string const& records){
+        size_t n = records.size() / m_recordSize;
+        m_numReplayed = n;
+
+        unsigned numThreads = m_policy.recoveryThreads;
+        if(numThreads > n / MinReplayRecords){
+            numThreads = n / MinReplayRecords;
+        }
+        if(numThreads < 1){
+            numThreads = 1;
+        }
+
+        auto replay = [&](unsigned part){
+            uint16_t indexes[256];
+            for(size_t i = 0; i < n; i++){
+                const char *r = records.data() + i * m_recordSize;
+                std::memcpy(indexes, r + 1, 2 * m_bf.GetNumHashes());
+                if(r[0] == InsertRecord){
+                    m_bf.ReplayInsert(indexes, part, numThreads);
+                } else {
+                    m_bf.ReplayDelete(indexes, part, numThreads);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(unsigned t = 1; t < numThreads; t++){
+            threads.emplace_back(replay, t);
+        }
+        replay(0);
+        for(std::thread &t : threads){
+            t.join();
+        }
+    }
+
+    /** Replaces the log by an empty one starting after the current
+     *  sequence number, and opens it for appending
+     */
+    void ResetLog(){
+        std::string header(LogHeaderSize, 0);
+        uint8_t numHashes = m_bf.GetNumHashes();
+        uint16_t numBits = m_bf.GetNumBits();
+        std::memcpy(&header[0], &LogMagic, sizeof(uint32_t));
+        std::memcpy(&header[4], &numHashes, sizeof(uint8_t));
+        std::memcpy(&header[5], &numBits, sizeof(uint16_t));
+        std::memcpy(&header[7], &m_sequence, sizeof(uint64_t));
+        WriteFile(m_path + ".log", header);
+
+        int fd = open((m_path + ".log").c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(fd < 0){
+            Fail("cannot open log");
+        }
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+        m_fd = fd;
+        m_logEnd = LogHeaderSize;
+        m_failed = false;
+        m_lastSync = std::chrono::steady_clock::now();
+    }
+
+    /** Atomically replaces a file: writes the contents to a temporary
+     *  file, flushes it, renames it into place, and flushes the directory
+     */
+    void WriteFile(std::string const& name, std::string const& contents){
+        std::string tmp = name + ".tmp";
+        int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0){
+            Fail("cannot create " + tmp);
+        }
+        try {
+            WriteAll(fd, contents.data(), contents.size(), "cannot write " + tmp);
+            if(fsync(fd) != 0){
+                Fail("cannot flush " + tmp);
+            }
+        } catch(...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        if(rename(tmp.c_str(), name.c_str()) != 0){
+            Fail("cannot rename " + tmp);
+        }
+
+        size_t slash = name.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : name.substr(0, slash);
+        int dirfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(dirfd < 0){
+            Fail("cannot open " + dir);
+        }
+        int r = fsync(dirfd);
+        close(dirfd);
+        if(r != 0){
+            Fail("cannot flush " + dir);
+        }
+    }
+
+    void SyncLog(){
+        if(fdatasync(m_fd) != 0){
+            Fail("cannot flush log");
+        }
+        m_lastSync = std::chrono::steady_clock::now();
+    }
+
+    /** Writes a whole buffer, resuming short and interrupted writes
+     */
+    void WriteAll(int fd, const char *data, size_t len, std::string const& what){
+        while(len > 0){
+            ssize_t n = write(fd, data, len);
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                Fail(what);
+            }
+            data += n;
+            len -= n;
+        }
+    }
+
+    [[noreturn]] void Fail(std::string const& what) const {
+        throw std::system_error(errno, std::generic_category(), m_path + ": " + what);
+    }
+
+    std::string m_path;
+    PersistencePolicy m_policy;
+    BF m_bf;
+
+    /** Size of a record: its type followed by k 16-bit indexes
+     */
+    size_t m_recordSize;
+
+    /** Log, open for appending
+     */
+    int m_fd;
+
+    /** Size of the log up to the end of its last complete group
+     */
+    off_t m_logEnd;
+
+    /** Set if a torn group could not be cut off the log
+     */
+    bool m_failed;
+
+    /** Group being built: room for its header, followed by its records
+     */
+    std::string m_buffer;
+    size_t m_numBuffered;
+
+    uint64_t m_sequence;
+    uint64_t m_checkpointSequence;
+    uint64_t m_numReplayed;
+
+    std::chrono::steady_clock::time_point m_lastSync;
+
+}; // class PersistentBloomFilter
+
+} // namespace bloom
+
+#endif
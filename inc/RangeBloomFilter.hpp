@@ -0,0 +1,178 @@
+#ifndef RangeBloomFilter_hpp
+#define RangeBloomFilter_hpp
+
+#include <type_traits>
+#include "AbstractBloomFilter.hpp"
+#include "OrdinaryBloomFilter.hpp"
+#include "FastHash.hpp"
+
+namespace bloom {
+
+/** A Bloom filter over unsigned integers, such as timestamps or IDs, which
+ *  can also tell whether any object in a range may be present. Each object
+ *  x is inserted once per level l = 0, ..., L-1 as its prefix x >> l,
+ *  which stands for the dyadic interval of the 2^l integers sharing that
+ *  prefix.
+ *
+ *  A range query splits the range into maximal dyadic intervals of level
+ *  below L, at most 2L plus one per 2^(L-1) integers of the range, and
+ *  probes each of them. An interval which may be occupied is confirmed by
+ *  descending to its two halves until level 0 is reached, as in Rosetta,
+ *  so that a false positive for a large interval is usually caught one
+ *  level down. The false positive rate of a range query thus stays close
+ *  to that of a point query, while its cost grows with the logarithm of
+ *  the range length.
+ *
+ *  The prefixes are stored in an OrdinaryBloomFilter, by digest, so every
+ *  object takes up L entries; the BF should be sized for L times the
+ *  number of objects. Objects are hashed with FastHash64, not with
+ *  std::hash<HashParams<T>>.
+ *
+ *  @param T Unsigned integer type being indexed
+ */
+template <typename T>
+class RangeBloomFilter : public AbstractBloomFilter<T> {
+
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value,
+                  "RangeBloomFilter indexes unsigned integers");
+
+public:
+
+    /** Range queries which would probe more than this many dyadic intervals
+     *  are answered true without probing
+     */
+    static const unsigned MaxIntervals = 4096;
+
+    /** Constructor
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @param numLevels Number of prefix levels L, between 1 and the number
+     *                   of bits of T (inclusive)
+     */
+    explicit
+    RangeBloomFilter(uint8_t numHashes, uint16_t numBits, uint8_t numLevels)
+    : AbstractBloomFilter<T>(numHashes, numBits)
+    , m_numLevels(numLevels)
+    , m_prefixes(numHashes, numBits)
+    {}
+
+    /** Inserts an object, as one prefix per level.
+     *
+     *  @param o Object to insert
+     */
+    virtual void Insert(T const& o) {
+        for(uint8_t l = 0; l < m_numLevels; l++){
+            m_prefixes.InsertHash(Digest(l, uint64_t(o) >> l));
+        }
+    }
+
+    /** Queries whether an object is indexed by this Bloom filter. Can return
+     *  a false positive, but not a false negative.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    virtual bool Query(T const& o) const {
+        return Probe(0, o);
+    }
+
+    /** Queries whether any object in the range [first, last] is indexed by
+     *  this Bloom filter. Can return a false positive, but not a false
+     *  negative.
+     *
+     *  @param  first Lowest object of the range
+     *  @param  last  Highest object of the range, at least first
+     *  @return true if some object in the range may be indexed
+     */
+    bool QueryRange(T first, T last) const {
+        uint64_t a = first, b = last;
+        unsigned numIntervals = 0;
+        while(true){
+            // the largest dyadic interval starting at a and ending by b
+            unsigned l = a == 0 ? 63 : __builtin_ctzll(a);
+            if(l > m_numLevels - 1u){
+                l = m_numLevels - 1;
+            }
+            while(l > 0 && b - a < (uint64_t(1) << l) - 1){
+                l--;
+            }
+            if(++numIntervals > MaxIntervals){
+                return true;
+            }
+            if(Descend(l, a >> l)){
+                return true;
+            }
+            uint64_t end = a + ((uint64_t(1) << l) - 1);
+            if(end >= b){
+                return false;
+            }
+            a = end + 1;
+        }
+    }
+
+    /** Returns the number of prefix levels
+     */
+    uint8_t GetNumLevels() const {
+        return m_numLevels;
+    }
+
+    /** Writes the number of levels followed by the underlying
+     *  OrdinaryBloomFilter.
+     *
+     *  @param os output stream to serialize the BF into
+     */
+    virtual void Serialize(std::ostream &os) const {
+        os.write((const char *) &m_numLevels, sizeof(uint8_t));
+        m_prefixes.Serialize(os);
+    }
+
+    /** Create a RangeBloomFilter from the content of a binary input stream.
+     *  No validation is performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized RangeBloomFilter
+     */
+    static RangeBloomFilter<T> Deserialize(std::istream &is){
+        uint8_t numLevels;
+        is.read((char *) &numLevels, sizeof(uint8_t));
+
+        OrdinaryBloomFilter<T> prefixes = OrdinaryBloomFilter<T>::Deserialize(is);
+        RangeBloomFilter<T> r(prefixes.GetNumHashes(), prefixes.GetNumBits(), numLevels);
+        r.m_prefixes.Union(prefixes);
+        return r;
+    }
+
+private:
+
+    static uint64_t Digest(unsigned level, uint64_t prefix){
+        return FastHash64::Hash(&prefix, sizeof(prefix), level);
+    }
+
+    bool Probe(unsigned level, uint64_t prefix) const {
+        return m_prefixes.QueryHash(Digest(level, prefix));
+    }
+
+    /** Returns true if some object below the given prefix may be present,
+     *  confirming each occupied interval through its halves
+     */
+    bool Descend(unsigned level, uint64_t prefix) const {
+        if(!Probe(level, prefix)){
+            return false;
+        }
+        if(level == 0){
+            return true;
+        }
+        return Descend(level - 1, 2 * prefix) || Descend(level - 1, 2 * prefix + 1);
+    }
+
+    uint8_t m_numLevels;
+
+    /** Prefixes of every level, inserted by digest
+     */
+    OrdinaryBloomFilter<T> m_prefixes;
+
+}; // class RangeBloomFilter
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef ReplicatedBloomFilter_hpp
+#define ReplicatedBloomFilter_hpp
+
+#include <vector>
+#include <fstream>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "PageAllocator.hpp"
+
+namespace bloom {
+
+/** Returns the number of NUMA nodes on this host, or 1 if it cannot be
+ *  determined.
+ */
+inline unsigned GetNumNumaNodes(){
+    // e.g. "0-1" on a two-socket host
+    std::ifstream f("/sys/devices/system/node/possible");
+    std::string range;
+    if(!(f >> range)){
+        return 1;
+    }
+    size_t dash = range.find_last_of("-,");
+    return std::stoul(dash == std::string::npos ? range : range.substr(dash + 1)) + 1;
+}
+
+/** Returns the NUMA node of the CPU the calling thread is running on.
+ */
+inline unsigned GetCurrentNumaNode(){
+#ifdef SYS_getcpu
+    unsigned cpu, node;
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0){
+        return node;
+    }
+#endif
+    return 0;
+}
+
+/** A read-mostly Bloom filter which keeps one replica of an underlying BF
+ *  bound to each NUMA node. Queries are answered from the replica on the
+ *  caller's node, so they never cross the interconnect; insertions and
+ *  deletions are applied to every replica.
+ *
+ *  As with the underlying BF types, modifications must not run concurrently
+ *  with other operations.
+ *
+ *  @param BF Underlying Bloom filter type, which must provide a constructor
+ *            taking a BF and an AllocationPolicy
+ */
+template <typename BF>
+class ReplicatedBloomFilter {
+
+public:
+
+    /** Constructor: replicates a BF onto every NUMA node.
+     *
+     *  @param bf       BF to replicate
+     *  @param pageSize Page size to back each replica with
+     */
+    explicit
+    ReplicatedBloomFilter(BF const& bf, AllocationPolicy::PageSize pageSize = AllocationPolicy::DefaultPages)
+    {
+        unsigned numNodes = GetNumNumaNodes();
+        m_replicas.reserve(numNodes);
+        for(unsigned n = 0; n < numNodes; n++){
+            AllocationPolicy policy;
+            policy.pageSize = pageSize;
+            policy.placement = numNodes > 1 ? AllocationPolicy::BindNode : AllocationPolicy::LocalNode;
+            policy.node = n;
+            m_replicas.emplace_back(bf, policy);
+        }
+    }
+
+    /** Returns the number of replicas, one per NUMA node
+     */
+    size_t GetNumReplicas() const {
+        return m_replicas.size();
+    }
+
+    /** Returns the replica local to the calling thread
+     */
+    BF const& Local() const {
+        unsigned node = GetCurrentNumaNode();
+        return m_replicas[node < m_replicas.size() ? node : 0];
+    }
+
+    template <typename K>
+    bool Query(K const& key) const {
+        return Local().Query(key);
+    }
+
+    bool QueryHash(uint64_t digest) const {
+        return Local().QueryHash(digest);
+    }
+
+    template <typename K>
+    void Insert(K const& key) {
+        for(BF &r : m_replicas){
+            r.Insert(key);
+        }
+    }
+
+    void InsertHash(uint64_t digest) {
+        for(BF &r : m_replicas){
+            r.InsertHash(digest);
+        }
+    }
+
+    /** Deletes an object from every replica, for deletable BF types.
+     *
+     *  @return true if the object was present and deleted; false otherwise.
+     */
+    template <typename K>
+    bool Delete(K const& key) {
+        bool deleted = false;
+        for(BF &r : m_replicas){
+            deleted = r.Delete(key);
+        }
+        return deleted;
+    }
+
+private:
+
+    std::vector<BF> m_replicas;
+
+}; // class ReplicatedBloomFilter
+
+} // namespace bloom
+
+#endif
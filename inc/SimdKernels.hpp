@@ -0,0 +1,969 @@
+#ifndef SimdKernels_hpp
+#define SimdKernels_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BLOOM_SIMD_X86
+#include <immintrin.h>
+#define BLOOM_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define BLOOM_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define BLOOM_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw,popcnt")))
+#define BLOOM_TARGET_AVX512_POPCNT __attribute__((target("avx2,avx512f,avx512bw,avx512vpopcntdq,popcnt")))
+#endif
+
+#if defined(BLOOM_SIMD_X86) && !defined(__clang__)
+// GCC's AVX-512 intrinsics trip -Wmaybe-uninitialized on their own
+// placeholder operands
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace bloom {
+
+/** Bulk operations over bit and counter arrays, shared by the filter
+ *  implementations. Each kernel is compiled for several instruction sets,
+ *  whatever the compiler flags, and the widest one the CPU supports is
+ *  picked at run time, on first use, so that one binary runs everywhere
+ *  and still uses the vector units of newer CPUs. SetIsa forces a
+ *  particular one, e.g. to test or benchmark every variant on one machine.
+ */
+namespace simd {
+
+/** Instruction sets for which the kernels are compiled, in increasing
+ *  order of preference
+ */
+enum Isa {
+    Scalar,         //!< Portable code only
+    Sse42,          //!< SSE4.2 and POPCNT
+    Avx2,           //!< AVX2
+    Avx512,         //!< AVX-512 F and BW, with AVX2 popcounts
+    Avx512Popcnt,   //!< AVX-512 F, BW and VPOPCNTDQ
+    NumIsas
+};
+
+inline const char *IsaName(Isa isa){
+    static const char *const names[NumIsas] = {"scalar", "sse4.2", "avx2", "avx512", "avx512-vpopcntdq"};
+    return isa < NumIsas ? names[isa] : "unknown";
+}
+
+/** Returns true if the CPU and OS support an instruction set, and the
+ *  kernels were compiled for it
+ */
+inline bool IsSupported(Isa isa){
+#if defined(BLOOM_SIMD_X86)
+    __builtin_cpu_init();
+    switch(isa){
+        case Scalar:
+            return true;
+        case Sse42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+        case Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        case Avx512Popcnt:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+                && __builtin_cpu_supports("avx512vpopcntdq");
+        default:
+            return false;
+    }
+#else
+    return isa == Scalar;
+#endif
+}
+
+/** Returns the most preferred instruction set which is supported
+ */
+inline Isa DetectIsa(){
+    for(int isa = NumIsas - 1; isa > Scalar; isa--){
+        if(IsSupported((Isa) isa)){
+            return (Isa) isa;
+        }
+    }
+    return Scalar;
+}
+
+namespace detail {
+
+/** Sets the bits of a bitmap from position pos onwards to those of mask,
+ *  which is at most 64 bits wide
+ */
+inline void MarkChanged(uint64_t *changed, size_t pos, uint64_t mask){
+    changed[pos / 64] |= mask << (pos % 64);
+    if(pos % 64 && mask >> (64 - pos % 64)){
+        changed[pos / 64 + 1] |= mask >> (64 - pos % 64);
+    }
+}
+
+// Portable variants, which also finish the remainder of the vector ones
+
+inline void CountersToBitsScalar(uint8_t const *counters, size_t n, uint64_t *words){
+    for(size_t i = 0; i < n; i += 64){
+        uint64_t word = 0;
+        for(unsigned j = 0; j < 64 && i + j < n; j++){
+            word |= uint64_t(counters[i + j] != 0) << j;
+        }
+        words[i / 64] = word;
+    }
+}
+
+inline void SaturatingAddScalar(uint8_t *dst, uint8_t const *src, size_t n){
+    for(size_t i = 0; i < n; i++){
+        unsigned sum = dst[i] + src[i];
+        dst[i] = sum > 255 ? 255 : sum;
+    }
+}
+
+inline void SaturatingSubtractScalar(uint8_t *dst, uint8_t const *src, size_t n){
+    for(size_t i = 0; i < n; i++){
+        dst[i] = dst[i] > src[i] ? dst[i] - src[i] : 0;
+    }
+}
+
+inline void MinimumScalar(uint8_t *dst, uint8_t const *src, size_t n){
+    for(size_t i = 0; i < n; i++){
+        dst[i] = dst[i] < src[i] ? dst[i] : src[i];
+    }
+}
+
+/** Reports the counters from index i onwards
+ */
+inline size_t FindAtLeastFrom(uint8_t const *counters, size_t i, size_t n, uint8_t threshold, uint32_t *out){
+    size_t count = 0;
+    for(; i < n; i++){
+        if(counters[i] >= threshold){
+            out[count++] = i;
+        }
+    }
+    return count;
+}
+
+inline size_t FindAtLeastScalar(uint8_t const *counters, size_t n, uint8_t threshold, uint32_t *out){
+    return FindAtLeastFrom(counters, 0, n, threshold, out);
+}
+
+/** Counts the bits set in a | b, and optionally those set in a & b and in
+ *  a, in one pass
+ */
+template <bool CountAnd, bool CountA>
+inline void PopCountPairScalar(uint64_t const *a, uint64_t const *b, size_t n,
+                               uint64_t &andCount, uint64_t &orCount, uint64_t &aCount){
+    andCount = 0;
+    orCount = 0;
+    aCount = 0;
+    for(size_t i = 0; i < n; i++){
+        if(CountAnd){
+            andCount += __builtin_popcountll(a[i] & b[i]);
+        }
+        orCount += __builtin_popcountll(a[i] | b[i]);
+        if(CountA){
+            aCount += __builtin_popcountll(a[i]);
+        }
+    }
+}
+
+inline uint64_t PopCountScalar(uint64_t const *words, size_t n){
+    uint64_t count = 0;
+    for(size_t i = 0; i < n; i++){
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+inline bool TestBitsScalar(uint32_t const *words, uint16_t const *bits, size_t n){
+    for(size_t i = 0; i < n; i++){
+        if(!((words[bits[i] / 32] >> (bits[i] % 32)) & 1)){
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void OrWordsScalar(uint32_t *dst, uint32_t const *src, size_t n){
+    for(size_t i = 0; i < n; i++){
+        dst[i] |= src[i];
+    }
+}
+
+inline void UnionWordsScalar(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    for(size_t i = 0; i < n; i++){
+        if(src[i] & ~dst[i]){
+            dst[i] |= src[i];
+            MarkChanged(changed, first + i, 1);
+        }
+    }
+}
+
+inline void IntersectWordsScalar(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    for(size_t i = 0; i < n; i++){
+        if(dst[i] & ~src[i]){
+            dst[i] &= src[i];
+            MarkChanged(changed, first + i, 1);
+        }
+    }
+}
+
+#if defined(BLOOM_SIMD_X86)
+
+// SSE4.2 variants
+
+BLOOM_TARGET_SSE42
+inline void CountersToBitsSse42(uint8_t const *counters, size_t n, uint64_t *words){
+    __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        uint64_t word = 0;
+        for(unsigned j = 0; j < 4; j++){
+            __m128i v = _mm_loadu_si128((__m128i const *) (counters + i + 16 * j));
+            uint64_t z = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+            word |= z << (16 * j);
+        }
+        words[i / 64] = ~word;
+    }
+    CountersToBitsScalar(counters + i, n - i, words + i / 64);
+}
+
+BLOOM_TARGET_SSE42
+inline void SaturatingAddSse42(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_adds_epu8(a, b));
+    }
+    SaturatingAddScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_SSE42
+inline void SaturatingSubtractSse42(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_subs_epu8(a, b));
+    }
+    SaturatingSubtractScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_SSE42
+inline void MinimumSse42(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_min_epu8(a, b));
+    }
+    MinimumScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_SSE42
+inline size_t FindAtLeastSse42(uint8_t const *counters, size_t n, uint8_t threshold, uint32_t *out){
+    size_t count = 0;
+    size_t i = 0;
+    __m128i t = _mm_set1_epi8((char) threshold);
+    for(; i + 16 <= n; i += 16){
+        __m128i v = _mm_loadu_si128((__m128i const *) (counters + i));
+        // v >= t iff max(v, t) == v
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, t), v));
+        for(; mask; mask &= mask - 1){
+            out[count++] = i + __builtin_ctz(mask);
+        }
+    }
+    return count + FindAtLeastFrom(counters, i, n, threshold, out + count);
+}
+
+// the portable loops, with __builtin_popcountll compiled to POPCNT
+
+template <bool CountAnd, bool CountA>
+BLOOM_TARGET_SSE42
+inline void PopCountPairSse42(uint64_t const *a, uint64_t const *b, size_t n,
+                              uint64_t &andCount, uint64_t &orCount, uint64_t &aCount){
+    andCount = 0;
+    orCount = 0;
+    aCount = 0;
+    for(size_t i = 0; i < n; i++){
+        if(CountAnd){
+            andCount += __builtin_popcountll(a[i] & b[i]);
+        }
+        orCount += __builtin_popcountll(a[i] | b[i]);
+        if(CountA){
+            aCount += __builtin_popcountll(a[i]);
+        }
+    }
+}
+
+BLOOM_TARGET_SSE42
+inline uint64_t PopCountSse42(uint64_t const *words, size_t n){
+    uint64_t count = 0;
+    for(size_t i = 0; i < n; i++){
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+// without gathers, probes are tested one at a time
+inline bool TestBitsSse42(uint32_t const *words, uint16_t const *bits, size_t n){
+    return TestBitsScalar(words, bits, n);
+}
+
+BLOOM_TARGET_SSE42
+inline void OrWordsSse42(uint32_t *dst, uint32_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(a, b));
+    }
+    OrWordsScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_SSE42
+inline void UnionWordsSse42(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    __m128i zero = _mm_setzero_si128();
+    for(; i + 2 <= n; i += 2){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        // a word changes iff src has a bit which dst lacks
+        unsigned same = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_andnot_si128(a, b), zero)));
+        if(same != 0x3){
+            _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(a, b));
+            MarkChanged(changed, first + i, ~same & 0x3);
+        }
+    }
+    UnionWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+BLOOM_TARGET_SSE42
+inline void IntersectWordsSse42(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    __m128i zero = _mm_setzero_si128();
+    for(; i + 2 <= n; i += 2){
+        __m128i a = _mm_loadu_si128((__m128i const *) (dst + i));
+        __m128i b = _mm_loadu_si128((__m128i const *) (src + i));
+        unsigned same = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_andnot_si128(b, a), zero)));
+        if(same != 0x3){
+            _mm_storeu_si128((__m128i *) (dst + i), _mm_and_si128(a, b));
+            MarkChanged(changed, first + i, ~same & 0x3);
+        }
+    }
+    IntersectWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+// AVX2 variants
+
+BLOOM_TARGET_AVX2
+inline void CountersToBitsAvx2(uint8_t const *counters, size_t n, uint64_t *words){
+    __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        __m256i lo = _mm256_loadu_si256((__m256i const *) (counters + i));
+        __m256i hi = _mm256_loadu_si256((__m256i const *) (counters + i + 32));
+        uint64_t zlo = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+        uint64_t zhi = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+        words[i / 64] = ~(zlo | (zhi << 32));
+    }
+    CountersToBitsScalar(counters + i, n - i, words + i / 64);
+}
+
+BLOOM_TARGET_AVX2
+inline void SaturatingAddAvx2(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_adds_epu8(a, b));
+    }
+    SaturatingAddScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX2
+inline void SaturatingSubtractAvx2(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_subs_epu8(a, b));
+    }
+    SaturatingSubtractScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX2
+inline void MinimumAvx2(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_min_epu8(a, b));
+    }
+    MinimumScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX2
+inline size_t FindAtLeastAvx2(uint8_t const *counters, size_t n, uint8_t threshold, uint32_t *out){
+    size_t count = 0;
+    size_t i = 0;
+    __m256i t = _mm256_set1_epi8((char) threshold);
+    for(; i + 32 <= n; i += 32){
+        __m256i v = _mm256_loadu_si256((__m256i const *) (counters + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, t), v));
+        for(; mask; mask &= mask - 1){
+            out[count++] = i + __builtin_ctz(mask);
+        }
+    }
+    return count + FindAtLeastFrom(counters, i, n, threshold, out + count);
+}
+
+/** Returns the population count of each 64-bit lane of v, using the
+ *  nibble lookup method of Mula et al.
+ */
+BLOOM_TARGET_AVX2
+inline __m256i PopCount256(__m256i v){
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+BLOOM_TARGET_AVX2
+inline uint64_t HorizontalSum256(__m256i v){
+    return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1)
+         + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+
+template <bool CountAnd, bool CountA>
+BLOOM_TARGET_AVX2
+inline void PopCountPairAvx2(uint64_t const *a, uint64_t const *b, size_t n,
+                             uint64_t &andCount, uint64_t &orCount, uint64_t &aCount){
+    size_t i = 0;
+    __m256i andSum = _mm256_setzero_si256(), orSum = _mm256_setzero_si256(), aSum = _mm256_setzero_si256();
+    for(; i + 4 <= n; i += 4){
+        __m256i x = _mm256_loadu_si256((__m256i const *) (a + i));
+        __m256i y = _mm256_loadu_si256((__m256i const *) (b + i));
+        if(CountAnd){
+            andSum = _mm256_add_epi64(andSum, PopCount256(_mm256_and_si256(x, y)));
+        }
+        orSum = _mm256_add_epi64(orSum, PopCount256(_mm256_or_si256(x, y)));
+        if(CountA){
+            aSum = _mm256_add_epi64(aSum, PopCount256(x));
+        }
+    }
+    PopCountPairSse42<CountAnd, CountA>(a + i, b + i, n - i, andCount, orCount, aCount);
+    andCount += HorizontalSum256(andSum);
+    orCount += HorizontalSum256(orSum);
+    aCount += HorizontalSum256(aSum);
+}
+
+BLOOM_TARGET_AVX2
+inline uint64_t PopCountAvx2(uint64_t const *words, size_t n){
+    size_t i = 0;
+    __m256i sum = _mm256_setzero_si256();
+    for(; i + 4 <= n; i += 4){
+        sum = _mm256_add_epi64(sum, PopCount256(_mm256_loadu_si256((__m256i const *) (words + i))));
+    }
+    return HorizontalSum256(sum) + PopCountSse42(words + i, n - i);
+}
+
+BLOOM_TARGET_AVX2
+inline bool TestBitsAvx2(uint32_t const *words, uint16_t const *bits, size_t n){
+    int const *base = (int const *) words;
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i low = _mm256_set1_epi32(31);
+    for(size_t i = 0; i < n; i += 8){
+        __m256i pos = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *) (bits + i)));
+        __m256i probe = _mm256_i32gather_epi32(base, _mm256_srli_epi32(pos, 5), 4);
+        probe = _mm256_and_si256(_mm256_srlv_epi32(probe, _mm256_and_si256(pos, low)), one);
+        if(!_mm256_testc_si256(probe, one)){
+            return false;
+        }
+    }
+    return true;
+}
+
+BLOOM_TARGET_AVX2
+inline void OrWordsAvx2(uint32_t *dst, uint32_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_or_si256(a, b));
+    }
+    OrWordsScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX2
+inline void UnionWordsAvx2(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    __m256i zero = _mm256_setzero_si256();
+    for(; i + 4 <= n; i += 4){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        unsigned same = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_andnot_si256(a, b), zero)));
+        if(same != 0xf){
+            _mm256_storeu_si256((__m256i *) (dst + i), _mm256_or_si256(a, b));
+            MarkChanged(changed, first + i, ~same & 0xf);
+        }
+    }
+    UnionWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+BLOOM_TARGET_AVX2
+inline void IntersectWordsAvx2(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    __m256i zero = _mm256_setzero_si256();
+    for(; i + 4 <= n; i += 4){
+        __m256i a = _mm256_loadu_si256((__m256i const *) (dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i const *) (src + i));
+        unsigned same = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_andnot_si256(b, a), zero)));
+        if(same != 0xf){
+            _mm256_storeu_si256((__m256i *) (dst + i), _mm256_and_si256(a, b));
+            MarkChanged(changed, first + i, ~same & 0xf);
+        }
+    }
+    IntersectWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+// AVX-512 variants
+
+BLOOM_TARGET_AVX512
+inline void CountersToBitsAvx512(uint8_t const *counters, size_t n, uint64_t *words){
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        __m512i v = _mm512_loadu_si512((void const *) (counters + i));
+        words[i / 64] = _mm512_test_epi8_mask(v, v);
+    }
+    CountersToBitsScalar(counters + i, n - i, words + i / 64);
+}
+
+BLOOM_TARGET_AVX512
+inline void SaturatingAddAvx512(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_adds_epu8(a, b));
+    }
+    SaturatingAddScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX512
+inline void SaturatingSubtractAvx512(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_subs_epu8(a, b));
+    }
+    SaturatingSubtractScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX512
+inline void MinimumAvx512(uint8_t *dst, uint8_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_min_epu8(a, b));
+    }
+    MinimumScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX512
+inline size_t FindAtLeastAvx512(uint8_t const *counters, size_t n, uint8_t threshold, uint32_t *out){
+    size_t count = 0;
+    size_t i = 0;
+    __m512i t = _mm512_set1_epi8((char) threshold);
+    for(; i + 64 <= n; i += 64){
+        __m512i v = _mm512_loadu_si512((void const *) (counters + i));
+        uint64_t mask = _mm512_cmpge_epu8_mask(v, t);
+        for(; mask; mask &= mask - 1){
+            out[count++] = i + __builtin_ctzll(mask);
+        }
+    }
+    return count + FindAtLeastFrom(counters, i, n, threshold, out + count);
+}
+
+// _mm512_reduce_add_epi64 trips -Wuninitialized in some GCC versions
+BLOOM_TARGET_AVX512
+inline uint64_t HorizontalSum512(__m512i v){
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512((void *) lanes, v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+template <bool CountAnd, bool CountA>
+BLOOM_TARGET_AVX512_POPCNT
+inline void PopCountPairAvx512(uint64_t const *a, uint64_t const *b, size_t n,
+                               uint64_t &andCount, uint64_t &orCount, uint64_t &aCount){
+    size_t i = 0;
+    __m512i andSum = _mm512_setzero_si512(), orSum = _mm512_setzero_si512(), aSum = _mm512_setzero_si512();
+    for(; i + 8 <= n; i += 8){
+        __m512i x = _mm512_loadu_si512((void const *) (a + i));
+        __m512i y = _mm512_loadu_si512((void const *) (b + i));
+        if(CountAnd){
+            andSum = _mm512_add_epi64(andSum, _mm512_popcnt_epi64(_mm512_and_si512(x, y)));
+        }
+        orSum = _mm512_add_epi64(orSum, _mm512_popcnt_epi64(_mm512_or_si512(x, y)));
+        if(CountA){
+            aSum = _mm512_add_epi64(aSum, _mm512_popcnt_epi64(x));
+        }
+    }
+    PopCountPairSse42<CountAnd, CountA>(a + i, b + i, n - i, andCount, orCount, aCount);
+    andCount += HorizontalSum512(andSum);
+    orCount += HorizontalSum512(orSum);
+    aCount += HorizontalSum512(aSum);
+}
+
+BLOOM_TARGET_AVX512_POPCNT
+inline uint64_t PopCountAvx512(uint64_t const *words, size_t n){
+    size_t i = 0;
+    __m512i sum = _mm512_setzero_si512();
+    for(; i + 8 <= n; i += 8){
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_loadu_si512((void const *) (words + i))));
+    }
+    return HorizontalSum512(sum) + PopCountSse42(words + i, n - i);
+}
+
+BLOOM_TARGET_AVX512
+inline bool TestBitsAvx512(uint32_t const *words, uint16_t const *bits, size_t n){
+    int const *base = (int const *) words;
+    __m512i one = _mm512_set1_epi32(1);
+    __m512i low = _mm512_set1_epi32(31);
+    for(size_t i = 0; i < n; i += 16){
+        __m512i pos = _mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const *) (bits + i)));
+        __m512i probe = _mm512_i32gather_epi32(_mm512_srli_epi32(pos, 5), base, 4);
+        probe = _mm512_srlv_epi32(probe, _mm512_and_si512(pos, low));
+        if(_mm512_test_epi32_mask(probe, one) != 0xFFFF){
+            return false;
+        }
+    }
+    return true;
+}
+
+BLOOM_TARGET_AVX512
+inline void OrWordsAvx512(uint32_t *dst, uint32_t const *src, size_t n){
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_or_si512(a, b));
+    }
+    OrWordsScalar(dst + i, src + i, n - i);
+}
+
+BLOOM_TARGET_AVX512
+inline void UnionWordsAvx512(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        __m512i gained = _mm512_andnot_si512(a, b);
+        unsigned mask = _mm512_test_epi64_mask(gained, gained);
+        if(mask){
+            _mm512_storeu_si512((void *) (dst + i), _mm512_or_si512(a, b));
+            MarkChanged(changed, first + i, mask);
+        }
+    }
+    UnionWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+BLOOM_TARGET_AVX512
+inline void IntersectWordsAvx512(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first){
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m512i a = _mm512_loadu_si512((void const *) (dst + i));
+        __m512i b = _mm512_loadu_si512((void const *) (src + i));
+        __m512i lost = _mm512_andnot_si512(b, a);
+        unsigned mask = _mm512_test_epi64_mask(lost, lost);
+        if(mask){
+            _mm512_storeu_si512((void *) (dst + i), _mm512_and_si512(a, b));
+            MarkChanged(changed, first + i, mask);
+        }
+    }
+    IntersectWordsScalar(dst + i, src + i, n - i, changed, first + i);
+}
+
+#endif // BLOOM_SIMD_X86
+
+/** The variants of every dispatched kernel for one instruction set
+ */
+struct Kernels {
+    void (*countersToBits)(uint8_t const *, size_t, uint64_t *);
+    void (*saturatingAdd)(uint8_t *, uint8_t const *, size_t);
+    void (*saturatingSubtract)(uint8_t *, uint8_t const *, size_t);
+    void (*minimum)(uint8_t *, uint8_t const *, size_t);
+    size_t (*findAtLeast)(uint8_t const *, size_t, uint8_t, uint32_t *);
+    void (*popCountOr)(uint64_t const *, uint64_t const *, size_t, uint64_t &, uint64_t &, uint64_t &);
+    void (*popCountAndOr)(uint64_t const *, uint64_t const *, size_t, uint64_t &, uint64_t &, uint64_t &);
+    void (*popCountAndOrFirst)(uint64_t const *, uint64_t const *, size_t, uint64_t &, uint64_t &, uint64_t &);
+    uint64_t (*popCount)(uint64_t const *, size_t);
+    bool (*testBits)(uint32_t const *, uint16_t const *, size_t);
+    void (*orWords)(uint32_t *, uint32_t const *, size_t);
+    void (*unionWords)(uint64_t *, uint64_t const *, size_t, uint64_t *, size_t);
+    void (*intersectWords)(uint64_t *, uint64_t const *, size_t, uint64_t *, size_t);
+};
+
+// S names the variants of most kernels, and P those of the popcounts
+#define BLOOM_SIMD_KERNELS(S, P) { \
+    CountersToBits##S, SaturatingAdd##S, SaturatingSubtract##S, Minimum##S, FindAtLeast##S, \
+    PopCountPair##P<false, false>, PopCountPair##P<true, false>, PopCountPair##P<true, true>, PopCount##P, \
+    TestBits##S, OrWords##S, UnionWords##S, IntersectWords##S }
+
+/** Kernel tables indexed by Isa; instruction sets the kernels were not
+ *  compiled for fall back to the portable variants. AVX-512 CPUs without
+ *  VPOPCNTDQ, such as Skylake-SP and Cascade Lake, count bits with AVX2.
+ */
+inline constexpr Kernels KernelTables[NumIsas] = {
+    BLOOM_SIMD_KERNELS(Scalar, Scalar),
+#if defined(BLOOM_SIMD_X86)
+    BLOOM_SIMD_KERNELS(Sse42, Sse42),
+    BLOOM_SIMD_KERNELS(Avx2, Avx2),
+    BLOOM_SIMD_KERNELS(Avx512, Avx2),
+    BLOOM_SIMD_KERNELS(Avx512, Avx512),
+#else
+    BLOOM_SIMD_KERNELS(Scalar, Scalar),
+    BLOOM_SIMD_KERNELS(Scalar, Scalar),
+    BLOOM_SIMD_KERNELS(Scalar, Scalar),
+    BLOOM_SIMD_KERNELS(Scalar, Scalar),
+#endif
+};
+
+#undef BLOOM_SIMD_KERNELS
+
+/** Kernels in use, or null until the first kernel call detects them
+ */
+inline std::atomic<Kernels const *> activeKernels{nullptr};
+
+inline Kernels const& Active(){
+    Kernels const *k = activeKernels.load(std::memory_order_relaxed);
+    if(!k){
+        k = &KernelTables[DetectIsa()];
+        activeKernels.store(k, std::memory_order_relaxed);
+    }
+    return *k;
+}
+
+} // namespace detail
+
+/** Returns the instruction set of the kernels in use
+ */
+inline Isa GetIsa(){
+    return (Isa) (&detail::Active() - detail::KernelTables);
+}
+
+/** Makes every thread use the kernels of a supported instruction set from
+ *  now on. All variants give the same results, so this is only useful to
+ *  test or benchmark them, or to work around a CPU problem.
+ *
+ *  @param  isa Instruction set to use
+ *  @return false, with no change made, if the instruction set is not
+ *          supported
+ */
+inline bool SetIsa(Isa isa){
+    if(isa >= NumIsas || !IsSupported(isa)){
+        return false;
+    }
+    detail::activeKernels.store(&detail::KernelTables[isa], std::memory_order_relaxed);
+    return true;
+}
+
+/** Converts an array of counters into a bit array in which bit i (counting
+ *  from the least significant bit of words[0]) is set iff counters[i] is
+ *  nonzero. Bits past the last counter in the final word are cleared.
+ *
+ *  @param counters Counter array
+ *  @param n        Number of counters
+ *  @param words    Output bit array, holding at least (n + 63) / 64 words
+ */
+inline void CountersToBits(uint8_t const *counters, size_t n, uint64_t *words){
+    detail::Active().countersToBits(counters, n, words);
+}
+
+/** Adds src into dst elementwise, clamping each result at 255.
+ *
+ *  @param dst Counters to update
+ *  @param src Counters to add
+ *  @param n   Number of counters
+ */
+inline void SaturatingAdd(uint8_t *dst, uint8_t const *src, size_t n){
+    detail::Active().saturatingAdd(dst, src, n);
+}
+
+/** Subtracts src from dst elementwise, clamping each result at 0.
+ *
+ *  @param dst Counters to update
+ *  @param src Counters to subtract
+ *  @param n   Number of counters
+ */
+inline void SaturatingSubtract(uint8_t *dst, uint8_t const *src, size_t n){
+    detail::Active().saturatingSubtract(dst, src, n);
+}
+
+/** Replaces each counter in dst with the minimum of itself and the
+ *  corresponding counter in src.
+ *
+ *  @param dst Counters to update
+ *  @param src Counters to compare against
+ *  @param n   Number of counters
+ */
+inline void Minimum(uint8_t *dst, uint8_t const *src, size_t n){
+    detail::Active().minimum(dst, src, n);
+}
+
+/** Writes the index of every counter which is at least threshold to out,
+ *  in increasing order, skipping whole vectors of smaller counters.
+ *
+ *  @param  counters  Counter array
+ *  @param  n         Number of counters
+ *  @param  threshold Smallest counter value to report
+ *  @param  out       Output indexes, with room for up to n entries
+ *  @return Number of indexes written
+ */
+inline size_t FindAtLeast(uint8_t const *counters, size_t n, uint8_t threshold, uint32_t *out){
+    return detail::Active().findAtLeast(counters, n, threshold, out);
+}
+
+/** Counts the occurrences of each counter value. Scattered increments do
+ *  not vectorize, so this kernel is not dispatched.
+ *
+ *  @param counters Counter array
+ *  @param n        Number of counters
+ *  @param hist     Output histogram of 256 entries, which is added to
+ */
+inline void Histogram(uint8_t const *counters, size_t n, uint64_t *hist){
+    // separate tables for interleaved counters avoid store-to-load stalls
+    // on runs of equal values
+    uint64_t part[4][256] = {};
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        part[0][counters[i]]++;
+        part[1][counters[i + 1]]++;
+        part[2][counters[i + 2]]++;
+        part[3][counters[i + 3]]++;
+    }
+    for(; i < n; i++){
+        part[0][counters[i]]++;
+    }
+    for(unsigned v = 0; v < 256; v++){
+        hist[v] += part[0][v] + part[1][v] + part[2][v] + part[3][v];
+    }
+}
+
+/** Counts the set bits of a and b combined by AND and by OR, i.e. the
+ *  sizes of the intersection and union of two bit arrays.
+ *
+ *  @param a          First bit array
+ *  @param b          Second bit array
+ *  @param n          Number of words in each array
+ *  @param andCount   Receives the number of bits set in both arrays
+ *  @param orCount    Receives the number of bits set in either array
+ */
+inline void PopCountAndOr(uint64_t const *a, uint64_t const *b, size_t n, uint64_t &andCount, uint64_t &orCount){
+    uint64_t aCount;
+    detail::Active().popCountAndOr(a, b, n, andCount, orCount, aCount);
+}
+
+/** Counts the set bits of a and b combined by AND and by OR, and those of
+ *  a alone, in a single pass. Those of b alone follow, as
+ *  andCount + orCount - aCount.
+ *  @see PopCountAndOr
+ */
+inline void PopCountAndOr(uint64_t const *a, uint64_t const *b, size_t n, uint64_t &andCount, uint64_t &orCount,
+                          uint64_t &aCount){
+    detail::Active().popCountAndOrFirst(a, b, n, andCount, orCount, aCount);
+}
+
+/** Counts the set bits of a and b combined by OR, i.e. the size of the
+ *  union of two bit arrays.
+ */
+inline uint64_t PopCountOr(uint64_t const *a, uint64_t const *b, size_t n){
+    uint64_t andCount, orCount, aCount;
+    detail::Active().popCountOr(a, b, n, andCount, orCount, aCount);
+    return orCount;
+}
+
+/** Counts the set bits of a bit array.
+ *
+ *  @param  words Bit array
+ *  @param  n     Number of words
+ *  @return Number of bits set
+ */
+inline uint64_t PopCount(uint64_t const *words, size_t n){
+    return detail::Active().popCount(words, n);
+}
+
+/** Tests whether every listed bit of a bit array of 32-bit words is set,
+ *  gathering several probes at once where the instruction set allows.
+ *
+ *  @param  words Bit array, packed least significant bit first
+ *  @param  bits  Indexes of the bits to test, padded to a multiple of 16
+ *                entries with copies of one of them
+ *  @param  n     Number of indexes before the padding
+ *  @return true iff every bit is set
+ */
+inline bool TestBits(uint32_t const *words, uint16_t const *bits, size_t n){
+    return detail::Active().testBits(words, bits, n);
+}
+
+/** Sets dst to the bitwise OR of dst and src.
+ *
+ *  @param dst Bit array to update
+ *  @param src Bit array to add
+ *  @param n   Number of 32-bit words in each array
+ */
+inline void OrWords(uint32_t *dst, uint32_t const *src, size_t n){
+    detail::Active().orWords(dst, src, n);
+}
+
+/** Sets dst to the bitwise OR of dst and src, and records which words of
+ *  dst changed: bit first + i of the bitmap changed is set if word i did.
+ *
+ *  @param dst     Bit array to update
+ *  @param src     Bit array to add
+ *  @param n       Number of words in each array
+ *  @param changed Bitmap of changed words, which is added to
+ *  @param first   Position in changed of the bit for dst[0]
+ */
+inline void UnionWords(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first = 0){
+    detail::Active().unionWords(dst, src, n, changed, first);
+}
+
+/** Sets dst to the bitwise AND of dst and src, and records which words of
+ *  dst changed.
+ *  @see UnionWords
+ */
+inline void IntersectWords(uint64_t *dst, uint64_t const *src, size_t n, uint64_t *changed, size_t first = 0){
+    detail::Active().intersectWords(dst, src, n, changed, first);
+}
+
+/** Transposes a 64x64 bit matrix in place, where bit j of m[i] is the
+ *  element in row i and column j. Uses the recursive block swap from
+ *  Hacker's Delight, 6 rounds of 32 word pairs.
+ *
+ *  @param m Matrix of 64 words
+ */
+inline void Transpose64(uint64_t *m){
+    uint64_t mask = 0x00000000FFFFFFFFull;
+    for(unsigned width = 32; width; width >>= 1, mask ^= mask << width){
+        for(unsigned i = 0; i < 64; i = (i + width + 1) & ~width){
+            uint64_t t = ((m[i] >> width) ^ m[i + width]) & mask;
+            m[i] ^= t << width;
+            m[i + width] ^= t;
+        }
+    }
+}
+
+} // namespace simd
+
+} // namespace bloom
+
+#if defined(BLOOM_SIMD_X86) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef SlidingWindowBloomFilter_hpp
+#define SlidingWindowBloomFilter_hpp
+
+#include <vector>
+#include "AbstractBloomFilter.hpp"
+#include "Statistics.hpp"
+
+namespace bloom {
+
+/** A sliding-window Bloom filter. Represents a fixed number of generations,
+ *  each of which behaves like an ordinary Bloom filter over the same bit
+ *  positions. Rather than keeping one bit array per generation, each position
+ *  holds a 32-bit cell in which bit g belongs to generation g, so a query
+ *  touches exactly one cell per hash regardless of the number of generations.
+ *
+ *  Insertions go into the current generation. Calling Advance() expires the
+ *  oldest generation and makes it the new current one, so an object is
+ *  reported as present until it has been out of the window for
+ *  GetNumGenerations() advances.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class SlidingWindowBloomFilter : public AbstractBloomFilter<T> {
+
+public:
+
+    /** Maximum number of generations which may be tracked by a filter
+     */
+    static const uint8_t MaxGenerations = 32;
+
+    /** Constructor
+     *  @see AbstractBloomFilter::AbstractBloomFilter
+     *
+     *  @param numGenerations Number of generations in the window. Must be
+     *                        between 1 and MaxGenerations (inclusive).
+     */
+    explicit
+    SlidingWindowBloomFilter(uint8_t numHashes, uint16_t numBits, uint8_t numGenerations)
+    : AbstractBloomFilter<T>(numHashes, numBits)
+    , m_numGenerations(numGenerations)
+    , m_current(0)
+    , m_cells(numBits, 0)
+    {}
+
+    /** Inserts an object into the current generation.
+     *
+     *  @param o Object to insert
+     */
+    virtual void Insert(T const& o) {
+        InsertKey(o);
+    }
+
+    /** Inserts an object given by an equivalent key type.
+     *  @see OrdinaryBloomFilter::Insert
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    void Insert(K const& key) {
+        InsertKey(key);
+    }
+
+    /** Inserts an object by its precomputed digest.
+     *  @see OrdinaryBloomFilter::InsertHash
+     */
+    void InsertHash(uint64_t digest) {
+        InsertKey(HashDigest{digest});
+    }
+
+    /** Queries whether an object was inserted into any generation which is
+     *  still inside the window. Each generation is checked simultaneously by
+     *  intersecting the generation masks of the object's cells.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    virtual bool Query(T const& o) const {
+        return QueryKey(o);
+    }
+
+    /** Queries for an object given by an equivalent key type.
+     *  @see SlidingWindowBloomFilter::Query
+     */
+    template <typename K, typename = EnableIfTransparent<K, T>>
+    bool Query(K const& key) const {
+        return QueryKey(key);
+    }
+
+    /** Queries for an object by its precomputed digest.
+     *  @see SlidingWindowBloomFilter::Query
+     */
+    bool QueryHash(uint64_t digest) const {
+        return QueryKey(HashDigest{digest});
+    }
+
+    /** Expires the oldest generation and makes it the current generation.
+     *  The cost is a single masking pass over the cell array, amortized
+     *  over every insertion made into the generation being expired.
+     */
+    void Advance() {
+        m_current = (m_current + 1) % m_numGenerations;
+        uint32_t keep = ~(uint32_t(1) << m_current);
+        for(uint32_t &cell : m_cells){
+            cell &= keep;
+        }
+    }
+
+    /** Returns the number of generations in the window
+     */
+    uint8_t GetNumGenerations() const {
+        return m_numGenerations;
+    }
+
+    virtual void Serialize(std::ostream &os) const {
+        uint8_t numHashes = super::GetNumHashes();
+        uint16_t numBits = super::GetNumBits();
+
+        os.write((const char *) &numHashes, sizeof(uint8_t));
+        os.write((const char *) &numBits, sizeof(uint16_t));
+        os.write((const char *) &m_numGenerations, sizeof(uint8_t));
+        os.write((const char *) &m_current, sizeof(uint8_t));
+
+        for(uint16_t i = 0; i < numBits; i++){
+            uint32_t cell = m_cells[i];
+            os.write((const char *) &cell, sizeof(uint32_t));
+        }
+    }
+
+    /** Create a SlidingWindowBloomFilter from the content of a binary input
+     *  stream. No validation is performed.
+     *
+     *  @param  is Input stream to read from
+     *  @return Deserialized SlidingWindowBloomFilter
+     */
+    static SlidingWindowBloomFilter<T> Deserialize(std::istream &is){
+        uint8_t numHashes;
+        uint16_t numBits;
+        uint8_t numGenerations;
+        uint8_t current;
+
+        is.read((char *) &numHashes, sizeof(uint8_t));
+        is.read((char *) &numBits, sizeof(uint16_t));
+        is.read((char *) &numGenerations, sizeof(uint8_t));
+        is.read((char *) &current, sizeof(uint8_t));
+
+        SlidingWindowBloomFilter<T> r (numHashes, numBits, numGenerations);
+        r.m_current = current;
+
+        for(uint16_t i = 0; i < numBits; i++){
+            uint32_t cell;
+            is.read((char *) &cell, sizeof(uint32_t));
+            r.m_cells[i] = cell;
+        }
+
+        return r;
+    }
+
+private:
+
+    typedef AbstractBloomFilter<T> super;
+
+    template <typename K>
+    void InsertKey(K const& key) {
+        stats::RecordInsert(stats::SlidingWindow);
+        uint32_t mask = uint32_t(1) << m_current;
+        for(uint8_t i = 0; i < super::GetNumHashes(); i++){
+            m_cells[super::ComputeHash(key, i)] |= mask;
+        }
+    }
+
+    template <typename K>
+    bool QueryKey(K const& key) const {
+        uint32_t live = ~uint32_t(0);
+        uint8_t i = 0;
+        for(; i < super::GetNumHashes() && live; i++){
+            live &= m_cells[super::ComputeHash(key, i)];
+        }
+        stats::RecordQuery(stats::SlidingWindow, i, live != 0);
+        return live != 0;
+    }
+
+    /** Number of generations in the window
+     */
+    uint8_t m_numGenerations;
+
+    /** Generation currently receiving insertions
+     */
+    uint8_t m_current;
+
+    /** One generation mask per bit position
+     */
+    std::vector<uint32_t> m_cells;
+
+
+}; // class SlidingWindowBloomFilter
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SnapshotWriter_hpp
+#define SnapshotWriter_hpp
+
+#include <string>
+#include <memory>
+#include <future>
+#include <sstream>
+#include <cerrno>
+#include <unistd.h>
+
+namespace bloom {
+
+/** Writes a point-in-time snapshot of a Bloom filter in the filter's own
+ *  Serialize format, in chunks, without holding up further updates to the
+ *  filter.
+ *
+ *  Constructing a SnapshotWriter copies the filter, which is the only step
+ *  that must be synchronized with writers of the live filter; the encoding
+ *  and output happen later, from any thread, against the private copy.
+ *  Output is produced by repeated calls to WriteChunk, each of which
+ *  resumes where the previous one stopped, so a failed or interrupted write
+ *  can simply be retried.
+ *
+ *  @param BF Bloom filter type being written
+ */
+template <typename BF>
+class SnapshotWriter {
+
+public:
+
+    /** Constructor: takes a snapshot of the given filter.
+     *
+     *  @param bf        Filter to snapshot
+     *  @param chunkSize Maximum number of bytes written by each WriteChunk
+     */
+    explicit
+    SnapshotWriter(BF const& bf, size_t chunkSize = 65536)
+    : m_snapshot(bf)
+    , m_chunkSize(chunkSize)
+    , m_encoded(false)
+    , m_offset(0)
+    {}
+
+    /** Writes the next chunk of the snapshot to an output stream.
+     *
+     *  @param  os Output stream
+     *  @return true once the whole snapshot has been written; false if more
+     *          chunks remain or the stream failed, in which case the stream
+     *          state tells the two apart.
+     */
+    bool WriteChunk(std::ostream &os){
+        Encode();
+        size_t len = NextChunkSize();
+        if(!os.write(m_buffer.data() + m_offset, len)){
+            return false;
+        }
+        m_offset += len;
+        return Done();
+    }
+
+    /** Writes the next chunk of the snapshot to a file descriptor, using
+     *  positional writes starting at the given base offset in the file. Short
+     *  and interrupted writes are resumed on the next call.
+     *
+     *  @param  fd   File descriptor open for writing
+     *  @param  base Offset in the file at which the snapshot starts
+     *  @return true once the whole snapshot has been written; false if more
+     *          chunks remain or the write failed, in which case errno is
+     *          nonzero.
+     */
+    bool WriteChunk(int fd, off_t base = 0){
+        Encode();
+        errno = 0;
+        ssize_t n = pwrite(fd, m_buffer.data() + m_offset, NextChunkSize(), base + m_offset);
+        if(n < 0){
+            if(errno == EINTR){
+                errno = 0;
+            }
+            return false;
+        }
+        m_offset += n;
+        return Done();
+    }
+
+    /** Returns the number of bytes of the snapshot written so far
+     */
+    size_t GetOffset() const {
+        return m_offset;
+    }
+
+    /** Returns true once the whole snapshot has been written
+     */
+    bool Done() const {
+        return m_encoded && m_offset == m_buffer.size();
+    }
+
+private:
+
+    /** Serializes the snapshot on first use, so that the cost is paid by
+     *  the thread doing the writing rather than the one taking the
+     *  snapshot.
+     */
+    void Encode(){
+        if(!m_encoded){
+            std::ostringstream os;
+            m_snapshot.Serialize(os);
+            m_buffer = os.str();
+            m_encoded = true;
+        }
+    }
+
+    size_t NextChunkSize() const {
+        size_t remaining = m_buffer.size() - m_offset;
+        return remaining < m_chunkSize ? remaining : m_chunkSize;
+    }
+
+    /** Private copy of the filter taken at construction
+     */
+    BF m_snapshot;
+
+    size_t m_chunkSize;
+    bool m_encoded;
+
+    /** Serialized snapshot
+     */
+    std::string m_buffer;
+
+    /** Number of bytes of m_buffer already written
+     */
+    size_t m_offset;
+
+}; // class SnapshotWriter
+
+/** Snapshots a filter and serializes the snapshot to an output stream on a
+ *  background thread. The filter may be modified as soon as this function
+ *  returns; the stream must remain valid until the returned future is
+ *  ready.
+ *
+ *  @param  bf Filter to snapshot
+ *  @param  os Output stream
+ *  @return A future which becomes ready when the snapshot has been written,
+ *          holding false if the stream failed.
+ */
+template <typename BF>
+std::future<bool> SerializeAsync(BF const& bf, std::ostream &os){
+    auto writer = std::make_shared<SnapshotWriter<BF>>(bf);
+    return std::async(std::launch::async, [writer, &os]{
+        while(!writer->WriteChunk(os)){
+            if(!os){
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+} // namespace bloom
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef StaticBloomFilter_hpp
+#define StaticBloomFilter_hpp
+
+#include <array>
+#include <ostream>
+#include <initializer_list>
+#include "AbstractBloomFilter.hpp"
+
+namespace bloom {
+
+/** An ordinary Bloom filter whose geometry is fixed at compile time and
+ *  whose storage is a std::array, so that it can be built in a constant
+ *  expression. A constexpr StaticBloomFilter over a fixed list of objects,
+ *  such as a deny-list, is then stored in read-only data, with no heap
+ *  allocation and no construction at startup.
+ *
+ *  Indexes are derived as in OrdinaryBloomFilter, so both answer queries
+ *  alike and serialize to the same bytes. Building at compile time
+ *  requires a constexpr std::hash specialization for HashParams<T>, such
+ *  as one based on FnvHash32; the default one is not constexpr.
+ *
+ *  @param T         Contained type being indexed
+ *  @param NumHashes Number of hashes
+ *  @param NumBits   Number of bits
+ */
+template <typename T, uint8_t NumHashes, uint16_t NumBits>
+class StaticBloomFilter {
+
+public:
+
+    /** Constructor: creates an empty BF.
+     */
+    constexpr StaticBloomFilter()
+    : m_words{}
+    {}
+
+    /** Constructor: creates a BF containing the given objects.
+     *
+     *  @param objects Objects to insert
+     */
+    constexpr StaticBloomFilter(std::initializer_list<T> objects)
+    : m_words{}
+    {
+        for(T const& o : objects){
+            Insert(o);
+        }
+    }
+
+    static constexpr uint8_t GetNumHashes() {
+        return NumHashes;
+    }
+
+    static constexpr uint16_t GetNumBits() {
+        return NumBits;
+    }
+
+    /** Inserts an object.
+     *
+     *  @param o Object to insert
+     */
+    constexpr void Insert(T const& o) {
+        for(uint8_t i = 0; i < NumHashes; i++){
+            unsigned bit = HashIndex(o, i, NumBits);
+            m_words[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /** Queries whether an object is indexed by this Bloom filter. Can return
+     *  a false positive, but not a false negative.
+     *
+     *  @param  o Object to query
+     *  @return true if object is indexed, false if the object is not indexed.
+     */
+    constexpr bool Query(T const& o) const {
+        for(uint8_t i = 0; i < NumHashes; i++){
+            unsigned bit = HashIndex(o, i, NumBits);
+            if(!((m_words[bit / 64] >> (bit % 64)) & 1)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Writes this BF in the OrdinaryBloomFilter format, so that it can be
+     *  read with OrdinaryBloomFilter::Deserialize.
+     *
+     *  @param os output stream to serialize the BF into
+     */
+    void Serialize(std::ostream &os) const {
+        uint8_t numHashes = NumHashes;
+        uint16_t numBits = NumBits;
+
+        os.write((const char *) &numHashes, sizeof(uint8_t));
+        os.write((const char *) &numBits, sizeof(uint16_t));
+
+        for(unsigned i = 0; i < (numBits + 7u) / 8; i++){
+            uint8_t byte = 0;
+            for(unsigned j = 0; j < 8 && 8 * i + j < numBits; j++){
+                byte |= ((m_words[(8 * i + j) / 64] >> ((8 * i + j) % 64)) & 1) << (7 - j);
+            }
+            os.write((const char *) &byte, sizeof(uint8_t));
+        }
+    }
+
+private:
+
+    /** Bit array, packed least significant bit first
+     */
+    std::array<uint64_t, (NumBits + 63) / 64> m_words;
+
+}; // class StaticBloomFilter
+
+} // namespace bloom
+
+#endif
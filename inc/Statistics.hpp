@@ -0,0 +1,309 @@
+#ifndef Statistics_hpp
+#define Statistics_hpp
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_set>
+#include <functional>
+#include <stdexcept>
+#include "AbstractBloomFilter.hpp"
+
+namespace bloom {
+
+/** Operation statistics for the Bloom filter implementations.
+ *
+ *  Collection is compiled in only when BLOOM_STATISTICS is defined before
+ *  the first library header is included; otherwise every hook is an empty
+ *  inline function and costs nothing. All translation units of a program
+ *  must agree on whether BLOOM_STATISTICS is defined.
+ *
+ *  Each thread increments its own block of counters with plain relaxed
+ *  stores, and Collect() sums the blocks of all threads without locking.
+ *  Counters are kept per filter type, not per filter instance.
+ */
+namespace stats {
+
+#ifdef BLOOM_STATISTICS
+constexpr bool Enabled = true;
+#else
+constexpr bool Enabled = false;
+#endif
+
+/** Filter types for which statistics are kept separately
+ */
+enum FilterKind {
+    Ordinary,
+    Counting,
+    Paired,
+    SlidingWindow,
+    Partitioned,
+    Layered,
+    InterleavedPaired,
+    ConcurrentPaired,
+    NumFilterKinds
+};
+
+/** Statistics for one filter type, as returned by Collect()
+ */
+struct Summary {
+    uint64_t inserts = 0;          //!< Insert calls
+    uint64_t queries = 0;          //!< Query calls
+    uint64_t positives = 0;        //!< Query calls which returned true
+    uint64_t deletes = 0;          //!< Delete calls
+    uint64_t failedDeletes = 0;    //!< Delete calls on absent objects
+    uint64_t negativeRejects = 0;  //!< Paired queries rejected by the negative array
+
+    /** probeDepth[d] is the number of queries which examined d probes
+     *  before answering: either the first probe found clear, or all k
+     *  probes for a positive answer.
+     */
+    std::vector<uint64_t> probeDepth = std::vector<uint64_t>(257, 0);
+};
+
+namespace detail {
+
+enum Counter {
+    Inserts,
+    Queries,
+    Positives,
+    Deletes,
+    FailedDeletes,
+    NegativeRejects,
+    NumCounters
+};
+
+/** Counters owned by one thread at a time. Blocks are never freed; when a
+ *  thread exits its block is released for reuse by a later thread, keeping
+ *  the counts it has accumulated.
+ */
+struct ThreadBlock {
+    std::atomic<bool> inUse{true};
+    ThreadBlock *next = nullptr;
+    std::atomic<uint64_t> counters[NumFilterKinds][NumCounters] = {};
+    std::atomic<uint64_t> depths[NumFilterKinds][257] = {};
+};
+
+inline std::atomic<ThreadBlock *>& Head(){
+    static std::atomic<ThreadBlock *> head{nullptr};
+    return head;
+}
+
+/** Claims a released block, or allocates and publishes a new one.
+ */
+inline ThreadBlock *Claim(){
+    for(ThreadBlock *b = Head().load(std::memory_order_acquire); b; b = b->next){
+        bool expected = false;
+        if(b->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+            return b;
+        }
+    }
+    ThreadBlock *b = new ThreadBlock;
+    b->next = Head().load(std::memory_order_relaxed);
+    while(!Head().compare_exchange_weak(b->next, b, std::memory_order_release)){
+    }
+    return b;
+}
+
+struct ThreadHolder {
+    ThreadBlock *block = Claim();
+    ~ThreadHolder(){
+        block->inUse.store(false, std::memory_order_release);
+    }
+};
+
+inline ThreadBlock& Local(){
+    thread_local ThreadHolder holder;
+    return *holder.block;
+}
+
+/** Increments a counter which only the calling thread writes to
+ */
+inline void Bump(std::atomic<uint64_t> &c){
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+/** Records an insertion.
+ */
+inline void RecordInsert(FilterKind kind){
+    if constexpr (Enabled){
+        detail::Bump(detail::Local().counters[kind][detail::Inserts]);
+    }
+}
+
+/** Records a query which examined depth probes before answering.
+ */
+inline void RecordQuery(FilterKind kind, unsigned depth, bool result){
+    if constexpr (Enabled){
+        detail::ThreadBlock &b = detail::Local();
+        detail::Bump(b.counters[kind][detail::Queries]);
+        if(result){
+            detail::Bump(b.counters[kind][detail::Positives]);
+        }
+        detail::Bump(b.depths[kind][depth]);
+    }
+}
+
+/** Records a paired query whose positive probes were all set but which was
+ *  rejected because its negative probes were all set as well.
+ */
+inline void RecordNegativeReject(FilterKind kind){
+    if constexpr (Enabled){
+        detail::Bump(detail::Local().counters[kind][detail::NegativeRejects]);
+    }
+}
+
+/** Records a deletion, and whether the object was present.
+ */
+inline void RecordDelete(FilterKind kind, bool deleted){
+    if constexpr (Enabled){
+        detail::ThreadBlock &b = detail::Local();
+        detail::Bump(b.counters[kind][detail::Deletes]);
+        if(!deleted){
+            detail::Bump(b.counters[kind][detail::FailedDeletes]);
+        }
+    }
+}
+
+/** Sums the statistics recorded so far by all threads for a filter type.
+ *  Counts from operations running concurrently may or may not be
+ *  included.
+ *
+ *  @param  kind Filter type to summarize
+ *  @return Statistics for the filter type
+ */
+inline Summary Collect(FilterKind kind){
+    Summary s;
+    for(detail::ThreadBlock *b = detail::Head().load(std::memory_order_acquire); b; b = b->next){
+        auto get = [&](detail::Counter c){
+            return b->counters[kind][c].load(std::memory_order_relaxed);
+        };
+        s.inserts += get(detail::Inserts);
+        s.queries += get(detail::Queries);
+        s.positives += get(detail::Positives);
+        s.deletes += get(detail::Deletes);
+        s.failedDeletes += get(detail::FailedDeletes);
+        s.negativeRejects += get(detail::NegativeRejects);
+        for(unsigned d = 0; d < s.probeDepth.size(); d++){
+            s.probeDepth[d] += b->depths[kind][d].load(std::memory_order_relaxed);
+        }
+    }
+    return s;
+}
+
+/** Measures the live false positive rate of a Bloom filter by keeping an
+ *  exact set of a deterministic sample of the inserted objects. An object is
+ *  sampled if its hash with a reserved salt falls into 1 of every
+ *  sampleOneIn buckets, so the same objects are sampled on insertion and
+ *  on query. A positive answer for a sampled object absent from the exact
+ *  set is a false positive.
+ *
+ *  Operations which are not sampled take no lock.
+ *
+ *  @param T Contained type being indexed
+ */
+template <typename T>
+class FprSampler {
+
+public:
+
+    /** Constructor
+     *
+     *  @param sampleOneIn Inverse of the sampling rate, at least 1
+     *  @param maxObjects  Maximum number of objects in the exact set; once
+     *                     reached, queries stop being sampled, since
+     *                     their ground truth is no longer known
+     *
+     *  @throws std::invalid_argument if sampleOneIn is 0
+     */
+    explicit
+    FprSampler(uint32_t sampleOneIn, size_t maxObjects = 65536)
+    : m_sampleOneIn(sampleOneIn)
+    , m_maxObjects(maxObjects)
+    , m_full(false)
+    , m_negatives(0)
+    , m_falsePositives(0)
+    {
+        if(sampleOneIn == 0){
+            throw std::invalid_argument("sampling rate must be at least 1 in 1");
+        }
+    }
+
+    /** Inserts an object into a Bloom filter, recording it if sampled.
+     */
+    template <typename BF>
+    void Insert(BF &bf, T const& o){
+        bf.Insert(o);
+        uint64_t digest;
+        if(Sampled(o, digest)){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_exact.size() < m_maxObjects){
+                m_exact.insert(digest);
+            }
+            else {
+                m_full = true;
+            }
+        }
+    }
+
+    /** Queries a Bloom filter, checking the answer if the object is
+     *  sampled.
+     */
+    template <typename BF>
+    bool Query(BF const& bf, T const& o){
+        bool result = bf.Query(o);
+        uint64_t digest;
+        if(Sampled(o, digest)){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_full && !m_exact.count(digest)){
+                m_negatives++;
+                m_falsePositives += result;
+            }
+        }
+        return result;
+    }
+
+    /** Returns the fraction of sampled queries for absent objects which
+     *  were answered positively, or 0 if there were none.
+     */
+    double GetFalsePositiveRate() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_negatives ? (double) m_falsePositives / m_negatives : 0;
+    }
+
+    /** Returns the number of sampled queries for absent objects
+     */
+    uint64_t GetNumSampledNegatives() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_negatives;
+    }
+
+private:
+
+    /** Salt reserved for sampling decisions, outside the range normally
+     *  used by filters
+     */
+    static const uint8_t SamplingSalt = 255;
+
+    bool Sampled(T const& o, uint64_t &digest) const {
+        digest = std::hash<HashParams<T>>{}({o, SamplingSalt});
+        return digest % m_sampleOneIn == 0;
+    }
+
+    uint32_t m_sampleOneIn;
+    size_t m_maxObjects;
+    bool m_full;
+    uint64_t m_negatives;
+    uint64_t m_falsePositives;
+    std::unordered_set<uint64_t> m_exact;
+    mutable std::mutex m_mutex;
+
+}; // class FprSampler
+
+} // namespace stats
+
+} // namespace bloom
+
+#endif
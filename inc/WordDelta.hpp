@@ -0,0 +1,67 @@
+#ifndef WordDelta_hpp
+#define WordDelta_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+namespace bloom {
+
+namespace detail {
+
+/** Writes a delta of the words of a bit array marked in a dirty bitmap:
+ *  a uint32 count followed by a uint32 index and the uint64 word for each.
+ *  This is the delta format shared by the BF types which track modified
+ *  words.
+ *
+ *  @param os       Output stream to write the delta into
+ *  @param words    Words of the bit array
+ *  @param numWords Number of words
+ *  @param dirty    One bit per word, set if the word is to be written
+ */
+inline void WriteWordDelta(std::ostream &os, uint64_t const *words, size_t numWords, uint64_t const *dirty){
+    uint32_t numDirty = 0;
+    for(size_t w = 0; w < (numWords + 63) / 64; w++){
+        numDirty += __builtin_popcountll(dirty[w]);
+    }
+    os.write((const char *) &numDirty, sizeof(uint32_t));
+
+    for(uint32_t i = 0; i < numWords; i++){
+        if((dirty[i / 64] >> (i % 64)) & 1){
+            os.write((const char *) &i, sizeof(uint32_t));
+            os.write((const char *) &words[i], sizeof(uint64_t));
+        }
+    }
+}
+
+/** Applies a delta written by WriteWordDelta() to a bit array of the same
+ *  size, overwriting the words it contains and marking them in the dirty
+ *  bitmap. Indexes outside the array are skipped; no other validation is
+ *  performed.
+ *
+ *  @param is       Input stream to read the delta from
+ *  @param words    Words of the bit array
+ *  @param numWords Number of words
+ *  @param dirty    One bit per word, set for each word overwritten
+ */
+inline void ApplyWordDelta(std::istream &is, uint64_t *words, size_t numWords, uint64_t *dirty){
+    uint32_t numDirty;
+    is.read((char *) &numDirty, sizeof(uint32_t));
+
+    for(uint32_t n = 0; n < numDirty && is; n++){
+        uint32_t i;
+        uint64_t word;
+        is.read((char *) &i, sizeof(uint32_t));
+        is.read((char *) &word, sizeof(uint64_t));
+        if(is && i < numWords){
+            words[i] = word;
+            dirty[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+} // namespace detail
+
+} // namespace bloom
+
+#endif
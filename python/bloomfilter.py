@@ -0,0 +1,242 @@
+"""Python bindings for the bloomfilter C API (capi/bloom.h).
+
+Keys are bytes. Batch calls take the keys as one contiguous buffer plus
+arrays of offsets and lengths, or as an Arrow binary array, and pass every
+buffer to the library without copying it when it supports the buffer
+protocol. The library is called through ctypes, which releases the GIL for
+the duration of each call, so other Python threads run while a batch is
+processed. A filter must still not be used from two threads at once.
+
+The library is loaded from $BLOOM_LIBRARY, from ../capi/libbloom.so next to
+this module, or from the system library path, in that order.
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+ORDINARY, COUNTING, PAIRED = 0, 1, 2
+
+_ERRORS = {
+    -1: (ValueError, "invalid argument"),
+    -2: (NotImplementedError, "operation not supported by this filter type"),
+    -3: (BufferError, "output buffer too small"),
+    -4: (MemoryError, "allocation failed"),
+}
+
+
+def _load():
+    candidates = [
+        os.environ.get("BLOOM_LIBRARY"),
+        os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "capi", "libbloom.so"),
+        ctypes.util.find_library("bloom"),
+    ]
+    for path in candidates:
+        if path and (os.path.exists(path) or not os.path.dirname(path)):
+            return ctypes.CDLL(path)
+    raise OSError("libbloom.so not found; build it with `make capi` or set BLOOM_LIBRARY")
+
+
+_lib = _load()
+
+_p = ctypes.c_void_p
+_u64p = ctypes.POINTER(ctypes.c_uint64)
+for name, restype, argtypes in [
+    ("bloom_abi_version", ctypes.c_int, []),
+    ("bloom_create", _p, [ctypes.c_int, ctypes.c_uint8, ctypes.c_uint16]),
+    ("bloom_destroy", None, [_p]),
+    ("bloom_kind", ctypes.c_int, [_p]),
+    ("bloom_num_hashes", ctypes.c_uint8, [_p]),
+    ("bloom_num_bits", ctypes.c_uint16, [_p]),
+    ("bloom_insert", ctypes.c_int, [_p, ctypes.c_char_p, ctypes.c_size_t]),
+    ("bloom_query", ctypes.c_int, [_p, ctypes.c_char_p, ctypes.c_size_t]),
+    ("bloom_delete", ctypes.c_int, [_p, ctypes.c_char_p, ctypes.c_size_t]),
+    ("bloom_insert_batch", ctypes.c_int, [_p, _p, ctypes.c_size_t, _p, _p, ctypes.c_size_t]),
+    ("bloom_query_batch", ctypes.c_int, [_p, _p, ctypes.c_size_t, _p, _p, ctypes.c_size_t, _p]),
+    ("bloom_delete_batch", ctypes.c_int, [_p, _p, ctypes.c_size_t, _p, _p, ctypes.c_size_t, _p]),
+    ("bloom_union", ctypes.c_int, [_p, _p]),
+    ("bloom_serialize", ctypes.c_int, [_p, _p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]),
+    ("bloom_deserialize", _p, [ctypes.c_int, ctypes.c_char_p, ctypes.c_size_t]),
+]:
+    fn = getattr(_lib, name)
+    fn.restype = restype
+    fn.argtypes = argtypes
+
+
+def _check(rc):
+    if rc < 0:
+        exc, msg = _ERRORS.get(rc, (RuntimeError, "error %d" % rc))
+        raise exc(msg)
+    return rc
+
+
+class _Buffer:
+    """Address of a buffer, and the objects keeping it alive.
+
+    bytes, NumPy arrays and pyarrow Buffers are passed by address; other
+    objects supporting the buffer protocol are passed without copying if
+    they are writable, and copied otherwise. Buffers must be C-contiguous,
+    and output buffers writable.
+    """
+
+    def __init__(self, obj, itemsize=1, writable=False):
+        self.keep = obj
+        if obj is None:
+            self.address = None
+            self.nbytes = 0
+        elif isinstance(obj, bytes) and not writable:
+            self.address = ctypes.cast(ctypes.c_char_p(obj), ctypes.c_void_p).value
+            self.nbytes = len(obj)
+        elif hasattr(obj, "__array_interface__"):
+            iface = obj.__array_interface__
+            if iface.get("strides") is not None:
+                raise ValueError("array must be C-contiguous")
+            if writable and iface["data"][1]:
+                raise ValueError("output buffer must be writable")
+            self.address = iface["data"][0]
+            self.nbytes = obj.nbytes
+        elif hasattr(obj, "address") and hasattr(obj, "size") and not writable:
+            self.address = obj.address
+            self.nbytes = obj.size
+        else:
+            view = memoryview(obj).cast("B")
+            if not view.contiguous:
+                raise ValueError("buffer must be contiguous")
+            if view.readonly:
+                if writable:
+                    raise ValueError("output buffer must be writable")
+                view = memoryview(bytearray(view))
+            self.keep = (ctypes.c_char * view.nbytes).from_buffer(view)
+            self.address = ctypes.addressof(self.keep)
+            self.nbytes = view.nbytes
+        if itemsize > 1 and self.nbytes % itemsize:
+            raise ValueError("buffer size is not a multiple of %d" % itemsize)
+
+
+class BloomFilter:
+    """An ordinary, counting or paired Bloom filter over bytes keys."""
+
+    def __init__(self, kind, num_hashes, num_bits, _handle=None):
+        self._handle = _handle or _lib.bloom_create(kind, num_hashes, num_bits)
+        if not self._handle:
+            raise ValueError("cannot create filter")
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            _lib.bloom_destroy(self._handle)
+            self._handle = None
+
+    @property
+    def kind(self):
+        return _lib.bloom_kind(self._handle)
+
+    @property
+    def num_hashes(self):
+        return _lib.bloom_num_hashes(self._handle)
+
+    @property
+    def num_bits(self):
+        return _lib.bloom_num_bits(self._handle)
+
+    def insert(self, key):
+        _check(_lib.bloom_insert(self._handle, key, len(key)))
+
+    def query(self, key):
+        return bool(_check(_lib.bloom_query(self._handle, key, len(key))))
+
+    __contains__ = query
+
+    def delete(self, key):
+        return bool(_check(_lib.bloom_delete(self._handle, key, len(key))))
+
+    def _batch(self, data, offsets, lengths):
+        data, offsets = _Buffer(data), _Buffer(offsets, 8)
+        lengths = _Buffer(lengths, 8)
+        n = offsets.nbytes // 8
+        if lengths.address is None:
+            n -= 1
+        elif lengths.nbytes // 8 != n:
+            raise ValueError("offsets and lengths differ in size")
+        return data, offsets, lengths, max(n, 0)
+
+    def insert_batch(self, data, offsets, lengths=None):
+        """Inserts the keys data[offsets[i]:offsets[i] + lengths[i]].
+
+        offsets and lengths are buffers of uint64. If lengths is None,
+        offsets holds one more entry than there are keys, and key i ends at
+        offsets[i + 1], as in an Arrow large binary array.
+        """
+        data, offsets, lengths, n = self._batch(data, offsets, lengths)
+        _check(_lib.bloom_insert_batch(self._handle, data.address, data.nbytes, offsets.address, lengths.address, n))
+
+    def query_batch(self, data, offsets, lengths=None, out=None):
+        """Queries a batch of keys, as for insert_batch.
+
+        Returns out, or a new bytearray, holding 1 for each key which may
+        be present and 0 otherwise. out may be any writable buffer of n
+        bytes, such as a NumPy uint8 or bool array.
+        """
+        data, offsets, lengths, n = self._batch(data, offsets, lengths)
+        result = out if out is not None else bytearray(n)
+        results = _Buffer(result, writable=True)
+        if results.nbytes < n:
+            raise ValueError("output buffer too small")
+        _check(_lib.bloom_query_batch(self._handle, data.address, data.nbytes, offsets.address, lengths.address,
+                                      n, results.address))
+        return result
+
+    def delete_batch(self, data, offsets, lengths=None):
+        """Deletes a batch of keys, as for insert_batch, and returns a
+        bytearray holding 1 for each key which was deleted."""
+        data, offsets, lengths, n = self._batch(data, offsets, lengths)
+        result = bytearray(n)
+        results = _Buffer(result, writable=True)
+        _check(_lib.bloom_delete_batch(self._handle, data.address, data.nbytes, offsets.address,
+                                       lengths.address, n, results.address))
+        return result
+
+    def insert_arrow(self, array):
+        """Inserts every key of a pyarrow binary or large binary array."""
+        self.insert_batch(*_arrow_buffers(array))
+
+    def query_arrow(self, array, out=None):
+        """Queries every key of a pyarrow binary or large binary array."""
+        data, offsets = _arrow_buffers(array)
+        return self.query_batch(data, offsets, out=out)
+
+    def union(self, other):
+        _check(_lib.bloom_union(self._handle, other._handle))
+
+    def serialize(self):
+        size = ctypes.c_size_t()
+        _lib.bloom_serialize(self._handle, None, 0, ctypes.byref(size))
+        buf = ctypes.create_string_buffer(size.value)
+        _check(_lib.bloom_serialize(self._handle, buf, size.value, ctypes.byref(size)))
+        return buf.raw
+
+    @classmethod
+    def deserialize(cls, kind, data):
+        handle = _lib.bloom_deserialize(kind, data, len(data))
+        if not handle:
+            raise ValueError("invalid serialized filter")
+        return cls(kind, 0, 0, _handle=handle)
+
+
+def _arrow_buffers(array):
+    """Returns the data and uint64 offsets buffers of an Arrow binary array.
+
+    The data is never copied; 32-bit offsets of a plain binary array are
+    widened, so pass a large binary array to avoid copying them too.
+    """
+    if array.null_count:
+        raise ValueError("array contains nulls")
+    _, offsets, data = array.buffers()
+    import pyarrow
+    width = 8 if pyarrow.types.is_large_binary(array.type) else 4
+    begin = array.offset * width
+    end = begin + (len(array) + 1) * width
+    if width == 8:
+        return data, offsets[begin:end]
+    import array as pyarray
+    wide = pyarray.array("Q", memoryview(offsets)[begin:end].cast("I"))
+    return data, wide
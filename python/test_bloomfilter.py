@@ -0,0 +1,94 @@
+import array
+import unittest
+
+import bloomfilter
+
+
+def pack(keys):
+    data = b"".join(keys)
+    offsets = array.array("Q", [0])
+    for k in keys:
+        offsets.append(offsets[-1] + len(k))
+    return data, offsets
+
+
+class BloomFilterTest(unittest.TestCase):
+
+    def test_single_and_batch(self):
+        keys = [b"key%d" % i for i in range(1000)]
+        data, offsets = pack(keys)
+        lengths = array.array("Q", (len(k) for k in keys))
+        for kind in (bloomfilter.ORDINARY, bloomfilter.COUNTING, bloomfilter.PAIRED):
+            bf = bloomfilter.BloomFilter(kind, 4, 16000)
+            bf.insert_batch(data, offsets[:-1], lengths)
+            self.assertTrue(all(k in bf for k in keys))
+            self.assertEqual(bf.query_batch(data, offsets), bytearray([1]) * len(keys))
+
+            out = bytearray(len(keys))
+            others, other_offsets = pack([b"other%d" % i for i in range(1000)])
+            bf.query_batch(others, other_offsets, out=out)
+            self.assertLess(sum(out), 50)
+
+    def test_delete(self):
+        bf = bloomfilter.BloomFilter(bloomfilter.COUNTING, 3, 4096)
+        bf.insert(b"a")
+        bf.insert(b"b")
+        self.assertTrue(bf.delete(b"a"))
+        self.assertFalse(bf.query(b"a"))
+        data, offsets = pack([b"b"])
+        self.assertEqual(bf.delete_batch(data, offsets), bytearray([1]))
+        with self.assertRaises(NotImplementedError):
+            bloomfilter.BloomFilter(bloomfilter.ORDINARY, 3, 4096).delete(b"a")
+
+    def test_keys_outside_buffer(self):
+        bf = bloomfilter.BloomFilter(bloomfilter.ORDINARY, 3, 4096)
+        with self.assertRaises(ValueError):
+            bf.query_batch(b"abc", array.array("Q", [0, 4]))
+        with self.assertRaises(ValueError):
+            bf.insert_batch(b"abc", array.array("Q", [2**63]), array.array("Q", [1]))
+        with self.assertRaises(ValueError):
+            bf.insert_batch(b"abc", array.array("Q", [2, 1]))
+        self.assertFalse(bf.query(b"c"))
+
+    def test_serialize_union(self):
+        a = bloomfilter.BloomFilter(bloomfilter.PAIRED, 3, 4096)
+        b = bloomfilter.BloomFilter(bloomfilter.PAIRED, 3, 4096)
+        a.insert(b"x")
+        b.insert(b"y")
+        a.union(b)
+        c = bloomfilter.BloomFilter.deserialize(bloomfilter.PAIRED, a.serialize())
+        self.assertTrue(b"x" in c and b"y" in c)
+        self.assertEqual((c.kind, c.num_hashes, c.num_bits), (bloomfilter.PAIRED, 3, 4096))
+        with self.assertRaises(ValueError):
+            bloomfilter.BloomFilter.deserialize(bloomfilter.PAIRED, b"\x03\x00")
+        with self.assertRaises(ValueError):
+            a.union(bloomfilter.BloomFilter(bloomfilter.PAIRED, 3, 1024))
+
+    def test_numpy(self):
+        try:
+            import numpy as np
+        except ImportError:
+            self.skipTest("numpy not installed")
+        keys = np.arange(100, dtype=np.uint64)
+        data = keys.view(np.uint8)
+        offsets = np.arange(0, 808, 8, dtype=np.uint64)
+        bf = bloomfilter.BloomFilter(bloomfilter.ORDINARY, 4, 8192)
+        bf.insert_batch(data, offsets)
+        out = np.zeros(100, dtype=np.bool_)
+        bf.query_batch(data, offsets, out=out)
+        self.assertTrue(out.all())
+
+    def test_arrow(self):
+        try:
+            import pyarrow as pa
+        except ImportError:
+            self.skipTest("pyarrow not installed")
+        for type in (pa.binary(), pa.large_binary()):
+            keys = pa.array([b"k%d" % i for i in range(100)], type=type)
+            bf = bloomfilter.BloomFilter(bloomfilter.ORDINARY, 4, 8192)
+            bf.insert_arrow(keys)
+            self.assertEqual(bf.query_arrow(keys.slice(10)), bytearray([1]) * 90)
+
+
+if __name__ == "__main__":
+    unittest.main()
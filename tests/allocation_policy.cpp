@@ -0,0 +1,132 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "ReplicatedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+    
+    bloom::AllocationPolicy huge;
+    huge.pageSize = bloom::AllocationPolicy::HugePages2M;
+    huge.placement = bloom::AllocationPolicy::Interleave;
+    
+    // falls back to ordinary pages where no huge pages are reserved
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 32, huge);
+    
+    if(bf.GetAllocationPolicy() != huge){
+        std::cout << "Error: BF does not report its allocation policy." << std::endl;
+        return 1;
+    }
+    
+    bf.Insert(t1);
+    bf.Insert(t2);
+    
+    bloom::OrdinaryBloomFilter<std::string> bf_2(bf, bloom::AllocationPolicy());
+    
+    if(!bf_2.Query(t1) || !bf_2.Query(t2) || bf_2.Query(t3)){
+        std::cout << "Error: Copy with different policy disagrees with original." << std::endl;
+        return 1;
+    }
+    
+    bloom::OrdinaryBloomFilter<std::string> bf_3 = bf.Compress();
+    
+    if(bf_3.GetAllocationPolicy() != huge || !bf_3.Query(t1)){
+        std::cout << "Error: Compressed BF lost allocation policy or contents." << std::endl;
+        return 1;
+    }
+    
+    bloom::CountingBloomFilter<std::string> cbf(4, 32, huge);
+    cbf.Insert(t1);
+    
+    bloom::ReplicatedBloomFilter<bloom::CountingBloomFilter<std::string>> rbf(cbf, bloom::AllocationPolicy::HugePages2M);
+    
+    if(rbf.GetNumReplicas() != bloom::GetNumNumaNodes()){
+        std::cout << "Error: Replicated BF does not have one replica per node." << std::endl;
+        return 1;
+    }
+    
+    rbf.Insert(t2);
+    
+    if(!rbf.Query(t1) || !rbf.Query(t2)){
+        std::cout << "Error: Query on replicated BF for inserted element was false." << std::endl;
+        return 1;
+    }
+    
+    if(!rbf.Delete(t2) || rbf.Query(t2)){
+        std::cout << "Error: Delete on replicated BF failed." << std::endl;
+        return 1;
+    }
+    
+    // small arrays do not pin a whole huge page each, but share 2 MiB pages
+    bloom::AllocationPolicy gigantic;
+    gigantic.pageSize = bloom::AllocationPolicy::HugePages1G;
+    bloom::PageAllocator<uint64_t> alloc(gigantic);
+    if(!alloc.IsPooled(8192) || alloc.GetMappedLength(8192) != 65536 || alloc.GetMappedLength(1000) != 8192
+       || alloc.IsPooled(1 << 18) || alloc.GetPageSize(1 << 18) != bloom::AllocationPolicy::HugePages2M
+       || alloc.GetMappedLength(1 << 18) != (size_t(1) << 21)
+       || alloc.GetPageSize(1 << 26) != bloom::AllocationPolicy::HugePages1G){
+        std::cout << "Error: huge pages were not downgraded for small arrays." << std::endl;
+        return 1;
+    }
+    uint64_t *p1 = alloc.allocate(8192), *p2 = alloc.allocate(8192);
+    size_t distance = p1 < p2 ? (char *) p2 - (char *) p1 : (char *) p1 - (char *) p2;
+    alloc.deallocate(p1, 8192);
+    uint64_t *p3 = alloc.allocate(8000);
+    if(distance != 65536 || p3 != p1){
+        std::cout << "Error: small arrays do not share pooled pages." << std::endl;
+        return 1;
+    }
+    alloc.deallocate(p2, 8192);
+    alloc.deallocate(p3, 8000);
+    bloom::OrdinaryBloomFilter<std::string> small(4, 65535, gigantic);
+    small.Insert(t1);
+    if(!small.Query(t1)){
+        std::cout << "Error: Query on BF with downgraded pages was false." << std::endl;
+        return 1;
+    }
+    
+    // nodes past the first word of the node mask are accepted, and negative
+    // ones rejected
+    bloom::AllocationPolicy bound;
+    bound.placement = bloom::AllocationPolicy::BindNode;
+    bound.node = 100;
+    bloom::OrdinaryBloomFilter<std::string> farNode(4, 32, bound);
+    farNode.Insert(t1);
+    if(!farNode.Query(t1)){
+        std::cout << "Error: Query on BF bound to a missing node was false." << std::endl;
+        return 1;
+    }
+    bool rejected = false;
+    bound.node = -1;
+    try {
+        bloom::OrdinaryBloomFilter<std::string> negative(4, 32, bound);
+    } catch(std::invalid_argument const&) {
+        rejected = true;
+    }
+    if(!rejected){
+        std::cout << "Error: BF accepted a negative NUMA node." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
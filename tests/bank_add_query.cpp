@@ -0,0 +1,91 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include "BloomFilterBank.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    // enough filters to cover a transposed group of 64 plus a remainder
+    const size_t numFilters = 150;
+    std::vector<bloom::OrdinaryBloomFilter<std::string>> filters;
+    for(size_t f = 0; f < numFilters; f++){
+        filters.emplace_back(3, 1000);
+        filters.back().Insert("doc" + std::to_string(f));
+        filters.back().Insert(f % 2 ? "odd" : "even");
+    }
+
+    // one added singly to leave the bulk add unaligned, the rest in bulk
+    bloom::BloomFilterBank<std::string> bank(3, 1000);
+    if(bank.Add(filters[0]) != 0 || bank.Add(filters.begin() + 1, filters.end()) != 1
+       || bank.GetNumFilters() != numFilters){
+        std::cout << "Error: Filters were added at the wrong indexes." << std::endl;
+        return 1;
+    }
+
+    for(size_t f = 0; f < numFilters; f++){
+        std::string key = "doc" + std::to_string(f);
+        std::vector<size_t> hits = bloom::ToFilterIndexes(bank.Query(key));
+        if(std::find(hits.begin(), hits.end(), f) == hits.end()){
+            std::cout << "Error: Bank query missed the filter containing the key." << std::endl;
+            return 1;
+        }
+        for(size_t g : hits){
+            if(!filters[g].Query(key)){
+                std::cout << "Error: Bank query matched a filter which does not match." << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::vector<size_t> odd = bloom::ToFilterIndexes(bank.Query(std::string("odd")));
+    for(size_t f = 1; f < numFilters; f += 2){
+        if(std::find(odd.begin(), odd.end(), f) == odd.end()){
+            std::cout << "Error: Shared key missing from a filter." << std::endl;
+            return 1;
+        }
+    }
+
+    bank.Insert(7, std::string("late"));
+    std::vector<size_t> late = bloom::ToFilterIndexes(bank.Query(std::string("late")));
+    if(std::find(late.begin(), late.end(), 7) == late.end()){
+        std::cout << "Error: Insert into a banked filter was lost." << std::endl;
+        return 1;
+    }
+
+    bloom::OrdinaryBloomFilter<std::string> extracted = bank.GetFilter(100);
+    if(!extracted.Query("doc100") || !extracted.Query("even")){
+        std::cout << "Error: Extracted filter lost its contents." << std::endl;
+        return 1;
+    }
+
+    try {
+        bank.Add(bloom::OrdinaryBloomFilter<std::string>(3, 999));
+        std::cout << "Error: Filter of different geometry was accepted." << std::endl;
+        return 1;
+    }
+    catch(std::invalid_argument const&){
+    }
+
+    try {
+        bloom::BloomFilterBank<std::string> empty(0, 1000);
+        std::cout << "Error: Bank without hashes was accepted." << std::endl;
+        return 1;
+    }
+    catch(std::invalid_argument const&){
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
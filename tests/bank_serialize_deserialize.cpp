@@ -0,0 +1,63 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include "BloomFilterBank.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    bloom::BloomFilterBank<std::string> bank(4, 500);
+    for(size_t f = 0; f < 70; f++){
+        bloom::OrdinaryBloomFilter<std::string> bf(4, 500);
+        bf.Insert("doc" + std::to_string(f));
+        bank.Add(bf);
+    }
+
+    std::stringstream ss;
+    bank.Serialize(ss);
+    std::string bytes = ss.str();
+
+    bloom::BloomFilterBank<std::string> copy = bloom::BloomFilterBank<std::string>::Deserialize(ss);
+
+    // view the serialized bytes in place, as if mapped from a file
+    std::vector<uint64_t> buffer((bytes.size() + 7) / 8);
+    memcpy(buffer.data(), bytes.data(), bytes.size());
+    bloom::BloomFilterBankView<std::string> view(buffer.data(), bytes.size());
+
+    if(copy.GetNumFilters() != 70 || view.GetNumFilters() != 70
+       || view.GetNumHashes() != 4 || view.GetNumBits() != 500){
+        std::cout << "Error: Deserialized geometry differs." << std::endl;
+        return 1;
+    }
+
+    for(size_t f = 0; f < 80; f++){
+        std::string key = "doc" + std::to_string(f);
+        if(copy.Query(key) != bank.Query(key) || view.Query(key) != bank.Query(key)){
+            std::cout << "Error: Deserialized bank answers differently." << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        bloom::BloomFilterBankView<std::string> truncated(buffer.data(), bytes.size() - 8);
+        std::cout << "Error: Truncated bank was accepted." << std::endl;
+        return 1;
+    }
+    catch(std::invalid_argument const&){
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <string_view>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+
+template <typename BF>
+std::string Bytes(BF const& bf){
+    std::ostringstream os;
+    bf.Serialize(os);
+    return os.str();
+}
+
+int main(int argc, char *argv[]){
+
+    // enough objects for several partitions, with repeats so that some
+    // counters saturate
+    std::vector<uint64_t> keys;
+    for(uint64_t i = 0; i < 50000; i++){
+        keys.push_back(i % 300 == 0 ? 7 : i * 0x9E3779B97F4A7C15ull);
+    }
+    
+    bloom::OrdinaryBloomFilter<uint64_t> ordinary(5, 40000);
+    bloom::CountingBloomFilter<uint64_t> counting(5, 40000);
+    for(uint64_t k : keys){
+        ordinary.Insert(k);
+        counting.Insert(k);
+    }
+    
+    for(unsigned numThreads : {1, 2, 5}){
+        auto builtOrdinary = bloom::OrdinaryBloomFilter<uint64_t>::BuildFrom(5, 40000, keys, numThreads);
+        if(Bytes(builtOrdinary) != Bytes(ordinary)){
+            std::cout << "Error: Ordinary BF built with " << numThreads
+                      << " threads differs from one built by Insert." << std::endl;
+            return 1;
+        }
+        
+        auto builtCounting = bloom::CountingBloomFilter<uint64_t>::BuildFrom(5, 40000, keys, numThreads);
+        if(Bytes(builtCounting) != Bytes(counting)){
+            std::cout << "Error: Counting BF built with " << numThreads
+                      << " threads differs from one built by Insert." << std::endl;
+            return 1;
+        }
+    }
+    
+    if(bloom::CountingBloomFilter<uint64_t>::BuildFrom(5, 40000, keys, 3).Count(7) != counting.Count(7) || counting.Count(7) < 167){
+        std::cout << "Error: Count of a repeated object after BuildFrom was wrong." << std::endl;
+        return 1;
+    }
+    
+    std::vector<std::string> strings;
+    for(int i = 0; i < 20000; i++){
+        strings.push_back("key" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(strings.begin(), strings.end());
+    auto fromViews = bloom::OrdinaryBloomFilter<std::string>::BuildFrom(4, 65000, views, 4);
+    for(std::string const& s : strings){
+        if(!fromViews.Query(s)){
+            std::cout << "Error: Object inserted by BuildFrom through an equivalent key was not found." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::vector<uint64_t> none;
+    if(Bytes(bloom::OrdinaryBloomFilter<uint64_t>::BuildFrom(5, 40000, none, 4))
+       != Bytes(bloom::OrdinaryBloomFilter<uint64_t>(5, 40000))){
+        std::cout << "Error: BuildFrom of an empty range was not empty." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include "ConcurrentPairedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+
+    bloom::ConcurrentPairedBloomFilter<std::string> bf(4, 1000);
+    bf.Insert(t1);
+    bf.Insert(t2);
+    bf.Delete(t2);
+
+    // the format is that of PairedBloomFilter in both directions
+    std::stringstream ss;
+    bf.Serialize(ss);
+    bloom::PairedBloomFilter<std::string> paired = bloom::PairedBloomFilter<std::string>::Deserialize(ss);
+
+    if(!paired.Query(t1) || paired.Query(t2) || paired.Query(t3)){
+        std::cout << "Error: Serialized filter not readable as a PairedBloomFilter." << std::endl;
+        return 1;
+    }
+
+    paired.Insert(t3);
+    std::stringstream ss2;
+    paired.Serialize(ss2);
+    bloom::ConcurrentPairedBloomFilter<std::string> copy =
+        bloom::ConcurrentPairedBloomFilter<std::string>::Deserialize(ss2);
+
+    if(!copy.Query(t1) || copy.Query(t2) || !copy.Query(t3)){
+        std::cout << "Error: Deserialized filter answers differently." << std::endl;
+        return 1;
+    }
+
+    if(copy.Delete(t2) || !copy.Delete(t3) || copy.Query(t3)){
+        std::cout << "Error: Delete on deserialized filter is wrong." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
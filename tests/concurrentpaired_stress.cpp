@@ -0,0 +1,117 @@
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include "ConcurrentPairedBloomFilter.hpp"
+
+/** Writer w owns keys w * KeysPerWriter + i. Each writer inserts all of its
+ *  keys and then deletes every tenth one, while another thread merges in a
+ *  replica. Readers check that published keys are present, published
+ *  deletions absent and, once merged, the replica's keys present.
+ */
+const unsigned NumWriters = 3;
+const unsigned NumReaders = 3;
+const uint64_t KeysPerWriter = 1500;
+
+/** Runs one round of the scenario on a fresh filter.
+ *
+ *  @return Number of inconsistent results
+ */
+unsigned RunRound(){
+
+    // large enough that false negatives caused by deletions are negligible
+    bloom::ConcurrentPairedBloomFilter<uint64_t> bf(4, 65535);
+
+    bloom::PairedBloomFilter<uint64_t> remote(4, 65535);
+    for(uint64_t i = 0; i < 500; i++){
+        remote.Insert(1000000 + i);
+    }
+
+    std::atomic<uint64_t> inserted[NumWriters];
+    std::atomic<uint64_t> deleted[NumWriters];
+    for(unsigned w = 0; w < NumWriters; w++){
+        inserted[w] = 0;
+        deleted[w] = 0;
+    }
+    std::atomic<bool> merged(false);
+    std::atomic<unsigned> errors(0);
+    std::atomic<unsigned> writersDone(0);
+
+    std::vector<std::thread> threads;
+    for(unsigned w = 0; w < NumWriters; w++){
+        threads.emplace_back([&, w]{
+            for(uint64_t i = 0; i < KeysPerWriter; i++){
+                bf.Insert(w * KeysPerWriter + i);
+                inserted[w].store(i + 1, std::memory_order_release);
+            }
+            // Union ANDs the negative arrays, so it would undo concurrent
+            // deletions; delete only once the replica has been merged
+            while(!merged.load(std::memory_order_acquire)){
+                std::this_thread::yield();
+            }
+            for(uint64_t i = 0; i < KeysPerWriter; i++){
+                if(i % 10 == 0 && !bf.Delete(w * KeysPerWriter + i)){
+                    errors++;
+                }
+                deleted[w].store(i + 1, std::memory_order_release);
+            }
+            writersDone++;
+        });
+    }
+
+    threads.emplace_back([&]{
+        bf.Union(remote);
+        merged.store(true, std::memory_order_release);
+    });
+
+    for(unsigned r = 0; r < NumReaders; r++){
+        threads.emplace_back([&, r]{
+            uint64_t seed = r + 1;
+            while(writersDone.load() < NumWriters){
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                unsigned w = (seed >> 33) % NumWriters;
+                uint64_t del = deleted[w].load(std::memory_order_acquire);
+                uint64_t ins = inserted[w].load(std::memory_order_acquire);
+                if(ins == 0){
+                    continue;
+                }
+                uint64_t i = (seed >> 13) % ins;
+                bool present = bf.Query(w * KeysPerWriter + i);
+                if(i % 10 != 0 && !present){
+                    errors++;
+                }
+                if(i % 10 == 0 && i < del && present){
+                    errors++;
+                }
+                if(merged.load(std::memory_order_acquire) && !bf.Query(1000000 + (seed >> 20) % 500)){
+                    errors++;
+                }
+            }
+        });
+    }
+
+    for(std::thread &t : threads){
+        t.join();
+    }
+
+    unsigned total = errors;
+    for(uint64_t k = 0; k < NumWriters * KeysPerWriter; k++){
+        total += bf.Query(k) != (k % KeysPerWriter % 10 != 0);
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]){
+
+    for(unsigned round = 0; round < 20; round++){
+        unsigned errors = RunRound();
+        if(errors){
+            std::cout << "Error: " << errors << " inconsistent results under concurrent use." << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <string>
+#include <iostream>
+#include "CountingBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+    
+    bloom::CountingBloomFilter<std::string> bf1(4, 1000);
+    bloom::CountingBloomFilter<std::string> bf2(4, 1000);
+    
+    bf1.Insert(t1);
+    bf1.Insert(t3);
+    bf2.Insert(t2);
+    bf2.Insert(t3);
+    
+    bloom::CountingBloomFilter<std::string> both = bf1;
+    both.Intersect(bf2);
+    
+    if(both.Query(t1) || both.Query(t2)){
+        std::cout << "Error: Intersection contains element of only one BF." << std::endl;
+        return 1;
+    }
+    
+    if(!both.Query(t3)){
+        std::cout << "Error: Intersection lacks element of both BFs." << std::endl;
+        return 1;
+    }
+
+    // split across threads to exercise the parallel path
+    bf1.Add(bf2, 4);
+
+    if(!bf1.Query(t1) || !bf1.Query(t2) || !bf1.Query(t3)){
+        std::cout << "Error: Query for added element was false." << std::endl;
+        return 1;
+    }
+    
+    // t3 was added by both BFs, so one deletion must leave it present
+    if(!bf1.Delete(t3) || !bf1.Query(t3)){
+        std::cout << "Error: Sum lost count of element inserted twice." << std::endl;
+        return 1;
+    }
+    
+    bf1.Subtract(bf2, 3);
+    
+    if(!bf1.Query(t1)){
+        std::cout << "Error: Query for element remaining after subtraction was false." << std::endl;
+        return 1;
+    }
+    
+    if(bf1.Query(t2) || bf1.Query(t3)){
+        std::cout << "Error: Query for subtracted element was true." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
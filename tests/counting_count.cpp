@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include "CountingBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string heavy = "heavy hitter";
+    std::string light = "light";
+    std::string absent = "absent";
+
+    bloom::CountingBloomFilter<std::string> bf(4, 1000);
+    bloom::CountingBloomFilter<std::string> cu(4, 1000);
+
+    for(int i = 0; i < 50; i++){
+        bf.Insert(heavy);
+        cu.InsertConservative(heavy);
+    }
+    bf.Insert(light);
+    cu.InsertConservative(light);
+
+    if(bf.Count(heavy) < 50 || bf.Count(light) < 1 || bf.Count(absent) != 0){
+        std::cout << "Error: Count is not an upper bound of the insertions." << std::endl;
+        return 1;
+    }
+
+    if(cu.Count(heavy) != 50 || cu.Count(light) < 1 || cu.Count(light) > bf.Count(light)){
+        std::cout << "Error: Conservative update count is wrong." << std::endl;
+        return 1;
+    }
+
+    // counters saturate instead of wrapping around
+    for(int i = 0; i < 300; i++){
+        bf.Insert(heavy);
+    }
+    if(bf.Count(heavy) != 255 || !bf.Delete(heavy) || bf.Count(heavy) != 255){
+        std::cout << "Error: Counters did not saturate at 255." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> keys = {heavy, light, absent, heavy};
+    uint8_t counts[4];
+    bf.CountBatch(keys.data(), keys.size(), counts);
+    for(size_t i = 0; i < keys.size(); i++){
+        if(counts[i] != bf.Count(keys[i])){
+            std::cout << "Error: Batch count differs from Count." << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<uint64_t> digests;
+    for(uint64_t d = 0; d < 40; d++){
+        digests.push_back(d * 0x9E3779B97F4A7C15ull);
+        for(uint64_t j = 0; j <= d % 3; j++){
+            cu.InsertHash(digests.back());
+        }
+    }
+    std::vector<uint8_t> hashCounts(digests.size());
+    cu.CountHashBatch(digests.data(), digests.size(), hashCounts.data());
+    for(size_t i = 0; i < digests.size(); i++){
+        if(hashCounts[i] != cu.CountHash(digests[i]) || hashCounts[i] < i % 3 + 1){
+            std::cout << "Error: Batch digest count is wrong." << std::endl;
+            return 1;
+        }
+    }
+
+    // the heavy hitter's cells are exactly the top cells of cu
+    std::vector<std::pair<uint16_t, uint8_t>> top = cu.TopCells(4);
+    if(top.size() != 4){
+        std::cout << "Error: Wrong number of top cells." << std::endl;
+        return 1;
+    }
+    for(auto const& cell : top){
+        if(cell.second < 50){
+            std::cout << "Error: Top cells do not belong to the heavy hitter." << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<uint64_t> hist = cu.GetCounterHistogram();
+    uint64_t total = 0;
+    for(uint64_t h : hist){
+        total += h;
+    }
+    if(total != 1000 || hist[0] == 0){
+        std::cout << "Error: Counter histogram is wrong." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
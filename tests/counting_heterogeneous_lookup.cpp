@@ -0,0 +1,65 @@
+#include <string>
+#include <string_view>
+#include <iostream>
+#include "CountingBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string_view>> {
+        size_t operator()(bloom::HashParams<std::string_view> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            return hash<bloom::HashParams<std::string_view>>{}({s.a, s.b});
+        }
+    };
+}
+
+// both hashes are specialized, so the pair must be declared transparent
+template<> struct bloom::TransparentKey<std::string, std::string_view> : std::true_type {};
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string_view v1 = "Hello world!";
+    std::string_view v2 = "foo bar baz";
+    
+    bloom::CountingBloomFilter<std::string> bf(4, 32);
+    
+    bf.Insert(t1);
+    bf.InsertHash(42);
+
+    if(bf.Delete(v2)){
+        std::cout << "Error: Deleted non-inserted element by view." << std::endl;
+        return 1;
+    }
+    
+    if(!bf.Delete(v1)){
+        std::cout << "Error: Failed to delete element by view." << std::endl;
+        return 1;
+    }
+    
+    if(bf.Query(t1)){
+        std::cout << "Error: Query for deleted object was true." << std::endl;
+        return 1;
+    }
+    
+    if(!bf.DeleteHash(42)){
+        std::cout << "Error: Failed to delete element by digest." << std::endl;
+        return 1;
+    }
+    
+    if(bf.QueryHash(42)){
+        std::cout << "Error: Query for deleted digest was true." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
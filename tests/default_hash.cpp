@@ -0,0 +1,100 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+/** Type with a user specialization, which must take precedence
+ */
+struct Custom {
+    int id;
+};
+
+namespace std {
+    template<> struct hash<bloom::HashParams<Custom>> {
+        size_t operator()(bloom::HashParams<Custom> const& s) const {
+            return s.b;
+        }
+    };
+}
+
+template <typename T>
+bool HashesDiffer(T const& a, T const& b){
+    return std::hash<bloom::HashParams<T>>{}({a, 0}) != std::hash<bloom::HashParams<T>>{}({b, 0});
+}
+
+// only declared pairs of types may be used for heterogeneous lookups
+static_assert(bloom::TransparentKey<std::string, std::string_view>::value,
+              "A string view was not accepted as a string key.");
+static_assert(bloom::TransparentKey<std::string, const char *>::value,
+              "A C string was not accepted as a string key.");
+static_assert(!bloom::TransparentKey<std::string, int>::value,
+              "An integer was accepted as a string key.");
+static_assert(!bloom::TransparentKey<std::vector<char>, std::string_view>::value,
+              "An undeclared pair was accepted as transparent.");
+static_assert(!bloom::TransparentKey<Custom, int>::value,
+              "A key of a type with a user specialization was accepted as transparent.");
+
+int main(int argc, char *argv[]){
+
+    bloom::OrdinaryBloomFilter<uint64_t> ints(4, 4096);
+    for(uint64_t i = 0; i < 100; i++){
+        ints.Insert(i * 7);
+    }
+    for(uint64_t i = 0; i < 100; i++){
+        if(!ints.Query(i * 7)){
+            std::cout << "Error: Query for inserted integer was false." << std::endl;
+            return 1;
+        }
+    }
+
+    bloom::OrdinaryBloomFilter<std::string> strings(4, 1024);
+    strings.Insert("Hello world!");
+    if(!strings.Query(std::string_view("Hello world!")) || strings.Query(std::string_view("Hello world"))){
+        std::cout << "Error: String view lookup does not match string hash." << std::endl;
+        return 1;
+    }
+    const char *c = "Hello world!";
+    if(!strings.Query(c)){
+        std::cout << "Error: C string lookup does not match string hash." << std::endl;
+        return 1;
+    }
+
+    bloom::CountingBloomFilter<std::pair<std::string, Point>> pairs(4, 1024);
+    pairs.Insert({"origin", {0, 0}});
+    if(!pairs.Query({"origin", {0, 0}}) || !pairs.Delete({"origin", {0, 0}}) || pairs.Query({"origin", {0, 0}})){
+        std::cout << "Error: Tuple-like key was not inserted and deleted." << std::endl;
+        return 1;
+    }
+
+    if(!HashesDiffer(std::vector<std::string>{"a", "bc"}, std::vector<std::string>{"ab", "c"})
+       || !HashesDiffer(std::array<int, 3>{1, 2, 3}, std::array<int, 3>{3, 2, 1})
+       || !HashesDiffer(std::make_tuple(1, 2.5, std::string("x")), std::make_tuple(2, 2.5, std::string("x")))
+       || HashesDiffer(0.0, -0.0)){
+        std::cout << "Error: Default hash of composite key is wrong." << std::endl;
+        return 1;
+    }
+
+    if(std::hash<bloom::HashParams<Custom>>{}({Custom{1}, 3}) != 3){
+        std::cout << "Error: User specialization was not used." << std::endl;
+        return 1;
+    }
+
+    // salts must give independent hashes
+    std::string s = "salted";
+    if(std::hash<bloom::HashParams<std::string>>{}({s, 0}) == std::hash<bloom::HashParams<std::string>>{}({s, 1})){
+        std::cout << "Error: Salt does not change the hash." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
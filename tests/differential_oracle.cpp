@@ -0,0 +1,170 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <unordered_set>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "InterleavedPairedBloomFilter.hpp"
+#include "ConcurrentPairedBloomFilter.hpp"
+#include "PartitionedBloomFilter.hpp"
+#include "SlidingWindowBloomFilter.hpp"
+
+/** Inserts random objects into a BF, then checks that every inserted
+ *  object is found and that the false positive rate measured on objects
+ *  never inserted is within a margin of the expected (1 - e^(-kn/m))^k.
+ *
+ *  @return true if both hold
+ */
+template <typename BF>
+bool CheckAgainstOracle(const char *name, BF bf, size_t numInserted, std::mt19937_64 &rng){
+    std::unordered_set<uint64_t> oracle;
+    while(oracle.size() < numInserted){
+        uint64_t o = rng();
+        oracle.insert(o);
+        bf.Insert(o);
+    }
+
+    for(uint64_t o : oracle){
+        if(!bf.Query(o)){
+            std::cout << "Error: " << name << " gave a false negative." << std::endl;
+            return false;
+        }
+    }
+
+    const size_t numQueries = 20000;
+    size_t positives = 0;
+    for(size_t i = 0; i < numQueries; i++){
+        uint64_t o = rng();
+        if(!oracle.count(o)){
+            positives += bf.Query(o);
+        }
+    }
+
+    double k = bf.GetNumHashes(), m = bf.GetNumBits();
+    double expected = std::pow(1 - std::exp(-k * numInserted / m), k);
+    double measured = (double) positives / numQueries;
+    // four standard deviations, plus slack for partitioned filters,
+    // whose slices fill slightly faster
+    double bound = 1.1 * expected + 4 * std::sqrt(expected / numQueries) + 0.001;
+    if(measured > bound){
+        std::cout << "Error: " << name << " with k = " << k << ", m = " << m << ", n = " << numInserted
+                  << " has false positive rate " << measured << ", expected " << expected << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** Inserts random objects into a counting BF, deletes half of them, and
+ *  checks that the rest are still found and that the deleted ones are
+ *  reported no more often than new objects would be.
+ */
+bool CheckCountingDeletes(uint8_t numHashes, uint16_t numBits, size_t numInserted, std::mt19937_64 &rng){
+    bloom::CountingBloomFilter<uint64_t> bf(numHashes, numBits);
+    std::vector<uint64_t> objects;
+    for(size_t i = 0; i < 2 * numInserted; i++){
+        objects.push_back(rng());
+        bf.Insert(objects.back());
+    }
+    for(size_t i = 0; i < numInserted; i++){
+        if(!bf.Delete(objects[i])){
+            std::cout << "Error: Counting BF failed to delete an inserted object." << std::endl;
+            return false;
+        }
+    }
+
+    size_t positives = 0;
+    for(size_t i = 0; i < numInserted; i++){
+        positives += bf.Query(objects[i]);
+        if(!bf.Query(objects[numInserted + i])){
+            std::cout << "Error: Counting BF gave a false negative after deletions." << std::endl;
+            return false;
+        }
+    }
+
+    double k = numHashes, m = numBits;
+    double expected = std::pow(1 - std::exp(-k * numInserted / m), k);
+    double measured = (double) positives / numInserted;
+    if(measured > 1.1 * expected + 4 * std::sqrt(expected / numInserted) + 0.001){
+        std::cout << "Error: Counting BF reports deleted objects with rate " << measured
+                  << ", expected " << expected << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** Applies the same random inserts, deletes and unions to the three paired
+ *  layouts, and checks that they always agree.
+ */
+bool CheckPairedLayouts(uint8_t numHashes, uint16_t numBits, std::mt19937_64 &rng){
+    bloom::PairedBloomFilter<uint64_t> paired(numHashes, numBits), pairedSide(numHashes, numBits);
+    bloom::InterleavedPairedBloomFilter<uint64_t> interleaved(numHashes, numBits), interleavedSide(numHashes, numBits);
+    bloom::ConcurrentPairedBloomFilter<uint64_t> concurrent(numHashes, numBits);
+
+    for(int i = 0; i < 20000; i++){
+        uint64_t o = rng() % 2048;
+        bool agree = true;
+        switch(rng() % 8){
+            case 0: case 1: case 2:
+                paired.Insert(o);
+                interleaved.Insert(o);
+                concurrent.Insert(o);
+                break;
+            case 3:
+                pairedSide.Insert(o);
+                interleavedSide.Insert(o);
+                break;
+            case 4: {
+                bool deleted = paired.Delete(o);
+                agree = interleaved.Delete(o) == deleted && concurrent.Delete(o) == deleted;
+                break;
+            }
+            case 5:
+                paired.Union(pairedSide);
+                interleaved.Union(interleavedSide);
+                concurrent.Union(pairedSide);
+                break;
+            default: {
+                bool found = paired.Query(o);
+                agree = interleaved.Query(o) == found && concurrent.Query(o) == found;
+                break;
+            }
+        }
+        if(!agree){
+            std::cout << "Error: Paired BF layouts disagree." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]){
+
+    std::mt19937_64 rng(1);
+
+    struct { uint8_t numHashes; uint16_t numBits; size_t numInserted; } geometries[] = {
+        {1, 64, 8}, {3, 1000, 100}, {4, 8192, 1000}, {7, 65535, 4000}, {8, 4096, 1500}
+    };
+
+    for(auto const& g : geometries){
+        uint8_t k = g.numHashes;
+        uint16_t m = g.numBits;
+        size_t n = g.numInserted;
+        if(!CheckAgainstOracle("Ordinary BF", bloom::OrdinaryBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Counting BF", bloom::CountingBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Paired BF", bloom::PairedBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Interleaved paired BF", bloom::InterleavedPairedBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Concurrent paired BF", bloom::ConcurrentPairedBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Partitioned BF", bloom::PartitionedBloomFilter<uint64_t>(k, m), n, rng)
+           || !CheckAgainstOracle("Sliding-window BF", bloom::SlidingWindowBloomFilter<uint64_t>(k, m, 4), n, rng)
+           || !CheckCountingDeletes(k, m, n, rng)
+           || !CheckPairedLayouts(k, m, rng)){
+            return 1;
+        }
+    }
+
+    std::cout << "Tests passed." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include "FilterService.hpp"
+
+std::string Key(int i){
+    return "key" + std::to_string(i);
+}
+
+/** Sends raw bytes to the server on a connection of its own, and returns
+ *  true if the server closes the connection in response
+ */
+bool ClosedAfter(std::string const& path, std::string const& bytes){
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    if(connect(fd, (sockaddr *) &addr, sizeof(addr)) != 0){
+        close(fd);
+        return false;
+    }
+    (void) !send(fd, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    char c;
+    bool closed = recv(fd, &c, 1, 0) == 0;
+    close(fd);
+    return closed;
+}
+
+/** Sends a pipeline of Serialize requests for the filter with the given
+ *  handle in one write, then reads the responses, and returns true if all
+ *  of the expected bytes were received
+ */
+bool SerializePipelined(std::string const& path, uint32_t handle, int count, size_t expected){
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    if(connect(fd, (sockaddr *) &addr, sizeof(addr)) != 0){
+        close(fd);
+        return false;
+    }
+    std::string requests;
+    for(int i = 0; i < count; i++){
+        bloom::protocol::Put(requests, uint32_t(9));
+        bloom::protocol::Put(requests, uint32_t(i));
+        bloom::protocol::Put(requests, uint8_t(bloom::protocol::Serialize));
+        bloom::protocol::Put(requests, handle);
+    }
+    (void) !send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+    // let the server parse the whole pipeline before anything is read
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    size_t received = 0;
+    char buf[65536];
+    ssize_t r;
+    while(received < expected && (r = recv(fd, buf, sizeof(buf), 0)) > 0){
+        received += r;
+    }
+    close(fd);
+    return received == expected;
+}
+
+/** Returns the peak resident set size of the process, in bytes
+ */
+size_t PeakRss(){
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return size_t(usage.ru_maxrss) << 10;
+}
+
+int main(int argc, char *argv[]){
+
+    char dir[] = "/tmp/bloom_service_XXXXXX";
+    if(!mkdtemp(dir)){
+        std::cout << "Error: cannot create a temporary directory." << std::endl;
+        return 1;
+    }
+    std::string path = std::string(dir) + "/socket";
+
+    bloom::OrdinaryBloomFilter<std::string> local(5, 20000);
+    bloom::CountingBloomFilter<std::string> counting(4, 8000);
+    for(int i = 0; i < 1000; i++){
+        local.Insert(Key(i));
+        counting.Insert(Key(i));
+    }
+
+    bloom::FilterServer server(path, 2);
+    server.Add("ordinary", local);
+    server.Add("counting", counting);
+    server.Add("paired", bloom::PairedBloomFilter<std::string>(4, 8000));
+    bloom::CountingBloomFilter<std::string> large(4, 65535);
+    server.Add("large", large);
+    server.Start();
+
+    {
+        bloom::RemoteBloomFilter remote(path, "ordinary");
+        if(remote.GetKind() != bloom::protocol::Ordinary || remote.GetNumHashes() != 5 || remote.GetNumBits() != 20000){
+            std::cout << "Error: remote BF has the wrong geometry." << std::endl;
+            return 1;
+        }
+
+        // answers agree with the local copy, one key and in pipelined batches
+        std::vector<std::string> keys;
+        for(int i = 0; i < 20000; i++){
+            keys.push_back(Key(i));
+        }
+        std::vector<uint8_t> results(keys.size());
+        remote.QueryBatch(keys.begin(), keys.end(), results.data());
+        for(size_t i = 0; i < keys.size(); i++){
+            if(results[i] != local.Query(keys[i]) || (i % 1000 == 0 && remote.Query(keys[i]) != local.Query(keys[i]))){
+                std::cout << "Error: remote BF disagrees with the local one." << std::endl;
+                return 1;
+            }
+        }
+
+        bool rejected = false;
+        try {
+            remote.Delete(Key(0));
+        } catch(std::invalid_argument const&) {
+            rejected = true;
+        }
+        if(!rejected || !remote.Query(Key(1))){
+            std::cout << "Error: remote ordinary BF accepted a deletion." << std::endl;
+            return 1;
+        }
+
+        std::stringstream ss;
+        remote.Serialize(ss);
+        std::ostringstream os;
+        local.Serialize(os);
+        if(ss.str() != os.str()){
+            std::cout << "Error: remote BF did not serialize as the local one." << std::endl;
+            return 1;
+        }
+    }
+
+    // clients in several threads insert concurrently
+    const int numClients = 4, perClient = 3000;
+    std::vector<std::thread> clients;
+    for(int c = 0; c < numClients; c++){
+        clients.emplace_back([&, c]{
+            bloom::RemoteBloomFilter remote(path, "paired");
+            std::vector<std::string_view> keys;
+            std::vector<std::string> owned;
+            for(int i = 0; i < perClient; i++){
+                owned.push_back(Key(c * perClient + i));
+            }
+            keys.assign(owned.begin(), owned.end());
+            remote.InsertBatch(keys.begin(), keys.end());
+        });
+    }
+    for(std::thread &t : clients){
+        t.join();
+    }
+
+    bloom::PairedBloomFilter<std::string> paired(4, 8000);
+    for(int i = 0; i < numClients * perClient; i++){
+        paired.Insert(Key(i));
+    }
+    std::vector<std::string> deleted;
+    for(int i = 0; i < 500; i++){
+        paired.Delete(Key(i));
+        deleted.push_back(Key(i));
+    }
+    {
+        bloom::RemoteBloomFilter remote(path, "paired");
+        std::vector<uint8_t> results(deleted.size());
+        remote.DeleteBatch(deleted.begin(), deleted.end(), results.data());
+        std::ostringstream expected, served;
+        paired.Serialize(expected);
+        server.Serialize("paired", served);
+        if(expected.str() != served.str()){
+            std::cout << "Error: concurrent remote insertions and deletions were lost." << std::endl;
+            return 1;
+        }
+
+        bloom::RemoteBloomFilter remoteCounting(path, "counting");
+        if(!remoteCounting.Delete(Key(1)) || counting.Delete(Key(1)) != true){
+            std::cout << "Error: remote counting BF failed to delete." << std::endl;
+            return 1;
+        }
+        if(remoteCounting.Query(Key(1)) != counting.Query(Key(1))){
+            std::cout << "Error: remote counting BF disagrees after a deletion." << std::endl;
+            return 1;
+        }
+    }
+
+    bool rejected = false;
+    try {
+        bloom::RemoteBloomFilter remote(path, "missing");
+    } catch(std::invalid_argument const&) {
+        rejected = true;
+    }
+    if(!rejected){
+        std::cout << "Error: opened a filter the server does not have." << std::endl;
+        return 1;
+    }
+
+    // a frame over the size limit closes that connection only
+    if(!ClosedAfter(path, std::string("\xff\xff\xff\xff", 4))){
+        std::cout << "Error: server accepted an oversized frame." << std::endl;
+        return 1;
+    }
+    {
+        bloom::RemoteBloomFilter remote(path, "ordinary");
+        if(!remote.Query(Key(2))){
+            std::cout << "Error: server stopped serving after a bad client." << std::endl;
+            return 1;
+        }
+    }
+
+    // a pipeline of requests whose responses are large is answered a
+    // backlog at a time, rather than all at once
+    {
+        const int count = 2000;
+        std::ostringstream os;
+        large.Serialize(os);
+        size_t peak = PeakRss();
+        if(!SerializePipelined(path, 3, count, count * (bloom::protocol::ResponseHeaderSize + os.str().size()))){
+            std::cout << "Error: pipelined Serialize requests were not all answered." << std::endl;
+            return 1;
+        }
+#ifndef __SANITIZE_ADDRESS__
+        // AddressSanitizer quarantines freed memory, which inflates the RSS
+        if(PeakRss() > peak + 64 * (size_t(1) << 20)){
+            std::cout << "Error: responses to a pipeline were buffered beyond the backlog limit." << std::endl;
+            return 1;
+        }
+#else
+        (void) peak;
+#endif
+    }
+
+    server.Stop();
+    if(access(path.c_str(), F_OK) == 0){
+        std::cout << "Error: server did not remove its socket." << std::endl;
+        return 1;
+    }
+    bool refused = false;
+    try {
+        bloom::RemoteBloomFilter remote(path, "ordinary");
+    } catch(std::system_error const&) {
+        refused = true;
+    }
+    if(!refused){
+        std::cout << "Error: connected to a stopped server." << std::endl;
+        return 1;
+    }
+    rmdir(dir);
+
+    std::cout << "Tests passed." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <string>
+#include <iostream>
+#include "InterleavedPairedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+
+    bloom::InterleavedPairedBloomFilter<std::string> bf(4, 100);
+
+    bf.Insert(t1);
+
+    if(!bf.Query(t1)){
+        std::cout << "Error: Query for first inserted element was false." << std::endl;
+        return 1;
+    }
+
+    if(bf.Query(t2)){
+        std::cout << "Error: Query for non-inserted element was true." << std::endl;
+        return 1;
+    }
+
+    bf.Insert(t2);
+
+    if(!bf.Delete(t2) || bf.Query(t2)){
+        std::cout << "Error: Query for deleted object was true." << std::endl;
+        return 1;
+    }
+
+    if(bf.Delete(t2) || !bf.Query(t1)){
+        std::cout << "Error: Deletion affected other objects." << std::endl;
+        return 1;
+    }
+
+    // deletions absent from the other BF are dropped by the union, so both
+    // t2 and t3 become present again
+    bloom::InterleavedPairedBloomFilter<std::string> other(4, 100);
+    other.Insert(t3);
+    bf.Insert(t3);
+    bf.Delete(t3);
+    bf.Union(other);
+
+    if(!bf.Query(t1) || !bf.Query(t2) || !bf.Query(t3)){
+        std::cout << "Error: Union combined the arrays incorrectly." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
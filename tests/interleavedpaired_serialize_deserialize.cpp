@@ -0,0 +1,57 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include "InterleavedPairedBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    // an odd size, so the arrays do not end on a byte boundary
+    bloom::PairedBloomFilter<std::string> paired(3, 77);
+    bloom::InterleavedPairedBloomFilter<std::string> interleaved(3, 77);
+
+    for(int i = 0; i < 20; i++){
+        std::string key = "key" + std::to_string(i);
+        paired.Insert(key);
+        interleaved.Insert(key);
+        if(i % 3 == 0){
+            paired.Delete(key);
+            interleaved.Delete(key);
+        }
+    }
+
+    std::stringstream a, b;
+    paired.Serialize(a);
+    interleaved.Serialize(b);
+
+    if(a.str() != b.str()){
+        std::cout << "Error: Serialized form differs from that of PairedBloomFilter." << std::endl;
+        return 1;
+    }
+
+    bloom::InterleavedPairedBloomFilter<std::string> loaded =
+        bloom::InterleavedPairedBloomFilter<std::string>::Deserialize(a);
+
+    for(int i = 0; i < 40; i++){
+        std::string key = "key" + std::to_string(i);
+        if(loaded.Query(key) != paired.Query(key)){
+            std::cout << "Error: Filter loaded from the paired format answers differently." << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "LayeredBloomFilter.hpp"
+
+int main(int argc, char *argv[]){
+
+    auto backup = std::make_shared<bloom::OrdinaryBloomFilter<uint64_t>>(3, 8000);
+    bloom::LayeredBloomFilter<uint64_t> layered(3, 8000, backup);
+    bloom::AbstractBloomFilter<uint64_t> &bf = layered;
+    
+    for(uint64_t i = 0; i < 1000; i++){
+        bf.Insert(i * 0x9E3779B97F4A7C15ull);
+    }
+    for(uint64_t i = 0; i < 1000; i++){
+        if(!bf.Query(i * 0x9E3779B97F4A7C15ull)){
+            std::cout << "Error: Query for inserted element was false." << std::endl;
+            return 1;
+        }
+    }
+    
+    // the front stage hashes independently of the backup, so it should
+    // reject most of the backup's false positives
+    size_t backupPositives = 0, layeredPositives = 0;
+    for(uint64_t i = 1000; i < 101000; i++){
+        uint64_t o = i * 0x9E3779B97F4A7C15ull;
+        bool b = backup->Query(o), l = bf.Query(o);
+        if(l && !b){
+            std::cout << "Error: Layered BF accepted an object its backup rejected." << std::endl;
+            return 1;
+        }
+        backupPositives += b;
+        layeredPositives += l;
+    }
+    double frontRate = layered.GetFrontFalsePositiveRate();
+    if(backupPositives < 1000 || layeredPositives > 3 * frontRate * backupPositives + 10){
+        std::cout << "Error: Front stage let through " << layeredPositives << " of " << backupPositives
+                  << " false positives, expected about " << frontRate * backupPositives << "." << std::endl;
+        return 1;
+    }
+    
+    // a predicate accepting a known key range, with two exceptions outside
+    // it which the front bit array must catch
+    auto counting = std::make_shared<bloom::CountingBloomFilter<uint64_t>>(4, 16000);
+    bloom::LayeredBloomFilter<uint64_t> ranged(2, 512, counting, [](uint64_t const& o){ return o < 1000; });
+    for(uint64_t i = 0; i < 1000; i += 2){
+        ranged.Insert(i);
+    }
+    ranged.Insert(123456);
+    ranged.Insert(654321);
+    
+    for(uint64_t o : {0, 2, 998, 123456, 654321}){
+        if(!ranged.Query(o)){
+            std::cout << "Error: Query for inserted element " << o << " with a predicate was false." << std::endl;
+            return 1;
+        }
+    }
+    
+    size_t outOfRange = 0;
+    for(uint64_t o = 1000; o < 101000; o++){
+        outOfRange += ranged.Query(o);
+    }
+    if(outOfRange > 100){
+        std::cout << "Error: Predicate and front stage let through " << outOfRange << " absent objects." << std::endl;
+        return 1;
+    }
+    
+    // layered BFs compose through AbstractBloomFilter
+    auto inner = std::make_shared<bloom::LayeredBloomFilter<uint64_t>>(2, 1024, counting);
+    bloom::LayeredBloomFilter<uint64_t> outer(1, 256, inner);
+    outer.Insert(42);
+    if(!outer.Query(42) || !counting->Query(42)){
+        std::cout << "Error: Query for element inserted through nested layered BFs was false." << std::endl;
+        return 1;
+    }
+    if(inner->GetFrontSalt() != bloom::LayeredBloomFilter<uint64_t>::FrontSalt
+       || outer.GetFrontSalt() != inner->GetFrontSalt() + 2){
+        std::cout << "Error: Nested layered BFs share front salts." << std::endl;
+        return 1;
+    }
+    
+    // front hashes may not wrap around into the salts of the backup BF
+    bool rejected = false;
+    try {
+        bloom::LayeredBloomFilter<uint64_t> wide(129, 256, backup);
+    } catch(std::invalid_argument const&) {
+        rejected = true;
+    }
+    if(!rejected){
+        std::cout << "Error: Layered BF accepted more front hashes than salts." << std::endl;
+        return 1;
+    }
+    
+    // copies would share the backup BF but not the front bit array
+    static_assert(!std::is_copy_constructible<bloom::LayeredBloomFilter<uint64_t>>::value,
+                  "LayeredBloomFilter must not be copyable");
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "LayeredBloomFilter.hpp"
+
+int main(int argc, char *argv[]){
+
+    auto predicate = [](uint64_t const& o){ return o % 2 == 0; };
+    
+    bloom::LayeredBloomFilter<uint64_t> bf(3, 1000, std::make_shared<bloom::OrdinaryBloomFilter<uint64_t>>(4, 5000),
+                                           predicate);
+    for(uint64_t i = 0; i < 300; i++){
+        bf.Insert(i * 7);
+    }
+    
+    std::stringstream ss;
+    bf.Serialize(ss);
+    std::string bytes = ss.str();
+    
+    auto r = bloom::LayeredBloomFilter<uint64_t>::Deserialize<bloom::OrdinaryBloomFilter<uint64_t>>(ss, predicate);
+    
+    std::ostringstream again;
+    r.Serialize(again);
+    if(again.str() != bytes){
+        std::cout << "Error: Deserialized BF serialized differently." << std::endl;
+        return 1;
+    }
+    
+    if(r.GetFrontFalsePositiveRate() != bf.GetFrontFalsePositiveRate()){
+        std::cout << "Error: Deserialized front bit array differs." << std::endl;
+        return 1;
+    }
+    
+    for(uint64_t i = 0; i < 3000; i++){
+        if(r.Query(i) != bf.Query(i)){
+            std::cout << "Error: Query result of deserialized BF differs for " << i << "." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include "OrdinaryBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 4096);
+    
+    bf.Insert(t1);
+    
+    std::stringstream ss;
+    bf.Serialize(ss);
+    bloom::OrdinaryBloomFilter<std::string> replica = bloom::OrdinaryBloomFilter<std::string>::Deserialize(ss);
+    bf.Checkpoint();
+    
+    bf.Insert(t2);
+    
+    std::stringstream delta;
+    bf.WriteDelta(delta);
+    
+    // count (4 bytes) plus at most one (index, word) pair per hash
+    if(delta.str().size() > 4 + 4 * 12){
+        std::cout << "Error: Delta contains unmodified words." << std::endl;
+        return 1;
+    }
+    
+    if(replica.Query(t2)){
+        std::cout << "Error: Query on replica for non-inserted element was true." << std::endl;
+        return 1;
+    }
+    
+    replica.ApplyDelta(delta);
+    
+    if(!replica.Query(t1) || !replica.Query(t2)){
+        std::cout << "Error: Query on updated replica for inserted element was false." << std::endl;
+        return 1;
+    }
+    
+    std::stringstream s1, s2;
+    bf.Serialize(s1);
+    replica.Serialize(s2);
+    if(s1.str() != s2.str()){
+        std::cout << "Error: Updated replica differs from original." << std::endl;
+        return 1;
+    }
+    
+    bf.Checkpoint();
+    std::stringstream empty;
+    bf.WriteDelta(empty);
+    if(empty.str().size() != 4){
+        std::cout << "Error: Delta after checkpoint was not empty." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <string>
+#include <string_view>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string_view>> {
+        size_t operator()(bloom::HashParams<std::string_view> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            return hash<bloom::HashParams<std::string_view>>{}({s.a, s.b});
+        }
+    };
+}
+
+// both hashes are specialized, so the pair must be declared transparent
+template<> struct bloom::TransparentKey<std::string, std::string_view> : std::true_type {};
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    
+    // views into a larger buffer, as if received from the network
+    std::string buffer = "xxHello world!foo bar baz";
+    std::string_view v1(buffer.data() + 2, 12);
+    std::string_view v2(buffer.data() + 14, 11);
+    
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 32);
+    
+    bf.Insert(t1);
+
+    if(!bf.Query(v1)){
+        std::cout << "Error: Query by view for element inserted by value was false." << std::endl;
+        return 1;
+    }
+    
+    if(bf.Query(v2)){
+        std::cout << "Error: Query by view for non-inserted element was true." << std::endl;
+        return 1;
+    }
+    
+    bf.Insert(v2);
+    
+    if(!bf.Query(t2)){
+        std::cout << "Error: Query by value for element inserted by view was false." << std::endl;
+        return 1;
+    }
+    
+    bloom::OrdinaryBloomFilter<std::string> bf_2(4, 32);
+    
+    bf_2.InsertHash(0x0123456789abcdefull);
+    
+    if(!bf_2.QueryHash(0x0123456789abcdefull)){
+        std::cout << "Error: Query for inserted digest was false." << std::endl;
+        return 1;
+    }
+    
+    if(bf_2.QueryHash(0xfedcba9876543210ull)){
+        std::cout << "Error: Query for non-inserted digest was true." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+
+static bool Near(double value, double expected, double tolerance){
+    return std::fabs(value - expected) <= tolerance * expected;
+}
+
+int main(int argc, char *argv[]){
+
+    bloom::OrdinaryBloomFilter<uint64_t> a(4, 65000);
+    bloom::OrdinaryBloomFilter<uint64_t> b(4, 65000);
+    
+    if(a.EstimateSize() != 0 || a.EstimateJaccard(b) != 0 || a.EstimateIntersectionSize(b) != 0){
+        std::cout << "Error: Estimates for empty filters were not 0." << std::endl;
+        return 1;
+    }
+    
+    for(uint64_t i = 0; i < 3000; i++){
+        a.Insert(i);
+    }
+    for(uint64_t i = 2000; i < 5000; i++){
+        b.Insert(i);
+    }
+    
+    if(!Near(a.EstimateSize(), 3000, 0.03) || !Near(b.EstimateSize(), 3000, 0.03)){
+        std::cout << "Error: Size estimate was " << a.EstimateSize() << ", expected 3000." << std::endl;
+        return 1;
+    }
+    
+    if(!Near(a.EstimateUnionSize(b), 5000, 0.03)){
+        std::cout << "Error: Union size estimate was " << a.EstimateUnionSize(b) << ", expected 5000." << std::endl;
+        return 1;
+    }
+    
+    if(!Near(a.EstimateIntersectionSize(b), 1000, 0.1)){
+        std::cout << "Error: Intersection size estimate was " << a.EstimateIntersectionSize(b)
+                  << ", expected 1000." << std::endl;
+        return 1;
+    }
+    
+    if(!Near(a.EstimateJaccard(b), 0.2, 0.1) || !Near(b.EstimateJaccard(a), a.EstimateJaccard(b), 1e-9)){
+        std::cout << "Error: Jaccard estimate was " << a.EstimateJaccard(b) << ", expected 0.2." << std::endl;
+        return 1;
+    }
+    
+    if(a.EstimateJaccard(a) != 1){
+        std::cout << "Error: Jaccard estimate of a filter with itself was not 1." << std::endl;
+        return 1;
+    }
+    
+    bloom::OrdinaryBloomFilter<uint64_t> full(1, 64);
+    for(uint64_t i = 0; i < 10000; i++){
+        full.Insert(i);
+    }
+    if(!std::isinf(full.EstimateSize())){
+        std::cout << "Error: Size estimate of a saturated filter was not infinite." << std::endl;
+        return 1;
+    }
+    
+    // comparisons with a saturated filter stay finite
+    bloom::OrdinaryBloomFilter<uint64_t> some(1, 64);
+    for(uint64_t i = 0; i < 10; i++){
+        some.Insert(i);
+    }
+    double j = full.EstimateJaccard(some), intersection = full.EstimateIntersectionSize(some);
+    if(full.EstimateJaccard(full) != 1 || std::isnan(j) || j < 0 || j > 1
+       || std::isnan(intersection) || std::isinf(intersection)){
+        std::cout << "Error: Estimates against a saturated filter were " << full.EstimateJaccard(full)
+                  << ", " << j << " and " << intersection << "." << std::endl;
+        return 1;
+    }
+    std::vector<bloom::OrdinaryBloomFilter<uint64_t>> saturated = {full, some, full};
+    for(double x : bloom::OrdinaryBloomFilter<uint64_t>::EstimateJaccardMatrix(saturated)){
+        if(std::isnan(x)){
+            std::cout << "Error: Similarity matrix with a saturated filter contained NaN." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::vector<bloom::OrdinaryBloomFilter<uint64_t>> filters;
+    for(uint64_t f = 0; f < 7; f++){
+        filters.emplace_back(4, 8192);
+        for(uint64_t i = 0; i < 200 * (f + 1); i++){
+            filters.back().Insert(f * 100 + i);
+        }
+    }
+    filters.emplace_back(4, 8192);
+    
+    std::vector<double> serial = bloom::OrdinaryBloomFilter<uint64_t>::EstimateJaccardMatrix(filters);
+    std::vector<double> parallel = bloom::OrdinaryBloomFilter<uint64_t>::EstimateJaccardMatrix(filters, 3);
+    size_t n = filters.size();
+    
+    if(serial.size() != n * n || serial != parallel){
+        std::cout << "Error: Parallel similarity matrix differed from serial one." << std::endl;
+        return 1;
+    }
+    
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < n; j++){
+            if(serial[i * n + j] != filters[i].EstimateJaccard(filters[j])){
+                std::cout << "Error: Similarity matrix entry (" << i << ", " << j
+                          << ") differed from EstimateJaccard." << std::endl;
+                return 1;
+            }
+        }
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <string>
+#include <string_view>
+#include <iostream>
+#include "OrdinaryBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+// only std::string is specialized, so std::string_view keeps the default hash
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+static_assert(!bloom::UsesDefaultHash<std::string>::value,
+              "A user specialization was taken for the default hash.");
+static_assert(bloom::UsesDefaultHash<std::string_view>::value,
+              "The default hash was taken for a user specialization.");
+static_assert(!bloom::TransparentKey<std::string, std::string_view>::value,
+              "Keys hashed differently from T were accepted for lookups.");
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    const char *c1 = "Hello world!";
+    std::string_view v1(t1);
+
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 32);
+
+    bf.Insert(t1);
+
+    // a C string is converted to std::string, and hashed as one
+    if(!bf.Query(c1)){
+        std::cout << "Error: Query by C string for element inserted by value was false." << std::endl;
+        return 1;
+    }
+
+    if(!bf.Query(std::string(v1))){
+        std::cout << "Error: Query by converted view for element inserted by value was false." << std::endl;
+        return 1;
+    }
+
+    if(bf.Query(t2)){
+        std::cout << "Error: Query for non-inserted element was true." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include "PairedBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+    
+    bloom::PairedBloomFilter<std::string> bf(4, 4096);
+    
+    bf.Insert(t1);
+    bf.Insert(t2);
+    
+    std::stringstream ss;
+    bf.Serialize(ss);
+    bloom::PairedBloomFilter<std::string> replica = bloom::PairedBloomFilter<std::string>::Deserialize(ss);
+    bf.Checkpoint();
+    
+    bf.Delete(t2);
+    bf.Insert(t3);
+    
+    std::stringstream delta;
+    bf.WriteDelta(delta);
+    replica.ApplyDelta(delta);
+    
+    if(!replica.Query(t1) || !replica.Query(t3)){
+        std::cout << "Error: Query on updated replica for inserted element was false." << std::endl;
+        return 1;
+    }
+    
+    if(replica.Query(t2)){
+        std::cout << "Error: Query on updated replica for deleted element was true." << std::endl;
+        return 1;
+    }
+    
+    // a union clears negative bits, which the delta must also carry
+    bf.Checkpoint();
+    bloom::PairedBloomFilter<std::string> other(4, 4096);
+    other.Insert(t2);
+    bf.Union(other);
+    
+    std::stringstream delta_2;
+    bf.WriteDelta(delta_2);
+    replica.ApplyDelta(delta_2);
+    
+    if(!replica.Query(t2)){
+        std::cout << "Error: Query on replica after union was false." << std::endl;
+        return 1;
+    }
+    
+    std::stringstream s1, s2;
+    bf.Serialize(s1);
+    replica.Serialize(s2);
+    if(s1.str() != s2.str()){
+        std::cout << "Error: Updated replica differs from original." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include <string>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstdio>
+#include <csignal>
+#include <cstdlib>
+#include <system_error>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "PersistentBloomFilter.hpp"
+
+template <typename BF>
+std::string Bytes(BF const& bf){
+    std::ostringstream os;
+    bf.Serialize(os);
+    return os.str();
+}
+
+void Remove(std::string const& path){
+    for(const char *ext : {".ckpt", ".log", ".ckpt.tmp", ".log.tmp"}){
+        std::remove((path + ext).c_str());
+    }
+}
+
+/** Applies the same random inserts and deletes to a persistent BF and to a
+ *  reference BF, then reopens the persistent BF and checks that it has
+ *  recovered the reference exactly.
+ */
+template <typename BF>
+bool CheckReopen(const char *name, std::string const& path, bloom::PersistencePolicy const& policy,
+                 size_t numOps, std::mt19937_64 &rng){
+    Remove(path);
+    BF reference(5, 20000);
+    {
+        bloom::PersistentBloomFilter<BF> bf(path, 5, 20000, policy);
+        for(size_t i = 0; i < numOps; i++){
+            uint64_t o = rng() % 8192;
+            if(rng() % 4 == 0){
+                if(bf.Delete(o) != reference.Delete(o)){
+                    std::cout << "Error: " << name << " persistent BF disagrees on a delete." << std::endl;
+                    return false;
+                }
+            } else {
+                bf.Insert(o);
+                reference.Insert(o);
+            }
+        }
+    }
+
+    bloom::PersistentBloomFilter<BF> bf(path, 5, 20000, policy);
+    if(Bytes(bf.GetFilter()) != Bytes(reference)){
+        std::cout << "Error: " << name << " persistent BF was not recovered." << std::endl;
+        return false;
+    }
+    if(bf.GetSequenceNumber() - bf.GetCheckpointSequenceNumber() != bf.GetNumReplayed()){
+        std::cout << "Error: " << name << " persistent BF replayed records covered by its checkpoint." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]){
+
+    char dir[] = "/tmp/bloom_persistent_XXXXXX";
+    if(!mkdtemp(dir)){
+        std::cout << "Error: cannot create a temporary directory." << std::endl;
+        return 1;
+    }
+    std::string path = std::string(dir) + "/bf";
+    std::mt19937_64 rng(1);
+
+    bloom::PersistencePolicy logOnly;
+    logOnly.checkpointRecords = 0;
+    logOnly.recoveryThreads = 4;
+
+    bloom::PersistencePolicy checkpointed;
+    checkpointed.sync = bloom::PersistencePolicy::SyncPeriodic;
+    checkpointed.commitRecords = 100;
+    checkpointed.checkpointRecords = 7000;
+    checkpointed.recoveryThreads = 3;
+
+    // the log-only runs replay enough records to use every thread
+    if(!CheckReopen<bloom::CountingBloomFilter<uint64_t>>("Counting", path, logOnly, 30000, rng)
+       || !CheckReopen<bloom::CountingBloomFilter<uint64_t>>("Counting", path, checkpointed, 30000, rng)
+       || !CheckReopen<bloom::PairedBloomFilter<uint64_t>>("Paired", path, logOnly, 30000, rng)
+       || !CheckReopen<bloom::PairedBloomFilter<uint64_t>>("Paired", path, checkpointed, 30000, rng)){
+        return 1;
+    }
+
+    typedef bloom::CountingBloomFilter<std::string> Counting;
+    typedef bloom::PersistentBloomFilter<Counting> Persistent;
+
+    // a crash loses exactly the records not yet committed
+    Remove(path);
+    bloom::PersistencePolicy policy;
+    policy.commitRecords = 10;
+    policy.checkpointRecords = 50;
+    pid_t pid = fork();
+    if(pid == 0){
+        Persistent bf(path, 4, 1000, policy);
+        for(int i = 0; i < 125; i++){
+            bf.Insert("key" + std::to_string(i));
+        }
+        bf.Delete("key0");
+        bf.Sync();
+        for(int i = 125; i < 129; i++){
+            bf.Insert("key" + std::to_string(i));
+        }
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+
+    Counting reference(4, 1000);
+    for(int i = 0; i < 125; i++){
+        reference.Insert("key" + std::to_string(i));
+    }
+    reference.Delete("key0");
+    {
+        Persistent bf(path, 4, 1000, policy);
+        if(Bytes(bf.GetFilter()) != Bytes(reference) || bf.GetSequenceNumber() != 126
+           || bf.GetCheckpointSequenceNumber() != 100 || bf.GetNumReplayed() != 26){
+            std::cout << "Error: persistent BF was not recovered after a crash." << std::endl;
+            return 1;
+        }
+        if(bf.Query(std::string("key0")) || !bf.Query("key1") || bf.Delete("key999")){
+            std::cout << "Error: recovered persistent BF gives wrong answers." << std::endl;
+            return 1;
+        }
+        bf.Insert("key125");
+        reference.Insert("key125");
+    }
+
+    // a group torn by a crash is discarded, and later groups follow the
+    // last intact one
+    {
+        std::ofstream log(path + ".log", std::ios::binary | std::ios::app);
+        log.write("\x03\x00\x00\x00garbage", 11);
+    }
+    {
+        Persistent bf(path, 4, 1000, policy);
+        if(Bytes(bf.GetFilter()) != Bytes(reference)){
+            std::cout << "Error: persistent BF did not discard a torn group." << std::endl;
+            return 1;
+        }
+        bf.Insert("key126");
+        reference.Insert("key126");
+    }
+    {
+        Persistent bf(path, 4, 1000, policy);
+        if(Bytes(bf.GetFilter()) != Bytes(reference) || bf.GetSequenceNumber() != 128){
+            std::cout << "Error: persistent BF lost records appended after a torn group." << std::endl;
+            return 1;
+        }
+    }
+
+    // a crash between writing a checkpoint and replacing the log leaves the
+    // old log, whose records the checkpoint already covers
+    {
+        Persistent bf(path, 4, 1000, policy);
+        bf.Insert("key127");
+        reference.Insert("key127");
+        bf.Sync();
+        std::ifstream is(path + ".log", std::ios::binary);
+        std::string oldLog((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        bf.Checkpoint();
+        std::ofstream(path + ".log", std::ios::binary) << oldLog;
+    }
+    {
+        Persistent bf(path, 4, 1000, policy);
+        if(Bytes(bf.GetFilter()) != Bytes(reference) || bf.GetNumReplayed() != 0
+           || bf.GetSequenceNumber() != 129){
+            std::cout << "Error: persistent BF replayed records covered by its checkpoint." << std::endl;
+            return 1;
+        }
+    }
+
+    // stored files of another geometry are rejected
+    bool rejected = false;
+    try {
+        Persistent bf(path, 4, 2000, policy);
+    } catch(std::invalid_argument const&) {
+        rejected = true;
+    }
+    if(!rejected){
+        std::cout << "Error: persistent BF opened files of another geometry." << std::endl;
+        return 1;
+    }
+
+    // a group cut short by a failed write is removed from the log and
+    // written again by the next commit, so groups committed after it are
+    // not lost behind it
+    Remove(path);
+    policy.commitRecords = 1000;
+    policy.checkpointRecords = 0;
+    Counting shortReference(4, 1000);
+    {
+        Persistent bf(path, 4, 1000, policy);
+        for(int i = 0; i < 100; i++){
+            bf.Insert("key" + std::to_string(i));
+            shortReference.Insert("key" + std::to_string(i));
+        }
+        bf.Sync();
+        for(int i = 100; i < 200; i++){
+            bf.Insert("key" + std::to_string(i));
+            shortReference.Insert("key" + std::to_string(i));
+        }
+
+        // the file size limit lets half of the next group through
+        struct stat st;
+        stat((path + ".log").c_str(), &st);
+        struct rlimit limit, saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        limit = saved;
+        limit.rlim_cur = st.st_size + 50 * 9;
+        signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &limit);
+        bool failed = false;
+        try {
+            bf.Sync();
+        } catch(std::system_error const&) {
+            failed = true;
+        }
+        setrlimit(RLIMIT_FSIZE, &saved);
+        signal(SIGXFSZ, SIG_DFL);
+        struct stat after;
+        stat((path + ".log").c_str(), &after);
+        if(!failed || after.st_size != st.st_size){
+            std::cout << "Error: persistent BF left a torn group in its log." << std::endl;
+            return 1;
+        }
+
+        bf.Sync();
+        bf.Insert("key200");
+        shortReference.Insert("key200");
+        bf.Sync();
+    }
+    {
+        Persistent bf(path, 4, 1000, policy);
+        if(Bytes(bf.GetFilter()) != Bytes(shortReference) || bf.GetSequenceNumber() != 201){
+            std::cout << "Error: persistent BF lost groups synced after a failed write." << std::endl;
+            return 1;
+        }
+    }
+
+    Remove(path);
+    rmdir(dir);
+
+    std::cout << "Tests passed." << std::endl;
+
+    return 0;
+}
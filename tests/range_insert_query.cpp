@@ -0,0 +1,78 @@
+#include <set>
+#include <random>
+#include <iostream>
+#include "RangeBloomFilter.hpp"
+
+int main(int argc, char *argv[]){
+
+    std::mt19937_64 rng(1);
+    
+    // 300 timestamps spread over 2^40, with 20 levels of prefixes
+    bloom::RangeBloomFilter<uint64_t> bf(6, 65535, 20);
+    std::set<uint64_t> oracle;
+    while(oracle.size() < 300){
+        uint64_t o = rng() >> 24;
+        oracle.insert(o);
+        bf.Insert(o);
+    }
+    
+    for(uint64_t o : oracle){
+        if(!bf.Query(o) || !bf.QueryRange(o, o)){
+            std::cout << "Error: Query for inserted element was false." << std::endl;
+            return 1;
+        }
+    }
+    
+    for(uint64_t o : oracle){
+        uint64_t d = rng() >> (40 + rng() % 24);
+        uint64_t a = o > d ? o - d : 0;
+        uint64_t b = o + (rng() >> (40 + rng() % 24));
+        if(!bf.QueryRange(a, b)){
+            std::cout << "Error: Range [" << a << ", " << b << "] around an inserted element was reported empty." << std::endl;
+            return 1;
+        }
+    }
+    
+    size_t numEmpty = 0, positives = 0;
+    for(int i = 0; i < 20000; i++){
+        // ranges of up to 2^24 objects, with lengths spread over every scale
+        uint64_t a = rng() >> 24;
+        uint64_t b = a + (rng() >> (40 + rng() % 24));
+        auto it = oracle.lower_bound(a);
+        bool occupied = it != oracle.end() && *it <= b;
+        bool result = bf.QueryRange(a, b);
+        if(occupied && !result){
+            std::cout << "Error: Range [" << a << ", " << b << "] containing an element was reported empty." << std::endl;
+            return 1;
+        }
+        if(!occupied){
+            numEmpty++;
+            positives += result;
+        }
+    }
+    if(numEmpty < 1000 || positives > numEmpty / 50){
+        std::cout << "Error: " << positives << " of " << numEmpty << " empty ranges were reported occupied." << std::endl;
+        return 1;
+    }
+    
+    // ranges touching the ends of the key space
+    bloom::RangeBloomFilter<uint8_t> small(3, 4096, 8);
+    small.Insert(0);
+    small.Insert(255);
+    if(!small.QueryRange(0, 255) || !small.QueryRange(200, 255) || !small.QueryRange(0, 0)
+       || small.QueryRange(1, 254) || small.QueryRange(100, 200)){
+        std::cout << "Error: Range queries at the ends of the key space were wrong." << std::endl;
+        return 1;
+    }
+    
+    bloom::RangeBloomFilter<uint64_t> wide(3, 4096, 8);
+    wide.Insert(~uint64_t(0));
+    if(!wide.QueryRange(~uint64_t(0) - 10, ~uint64_t(0)) || !wide.QueryRange(0, ~uint64_t(0))){
+        std::cout << "Error: Range queries up to the largest key were wrong." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <sstream>
+#include <iostream>
+#include "RangeBloomFilter.hpp"
+
+int main(int argc, char *argv[]){
+
+    bloom::RangeBloomFilter<uint32_t> bf(3, 8192, 12);
+    for(uint32_t i = 0; i < 100; i++){
+        bf.Insert(i * 7919);
+    }
+    
+    std::stringstream ss;
+    bf.Serialize(ss);
+    std::string bytes = ss.str();
+    
+    bloom::RangeBloomFilter<uint32_t> r = bloom::RangeBloomFilter<uint32_t>::Deserialize(ss);
+    
+    if(r.GetNumLevels() != 12 || r.GetNumHashes() != 3 || r.GetNumBits() != 8192){
+        std::cout << "Error: Deserialized BF has a different geometry." << std::endl;
+        return 1;
+    }
+    
+    std::ostringstream again;
+    r.Serialize(again);
+    if(again.str() != bytes){
+        std::cout << "Error: Deserialized BF serialized differently." << std::endl;
+        return 1;
+    }
+    
+    for(uint32_t a = 0; a < 800000; a += 1000){
+        if(r.QueryRange(a, a + 999) != bf.QueryRange(a, a + 999)){
+            std::cout << "Error: Range query result of deserialized BF differs." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <vector>
+#include <random>
+#include <iostream>
+#include "SimdKernels.hpp"
+
+/** Checks every kernel against a direct computation, using the variants
+ *  of the instruction set in use
+ */
+bool Check(const char *name){
+
+    std::mt19937 rng(1);
+    
+    // lengths straddling every vector width, plus a partial final word
+    for(size_t n : {0, 1, 15, 16, 31, 32, 63, 64, 65, 127, 200, 1000}){
+        
+        std::vector<uint8_t> a(n), b(n);
+        for(size_t i = 0; i < n; i++){
+            // bias towards zero and towards saturation
+            a[i] = rng() % 4 == 0 ? 0 : rng() % 256;
+            b[i] = rng() % 4 == 0 ? 255 : rng() % 256;
+        }
+        
+        std::vector<uint64_t> words((n + 63) / 64, ~uint64_t(0));
+        bloom::simd::CountersToBits(a.data(), n, words.data());
+        for(size_t i = 0; i < words.size() * 64; i++){
+            bool expected = i < n && a[i] != 0;
+            if(((words[i / 64] >> (i % 64)) & 1) != expected){
+                std::cout << "Error: " << name << " CountersToBits produced wrong bit " << i << " for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        std::vector<uint8_t> sum(a);
+        bloom::simd::SaturatingAdd(sum.data(), b.data(), n);
+        for(size_t i = 0; i < n; i++){
+            unsigned expected = a[i] + b[i] > 255 ? 255 : a[i] + b[i];
+            if(sum[i] != expected){
+                std::cout << "Error: " << name << " SaturatingAdd produced wrong counter " << i << " for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        std::vector<uint8_t> diff(a);
+        bloom::simd::SaturatingSubtract(diff.data(), b.data(), n);
+        for(size_t i = 0; i < n; i++){
+            unsigned expected = a[i] > b[i] ? a[i] - b[i] : 0;
+            if(diff[i] != expected){
+                std::cout << "Error: " << name << " SaturatingSubtract produced wrong counter " << i << " for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        std::vector<uint8_t> min(a);
+        bloom::simd::Minimum(min.data(), b.data(), n);
+        for(size_t i = 0; i < n; i++){
+            if(min[i] != (a[i] < b[i] ? a[i] : b[i])){
+                std::cout << "Error: " << name << " Minimum produced wrong counter " << i << " for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        for(unsigned threshold : {0, 1, 128, 255}){
+            std::vector<uint32_t> found(n);
+            found.resize(bloom::simd::FindAtLeast(a.data(), n, threshold, found.data()));
+            std::vector<uint32_t> expected;
+            for(size_t i = 0; i < n; i++){
+                if(a[i] >= threshold){
+                    expected.push_back(i);
+                }
+            }
+            if(found != expected){
+                std::cout << "Error: " << name << " FindAtLeast(" << threshold << ") produced wrong indexes for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        std::vector<uint64_t> hist(256, 0), expectedHist(256, 0);
+        bloom::simd::Histogram(a.data(), n, hist.data());
+        for(size_t i = 0; i < n; i++){
+            expectedHist[a[i]]++;
+        }
+        if(hist != expectedHist){
+            std::cout << "Error: " << name << " Histogram is wrong for n = " << n << "." << std::endl;
+            return false;
+        }
+        
+        std::vector<uint64_t> x(n), y(n);
+        uint64_t expectedCount = 0, expectedAnd = 0, expectedOr = 0;
+        for(size_t i = 0; i < n; i++){
+            x[i] = (uint64_t(rng()) << 32) | rng();
+            y[i] = i % 3 == 0 ? ~uint64_t(0) : (uint64_t(rng()) << 32) | rng();
+            expectedCount += __builtin_popcountll(x[i]);
+            expectedAnd += __builtin_popcountll(x[i] & y[i]);
+            expectedOr += __builtin_popcountll(x[i] | y[i]);
+        }
+        uint64_t andCount, orCount;
+        bloom::simd::PopCountAndOr(x.data(), y.data(), n, andCount, orCount);
+        uint64_t andCount2, orCount2, xCount;
+        bloom::simd::PopCountAndOr(x.data(), y.data(), n, andCount2, orCount2, xCount);
+        if(bloom::simd::PopCount(x.data(), n) != expectedCount || andCount != expectedAnd || orCount != expectedOr
+           || andCount2 != expectedAnd || orCount2 != expectedOr || xCount != expectedCount
+           || bloom::simd::PopCountOr(x.data(), y.data(), n) != expectedOr){
+            std::cout << "Error: " << name << " PopCount is wrong for n = " << n << " words." << std::endl;
+            return false;
+        }
+
+        // probes at random positions in a 2048-bit array, three quarters set
+        std::vector<uint32_t> bitArray(64);
+        for(uint32_t &w : bitArray){
+            w = rng() | rng();
+        }
+        std::vector<uint16_t> bits((n + 15) / 16 * 16 + 16);
+        bool expectedSet = true;
+        for(size_t i = 0; i < n; i++){
+            // mostly set bits, so that long arrays are not rejected at once
+            do {
+                bits[i] = rng() % 2048;
+            } while(rng() % 8 && !((bitArray[bits[i] / 32] >> (bits[i] % 32)) & 1));
+            expectedSet = expectedSet && ((bitArray[bits[i] / 32] >> (bits[i] % 32)) & 1);
+        }
+        for(size_t i = n; i < bits.size(); i++){
+            bits[i] = n ? bits[0] : 0;
+        }
+        if(bloom::simd::TestBits(bitArray.data(), bits.data(), n) != expectedSet){
+            std::cout << "Error: " << name << " TestBits is wrong for n = " << n << "." << std::endl;
+            return false;
+        }
+        for(size_t i = 0; i < n; i++){
+            bitArray[bits[i] / 32] |= uint32_t(1) << (bits[i] % 32);
+        }
+        if(!bloom::simd::TestBits(bitArray.data(), bits.data(), n)){
+            std::cout << "Error: " << name << " TestBits missed set bits for n = " << n << "." << std::endl;
+            return false;
+        }
+        
+        // the same words, as twice as many 32-bit halves
+        std::vector<uint32_t> halves(2 * n), otherHalves(2 * n);
+        for(size_t i = 0; i < n; i++){
+            halves[2 * i] = x[i];
+            halves[2 * i + 1] = x[i] >> 32;
+            otherHalves[2 * i] = y[i];
+            otherHalves[2 * i + 1] = y[i] >> 32;
+        }
+        bloom::simd::OrWords(halves.data(), otherHalves.data(), 2 * n);
+        for(size_t i = 0; i < n; i++){
+            if((halves[2 * i] | (uint64_t(halves[2 * i + 1]) << 32)) != (x[i] | y[i])){
+                std::cout << "Error: " << name << " OrWords is wrong at word " << i << " for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+        
+        // the changed bitmaps start at several offsets into their first word
+        for(size_t first : {0, 3, 60}){
+            std::vector<uint64_t> ored(x), anded(x);
+            std::vector<uint64_t> orChanged((first + n + 63) / 64 + 1, 0), andChanged(orChanged);
+            orChanged[0] = andChanged[0] = first ? 1 : 0;
+            bloom::simd::UnionWords(ored.data(), y.data(), n, orChanged.data(), first);
+            bloom::simd::IntersectWords(anded.data(), y.data(), n, andChanged.data(), first);
+            for(size_t i = 0; i < n; i++){
+                bool orBit = (orChanged[(first + i) / 64] >> ((first + i) % 64)) & 1;
+                bool andBit = (andChanged[(first + i) / 64] >> ((first + i) % 64)) & 1;
+                if(ored[i] != (x[i] | y[i]) || orBit != (ored[i] != x[i])){
+                    std::cout << "Error: " << name << " UnionWords is wrong at word " << i << " for n = " << n << "." << std::endl;
+                    return false;
+                }
+                if(anded[i] != (x[i] & y[i]) || andBit != (anded[i] != x[i])){
+                    std::cout << "Error: " << name << " IntersectWords is wrong at word " << i << " for n = " << n << "." << std::endl;
+                    return false;
+                }
+            }
+            // bits outside [first, first + n) are left alone
+            uint64_t orOutside = 0, andOutside = 0;
+            for(size_t i = 0; i < orChanged.size() * 64; i++){
+                if(i < first || i >= first + n){
+                    orOutside += (orChanged[i / 64] >> (i % 64)) & 1;
+                    andOutside += (andChanged[i / 64] >> (i % 64)) & 1;
+                }
+            }
+            if(orOutside != (first ? 1 : 0) || andOutside != (first ? 1 : 0)){
+                std::cout << "Error: " << name << " changed bitmap is wrong outside its words for n = " << n << "." << std::endl;
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+int main(int argc, char *argv[]){
+
+    if(bloom::simd::GetIsa() != bloom::simd::DetectIsa()){
+        std::cout << "Error: the kernels in use are not the detected ones." << std::endl;
+        return 1;
+    }
+    
+    // every variant the CPU supports, while the others are refused
+    for(int i = 0; i < bloom::simd::NumIsas; i++){
+        bloom::simd::Isa isa = (bloom::simd::Isa) i;
+        if(!bloom::simd::SetIsa(isa)){
+            if(bloom::simd::IsSupported(isa)){
+                std::cout << "Error: could not use " << bloom::simd::IsaName(isa) << " kernels." << std::endl;
+                return 1;
+            }
+            continue;
+        }
+        if(bloom::simd::GetIsa() != isa || !Check(bloom::simd::IsaName(isa))){
+            return 1;
+        }
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
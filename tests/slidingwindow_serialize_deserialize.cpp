@@ -0,0 +1,80 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include "SlidingWindowBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+    
+    bloom::SlidingWindowBloomFilter<std::string> bf(4, 32, 2);
+    
+    bf.Insert(t1);
+    bf.Advance();
+    bf.Insert(t2);
+    
+    std::stringstream ss;
+    bf.Serialize(ss);
+    
+    bloom::SlidingWindowBloomFilter<std::string> bf_2 = bloom::SlidingWindowBloomFilter<std::string>::Deserialize(ss);
+    
+    if(bf_2.GetNumHashes() != bf.GetNumHashes()){
+        std::cout << "Error: Deserialized BF disagrees on numHashes." << std::endl;
+        return 1;
+    }
+    
+    if(bf_2.GetNumBits() != bf.GetNumBits()){
+        std::cout << "Error: Deserialized BF disagrees on numBits." << std::endl;
+        return 1;
+    }
+    
+    if(bf_2.GetNumGenerations() != bf.GetNumGenerations()){
+        std::cout << "Error: Deserialized BF disagrees on numGenerations." << std::endl;
+        return 1;
+    }
+
+    if(!bf_2.Query(t1)){
+        std::cout << "Error: Query for first inserted element was false." << std::endl;
+        return 1;
+    }
+    
+    if(!bf_2.Query(t2)){
+        std::cout << "Error: Query for second inserted element was false." << std::endl;
+        return 1;
+    }
+    
+    if(bf_2.Query(t3)){
+        std::cout << "Error: Query for non-inserted element was true." << std::endl;
+        return 1;
+    }
+    
+    bf_2.Advance();
+    
+    if(bf_2.Query(t1)){
+        std::cout << "Error: Query for expired element was true." << std::endl;
+        return 1;
+    }
+    
+    if(!bf_2.Query(t2)){
+        std::cout << "Error: Query for unexpired element was false." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include "OrdinaryBloomFilter.hpp"
+#include "SnapshotWriter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    std::string t1 = "Hello world!";
+    std::string t2 = "foo bar baz";
+    std::string t3 = "test test";
+    
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 1000);
+    
+    bf.Insert(t1);
+    bf.Insert(t2);
+    
+    bloom::SnapshotWriter<bloom::OrdinaryBloomFilter<std::string>> writer(bf, 7);
+    
+    // modifications after the snapshot must not appear in it
+    bf.Insert(t3);
+    
+    std::stringstream ss;
+    unsigned chunks = 1;
+    while(!writer.WriteChunk(ss)){
+        chunks++;
+    }
+    
+    if(chunks < 2){
+        std::cout << "Error: Snapshot was not written in multiple chunks." << std::endl;
+        return 1;
+    }
+    
+    bloom::OrdinaryBloomFilter<std::string> bf_2 = bloom::OrdinaryBloomFilter<std::string>::Deserialize(ss);
+    
+    if(!bf_2.Query(t1) || !bf_2.Query(t2)){
+        std::cout << "Error: Query for element inserted before snapshot was false." << std::endl;
+        return 1;
+    }
+    
+    if(bf_2.Query(t3)){
+        std::cout << "Error: Query for element inserted after snapshot was true." << std::endl;
+        return 1;
+    }
+    
+    std::stringstream ss_async;
+    if(!bloom::SerializeAsync(bf, ss_async).get()){
+        std::cout << "Error: Asynchronous serialization failed." << std::endl;
+        return 1;
+    }
+    
+    bloom::OrdinaryBloomFilter<std::string> bf_3 = bloom::OrdinaryBloomFilter<std::string>::Deserialize(ss_async);
+    
+    if(!bf_3.Query(t3)){
+        std::cout << "Error: Query on asynchronously serialized BF was false." << std::endl;
+        return 1;
+    }
+    
+    FILE *f = tmpfile();
+    bloom::SnapshotWriter<bloom::OrdinaryBloomFilter<std::string>> fdWriter(bf, 16);
+    while(!fdWriter.WriteChunk(fileno(f), 5)){
+        if(errno){
+            std::cout << "Error: Positional write failed." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::string contents(5 + fdWriter.GetOffset(), '\0');
+    if(pread(fileno(f), &contents[0], contents.size(), 0) != (ssize_t) contents.size()){
+        std::cout << "Error: Positionally written snapshot is truncated." << std::endl;
+        return 1;
+    }
+    fclose(f);
+    
+    std::stringstream ss_fd(contents.substr(5));
+    bloom::OrdinaryBloomFilter<std::string> bf_4 = bloom::OrdinaryBloomFilter<std::string>::Deserialize(ss_fd);
+    
+    if(!bf_4.Query(t1) || !bf_4.Query(t2) || !bf_4.Query(t3)){
+        std::cout << "Error: Query on positionally written BF was false." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <string_view>
+#include "OrdinaryBloomFilter.hpp"
+#include "StaticBloomFilter.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string_view>> {
+        constexpr size_t operator()(bloom::HashParams<std::string_view> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update(s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+// built entirely at compile time
+constexpr bloom::StaticBloomFilter<std::string_view, 4, 512> denyList{
+    "evil.example", "malware.test", "phish.invalid", "spam.example"
+};
+
+static_assert(denyList.Query("evil.example"), "inserted element not found at compile time");
+static_assert(denyList.Query("spam.example"), "inserted element not found at compile time");
+static_assert(!denyList.Query("good.example"), "absent element found at compile time");
+
+int main(int argc, char *argv[]){
+
+    bloom::OrdinaryBloomFilter<std::string_view> runtime(4, 512);
+    for(std::string_view s : {"evil.example", "malware.test", "phish.invalid", "spam.example"}){
+        runtime.Insert(s);
+    }
+    
+    std::ostringstream expected, actual;
+    runtime.Serialize(expected);
+    denyList.Serialize(actual);
+    if(actual.str() != expected.str()){
+        std::cout << "Error: Static BF serialized differently from an ordinary BF." << std::endl;
+        return 1;
+    }
+    
+    // queries for objects only known at run time
+    for(int i = 0; i < 1000; i++){
+        std::string s = "host" + std::to_string(i) + ".example";
+        if(denyList.Query(s) != runtime.Query(s)){
+            std::cout << "Error: Static and ordinary BFs disagree on " << s << "." << std::endl;
+            return 1;
+        }
+    }
+    
+    std::istringstream is(actual.str());
+    auto deserialized = bloom::OrdinaryBloomFilter<std::string_view>::Deserialize(is);
+    if(!deserialized.Query("malware.test")){
+        std::cout << "Error: Query on deserialized static BF was false." << std::endl;
+        return 1;
+    }
+    
+    bloom::StaticBloomFilter<std::string_view, 4, 512> copy = denyList;
+    copy.Insert("new.example");
+    if(!copy.Query("new.example") || !copy.Query("phish.invalid")){
+        std::cout << "Error: Query for element inserted at run time was false." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Tests passed." << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,146 @@
+#define BLOOM_STATISTICS
+
+#include <string>
+#include <thread>
+#include <iostream>
+#include <stdexcept>
+#include "OrdinaryBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+#include "InterleavedPairedBloomFilter.hpp"
+#include "ConcurrentPairedBloomFilter.hpp"
+#include "Statistics.hpp"
+#include "FnvHash.hpp"
+
+namespace std {
+    template<> struct hash<bloom::HashParams<std::string>> {
+        size_t operator()(bloom::HashParams<std::string> const& s) const {
+            bloom::FnvHash32 h;
+            h.Update(&s.b, sizeof(uint8_t));
+            h.Update((const uint8_t *) s.a.data(), s.a.length());
+            return h.Digest();
+        }
+    };
+}
+
+int main(int argc, char *argv[]){
+
+    bloom::OrdinaryBloomFilter<std::string> bf(4, 4096);
+
+    for(int i = 0; i < 100; i++){
+        bf.Insert("key" + std::to_string(i));
+    }
+
+    // queries from several threads are aggregated
+    std::thread threads[4];
+    for(int t = 0; t < 4; t++){
+        threads[t] = std::thread([&bf]{
+            for(int i = 0; i < 100; i++){
+                bf.Query("key" + std::to_string(i));
+                bf.Query("absent" + std::to_string(i));
+            }
+        });
+    }
+    for(std::thread &t : threads){
+        t.join();
+    }
+
+    bloom::stats::Summary s = bloom::stats::Collect(bloom::stats::Ordinary);
+
+    if(s.inserts != 100 || s.queries != 800){
+        std::cout << "Error: Operation counts not aggregated across threads." << std::endl;
+        return 1;
+    }
+
+    if(s.positives < 400 || s.probeDepth[4] < 400){
+        std::cout << "Error: Positive queries not recorded at full depth." << std::endl;
+        return 1;
+    }
+
+    uint64_t total = 0;
+    for(uint64_t n : s.probeDepth){
+        total += n;
+    }
+    if(total != s.queries || s.probeDepth[0] != 0){
+        std::cout << "Error: Probe depth histogram does not match query count." << std::endl;
+        return 1;
+    }
+
+    bloom::PairedBloomFilter<std::string> pbf(4, 4096);
+    pbf.Insert("deleted");
+    pbf.Delete("deleted");
+    pbf.Delete("never inserted");
+    pbf.Query("deleted");
+
+    s = bloom::stats::Collect(bloom::stats::Paired);
+    if(s.deletes != 2 || s.failedDeletes != 1 || s.queries != 1 || s.negativeRejects != 1){
+        std::cout << "Error: Paired deletions or negative rejections miscounted." << std::endl;
+        return 1;
+    }
+
+    // other paired layouts are counted apart from PairedBloomFilter
+    bloom::InterleavedPairedBloomFilter<std::string> ibf(4, 4096);
+    ibf.Insert("deleted");
+    ibf.Delete("deleted");
+    ibf.Query("deleted");
+
+    s = bloom::stats::Collect(bloom::stats::InterleavedPaired);
+    if(s.inserts != 1 || s.deletes != 1 || s.queries != 1 || s.negativeRejects != 1){
+        std::cout << "Error: Interleaved paired operations miscounted." << std::endl;
+        return 1;
+    }
+    s = bloom::stats::Collect(bloom::stats::Paired);
+    if(s.inserts != 1 || s.queries != 1){
+        std::cout << "Error: Interleaved paired operations counted as paired." << std::endl;
+        return 1;
+    }
+
+    bloom::ConcurrentPairedBloomFilter<std::string> cbf(4, 4096);
+    cbf.Insert("deleted");
+    cbf.Delete("deleted");
+    cbf.Query("deleted");
+
+    s = bloom::stats::Collect(bloom::stats::ConcurrentPaired);
+    if(s.inserts != 1 || s.deletes != 1 || s.queries != 1 || s.negativeRejects != 1){
+        std::cout << "Error: Concurrent paired operations miscounted." << std::endl;
+        return 1;
+    }
+    s = bloom::stats::Collect(bloom::stats::Paired);
+    if(s.inserts != 1 || s.queries != 1){
+        std::cout << "Error: Concurrent paired operations counted as paired." << std::endl;
+        return 1;
+    }
+
+    // sample every object, so the measured rate is exact
+    bloom::OrdinaryBloomFilter<std::string> small(2, 64);
+    bloom::stats::FprSampler<std::string> sampler(1);
+    for(int i = 0; i < 20; i++){
+        sampler.Insert(small, "key" + std::to_string(i));
+    }
+    unsigned falsePositives = 0;
+    for(int i = 0; i < 1000; i++){
+        falsePositives += sampler.Query(small, "absent" + std::to_string(i));
+    }
+    for(int i = 0; i < 20; i++){
+        sampler.Query(small, "key" + std::to_string(i));
+    }
+
+    if(sampler.GetNumSampledNegatives() != 1000
+       || sampler.GetFalsePositiveRate() != falsePositives / 1000.0){
+        std::cout << "Error: Sampled false positive rate is wrong." << std::endl;
+        return 1;
+    }
+
+    bool rejected = false;
+    try {
+        bloom::stats::FprSampler<std::string> never(0);
+    } catch(std::invalid_argument const&) {
+        rejected = true;
+    }
+    if(!rejected){
+        std::cout << "Error: Sampler accepted a sampling rate of 0." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tests passed." << std::endl;
+    return 0;
+}
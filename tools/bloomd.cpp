@@ -0,0 +1,180 @@
+/** bloomd: serves Bloom filters indexing byte-string keys to local
+ *  processes over a Unix domain socket, so that they share one copy of
+ *  each filter. Clients use bloom::RemoteBloomFilter.
+ *
+ *  Each filter is either loaded from a file written by Serialize, such as
+ *  one built by bloomtool, or created empty. With -w, filters loaded from
+ *  files are written back to them on SIGINT or SIGTERM.
+ *
+ *  Run without arguments for usage.
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstdio>
+#include <csignal>
+#include <pthread.h>
+
+#include "FilterService.hpp"
+
+namespace {
+
+/** A filter given on the command line as NAME=TYPE:FILE or
+ *  NAME=TYPE:HASHES:BITS
+ */
+struct FilterSpec {
+    std::string name;
+    std::string type;
+    std::string path;   //!< Empty for a filter created empty
+    unsigned numHashes = 0;
+    unsigned numBits = 0;
+};
+
+FilterSpec Parse(std::string const& arg){
+    FilterSpec spec;
+    size_t eq = arg.find('='), colon = arg.find(':', eq);
+    if(eq == std::string::npos || eq == 0 || colon == std::string::npos){
+        throw std::runtime_error("bad filter " + arg + ", expected NAME=TYPE:FILE or NAME=TYPE:HASHES:BITS");
+    }
+    spec.name = arg.substr(0, eq);
+    spec.type = arg.substr(eq + 1, colon - eq - 1);
+    std::string rest = arg.substr(colon + 1);
+    size_t sep = rest.find(':');
+    if(sep != std::string::npos && rest.find_first_not_of("0123456789:") == std::string::npos){
+        spec.numHashes = std::stoul(rest.substr(0, sep));
+        spec.numBits = std::stoul(rest.substr(sep + 1));
+        if(spec.numHashes == 0 || spec.numHashes > 255 || spec.numBits == 0 || spec.numBits > 65535){
+            throw std::runtime_error("hashes must be in [1, 255] and bits in [1, 65535]");
+        }
+    } else {
+        spec.path = rest;
+    }
+    return spec;
+}
+
+template <typename BF>
+BF Load(FilterSpec const& spec){
+    if(spec.path.empty()){
+        return BF(spec.numHashes, spec.numBits);
+    }
+    std::ifstream is(spec.path, std::ios::binary);
+    if(!is){
+        throw std::runtime_error("cannot open " + spec.path);
+    }
+    BF bf = BF::Deserialize(is);
+    if(!is){
+        throw std::runtime_error("truncated filter file " + spec.path);
+    }
+    return bf;
+}
+
+bloom::FilterServer::Filter Load(FilterSpec const& spec){
+    if(spec.type == "ordinary"){
+        return Load<bloom::FilterServer::OrdinaryFilter>(spec);
+    }
+    if(spec.type == "counting"){
+        return Load<bloom::FilterServer::CountingFilter>(spec);
+    }
+    if(spec.type == "paired"){
+        return Load<bloom::FilterServer::PairedFilter>(spec);
+    }
+    throw std::runtime_error("unknown filter type " + spec.type);
+}
+
+/** Writes a served filter back to its file, through a temporary file so
+ *  that the old contents survive a failed write
+ */
+void Store(bloom::FilterServer const& server, FilterSpec const& spec){
+    std::string tmp = spec.path + ".tmp";
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        server.Serialize(spec.name, os);
+        if(!os.flush()){
+            throw std::runtime_error("cannot write " + tmp);
+        }
+    }
+    if(std::rename(tmp.c_str(), spec.path.c_str()) != 0){
+        throw std::runtime_error("cannot rename " + tmp);
+    }
+}
+
+void Usage(){
+    std::cerr <<
+        "usage: bloomd [options] SOCKET FILTER...\n"
+        "\n"
+        "filters:\n"
+        "  NAME=TYPE:FILE          serve a filter loaded from a file\n"
+        "  NAME=TYPE:HASHES:BITS   serve an empty filter\n"
+        "  where TYPE is ordinary, counting or paired\n"
+        "\n"
+        "options:\n"
+        "  -j THREADS  number of worker threads (default: all cores)\n"
+        "  -w          write filters back to their files on exit\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]){
+
+    unsigned numThreads = std::thread::hardware_concurrency();
+    bool writeBack = false;
+    std::vector<std::string> args;
+
+    try {
+        for(int i = 1; i < argc; i++){
+            std::string arg = argv[i];
+            if(arg == "-j"){
+                if(i + 1 >= argc){
+                    throw std::runtime_error("missing value for " + arg);
+                }
+                numThreads = std::stoul(argv[++i]);
+            }
+            else if(arg == "-w"){
+                writeBack = true;
+            }
+            else {
+                args.push_back(arg);
+            }
+        }
+        if(args.size() < 2){
+            Usage();
+            return 2;
+        }
+
+        bloom::FilterServer server(args[0], numThreads);
+        std::vector<FilterSpec> specs;
+        for(size_t i = 1; i < args.size(); i++){
+            specs.push_back(Parse(args[i]));
+            server.Add(specs.back().name, Load(specs.back()));
+        }
+
+        // block the signals before starting the workers, which inherit the
+        // mask, so that only sigwait receives them
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        server.Start();
+        int sig;
+        sigwait(&signals, &sig);
+        server.Stop();
+
+        if(writeBack){
+            for(FilterSpec const& spec : specs){
+                if(!spec.path.empty()){
+                    Store(server, spec);
+                }
+            }
+        }
+        return 0;
+    }
+    catch(std::exception const& e){
+        std::cerr << "bloomd: " << e.what() << std::endl;
+        return 1;
+    }
+}
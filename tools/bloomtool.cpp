@@ -0,0 +1,581 @@
+/** bloomtool: builds, queries, merges and inspects serialized Bloom filters
+ *  indexing byte-string keys.
+ *
+ *  Keys are read from a memory-mapped file, either one key per line or, with
+ *  -b, as a sequence of records each consisting of a 32-bit native-endian
+ *  length followed by that many bytes. Keys are hashed with the library's
+ *  default string hash, so filters built here can be queried by programs
+ *  which index std::string or std::string_view keys without specializing
+ *  std::hash.
+ *
+ *  Run without arguments for usage.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "OrdinaryBloomFilter.hpp"
+#include "CountingBloomFilter.hpp"
+#include "PairedBloomFilter.hpp"
+
+namespace {
+
+typedef std::vector<std::string_view> Batch;
+
+/** Number of keys handed from the reader to a worker at a time
+ */
+const size_t BatchSize = 4096;
+
+/** Command-line options shared by all subcommands
+ */
+struct Options {
+    std::string type = "ordinary";
+    unsigned numHashes = 4;
+    unsigned numBits = 0;
+    unsigned numThreads = std::thread::hardware_concurrency();
+    bool binary = false;
+    std::vector<std::string> args;
+};
+
+/** A read-only memory mapping of an entire file
+ */
+class MappedFile {
+
+public:
+
+    explicit
+    MappedFile(std::string const& path)
+    : m_data(nullptr), m_size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            throw std::runtime_error("cannot open " + path + ": " + strerror(errno));
+        }
+        struct stat st;
+        if(fstat(fd, &st) < 0){
+            close(fd);
+            throw std::runtime_error("cannot stat " + path + ": " + strerror(errno));
+        }
+        m_size = st.st_size;
+        if(m_size > 0){
+            void *p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p == MAP_FAILED){
+                close(fd);
+                throw std::runtime_error("cannot map " + path + ": " + strerror(errno));
+            }
+            madvise(p, m_size, MADV_SEQUENTIAL);
+            m_data = (const char *) p;
+        }
+        close(fd);
+    }
+
+    ~MappedFile(){
+        if(m_data){
+            munmap((void *) m_data, m_size);
+        }
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    const char *Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+
+    const char *m_data;
+    size_t m_size;
+
+};
+
+/** Splits a mapped key file into keys, calling f on each full batch and on
+ *  the final partial batch.
+ */
+template <typename F>
+void ReadKeys(MappedFile const& file, bool binary, F f){
+    const char *p = file.Data();
+    const char *end = p + file.Size();
+    Batch batch;
+    batch.reserve(BatchSize);
+
+    while(p < end){
+        if(binary){
+            uint32_t len;
+            if(end - p < (ptrdiff_t) sizeof(len)){
+                throw std::runtime_error("truncated length prefix in binary key stream");
+            }
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if((size_t) (end - p) < len){
+                throw std::runtime_error("truncated key in binary key stream");
+            }
+            batch.emplace_back(p, len);
+            p += len;
+        }
+        else {
+            const char *nl = (const char *) memchr(p, '\n', end - p);
+            const char *stop = nl ? nl : end;
+            batch.emplace_back(p, stop - p);
+            p = nl ? nl + 1 : end;
+        }
+        if(batch.size() == BatchSize){
+            f(std::move(batch));
+            batch = Batch();
+            batch.reserve(BatchSize);
+        }
+    }
+    if(!batch.empty()){
+        f(std::move(batch));
+    }
+}
+
+/** Bounded queue carrying batches from the reader to the workers
+ *
+ *  @param B Type of a batch
+ */
+template <typename B>
+class BatchQueue {
+
+public:
+
+    explicit
+    BatchQueue(size_t capacity)
+    : m_capacity(capacity), m_closed(false)
+    {}
+
+    void Push(B&& b){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [&]{ return m_batches.size() < m_capacity; });
+        m_batches.push_back(std::move(b));
+        m_notEmpty.notify_one();
+    }
+
+    /** Blocks until a batch is available, returning false once the queue
+     *  has been closed and drained.
+     */
+    bool Pop(B &b){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [&]{ return !m_batches.empty() || m_closed; });
+        if(m_batches.empty()){
+            return false;
+        }
+        b = std::move(m_batches.front());
+        m_batches.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void Close(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+
+private:
+
+    size_t m_capacity;
+    bool m_closed;
+    std::deque<B> m_batches;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+
+};
+
+/** A batch numbered in the order it was read
+ */
+struct NumberedBatch {
+    size_t seq;
+    Batch keys;
+};
+
+/** Writes the output of numbered batches to a stream in the order of
+ *  their numbers. At most a window of outputs which are ready ahead of
+ *  their turn is held; workers with later batches wait for their turn.
+ */
+class OrderedWriter {
+
+public:
+
+    OrderedWriter(std::ostream &os, size_t window)
+    : m_os(os), m_window(window), m_next(0)
+    {}
+
+    /** Blocks until batch seq is within the window of the next batch to be
+     *  written, then writes its output and that of the batches after it
+     *  which are ready, or holds it until its turn.
+     */
+    void Write(size_t seq, std::string&& out){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_advanced.wait(lock, [&]{ return seq < m_next + m_window; });
+        m_pending.emplace(seq, std::move(out));
+        while(!m_pending.empty() && m_pending.begin()->first == m_next){
+            std::string const& next = m_pending.begin()->second;
+            m_os.write(next.data(), next.size());
+            m_pending.erase(m_pending.begin());
+            m_next++;
+        }
+        m_advanced.notify_all();
+    }
+
+private:
+
+    std::ostream &m_os;
+    size_t m_window;
+    size_t m_next;
+    std::map<size_t, std::string> m_pending;
+    std::mutex m_mutex;
+    std::condition_variable m_advanced;
+
+};
+
+void Merge(bloom::OrdinaryBloomFilter<std::string> &a, bloom::OrdinaryBloomFilter<std::string> const& b){
+    a.Union(b);
+}
+
+void Merge(bloom::PairedBloomFilter<std::string> &a, bloom::PairedBloomFilter<std::string> const& b){
+    a.Union(b);
+}
+
+void Merge(bloom::CountingBloomFilter<std::string> &a, bloom::CountingBloomFilter<std::string> const& b){
+    a.Add(b);
+}
+
+template <typename BF>
+BF Load(std::string const& path){
+    std::ifstream is(path, std::ios::binary);
+    if(!is){
+        throw std::runtime_error("cannot open " + path);
+    }
+    BF bf = BF::Deserialize(is);
+    if(!is){
+        throw std::runtime_error("truncated filter file " + path);
+    }
+    return bf;
+}
+
+template <typename BF>
+void Store(BF const& bf, std::string const& path){
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    bf.Serialize(os);
+    if(!os.flush()){
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+/** Builds a filter from a key file. The reader thread splits the mapped
+ *  file into batches while each worker inserts batches into a private
+ *  filter; the private filters are merged once the input is exhausted.
+ */
+template <typename BF>
+int Build(Options const& opt){
+    if(opt.args.size() != 2 || opt.numBits == 0){
+        throw std::runtime_error("build requires -m BITS, a key file and an output file");
+    }
+    MappedFile keys(opt.args[0]);
+    BatchQueue<Batch> queue(4 * opt.numThreads);
+
+    std::vector<BF> filters(opt.numThreads, BF(opt.numHashes, opt.numBits));
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < opt.numThreads; t++){
+        workers.emplace_back([&, t]{
+            Batch b;
+            while(queue.Pop(b)){
+                for(std::string_view key : b){
+                    filters[t].Insert(key);
+                }
+            }
+        });
+    }
+
+    try {
+        ReadKeys(keys, opt.binary, [&](Batch&& b){ queue.Push(std::move(b)); });
+    }
+    catch(...){
+        queue.Close();
+        for(std::thread &w : workers){
+            w.join();
+        }
+        throw;
+    }
+    queue.Close();
+    for(std::thread &w : workers){
+        w.join();
+    }
+
+    for(unsigned t = 1; t < opt.numThreads; t++){
+        Merge(filters[0], filters[t]);
+    }
+    Store(filters[0], opt.args[1]);
+    return 0;
+}
+
+/** Queries every key in a key file, writing one line per key to standard
+ *  output containing 1 if the key is present and 0 otherwise. The reader
+ *  thread numbers the batches it hands to the workers, which write their
+ *  results in that order as they finish, so memory use does not grow with
+ *  the number of keys.
+ */
+template <typename BF>
+int Query(Options const& opt){
+    if(opt.args.size() != 2){
+        throw std::runtime_error("query requires a filter file and a key file");
+    }
+    BF bf = Load<BF>(opt.args[0]);
+    MappedFile keys(opt.args[1]);
+    BatchQueue<NumberedBatch> queue(4 * opt.numThreads);
+    OrderedWriter writer(std::cout, 4 * opt.numThreads);
+
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < opt.numThreads; t++){
+        workers.emplace_back([&]{
+            NumberedBatch b;
+            while(queue.Pop(b)){
+                std::string out;
+                out.reserve(2 * b.keys.size());
+                for(std::string_view key : b.keys){
+                    out += bf.Query(key) ? "1\n" : "0\n";
+                }
+                writer.Write(b.seq, std::move(out));
+            }
+        });
+    }
+
+    size_t seq = 0;
+    try {
+        ReadKeys(keys, opt.binary, [&](Batch&& b){ queue.Push(NumberedBatch{seq++, std::move(b)}); });
+    }
+    catch(...){
+        queue.Close();
+        for(std::thread &w : workers){
+            w.join();
+        }
+        throw;
+    }
+    queue.Close();
+    for(std::thread &w : workers){
+        w.join();
+    }
+
+    return std::cout.flush() ? 0 : 1;
+}
+
+/** Merges several filter files of the same type and geometry.
+ */
+template <typename BF>
+int Union(Options const& opt){
+    if(opt.args.size() < 2){
+        throw std::runtime_error("union requires an output file and at least one input file");
+    }
+    BF res = Load<BF>(opt.args[1]);
+    for(size_t i = 2; i < opt.args.size(); i++){
+        BF other = Load<BF>(opt.args[i]);
+        if(other.GetNumHashes() != res.GetNumHashes() || other.GetNumBits() != res.GetNumBits()){
+            throw std::runtime_error(opt.args[i] + " has a different geometry from " + opt.args[1]);
+        }
+        Merge(res, other);
+    }
+    Store(res, opt.args[0]);
+    return 0;
+}
+
+int Compress(Options const& opt){
+    if(opt.type != "ordinary"){
+        throw std::runtime_error("compress is only supported for ordinary filters");
+    }
+    if(opt.args.size() != 2){
+        throw std::runtime_error("compress requires an input file and an output file");
+    }
+    Store(Load<bloom::OrdinaryBloomFilter<std::string>>(opt.args[0]).Compress(), opt.args[1]);
+    return 0;
+}
+
+/** Prints the geometry and occupancy of a filter file. Occupancy is read
+ *  directly from the serialized array, which for ordinary and paired
+ *  filters is a big-endian bit array and for counting filters is one byte
+ *  per counter.
+ */
+int Stats(Options const& opt){
+    if(opt.args.size() != 1){
+        throw std::runtime_error("stats requires a filter file");
+    }
+    std::ifstream is(opt.args[0], std::ios::binary);
+    uint8_t numHashes;
+    uint16_t numBits;
+    is.read((char *) &numHashes, sizeof(uint8_t));
+    is.read((char *) &numBits, sizeof(uint16_t));
+    if(!is || numBits == 0){
+        throw std::runtime_error("cannot read " + opt.args[0]);
+    }
+    std::string body((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    auto bit = [&](size_t i){
+        return (body[i / 8] >> (7 - i % 8)) & 1;
+    };
+
+    size_t set = 0, negative = 0;
+    unsigned maxCount = 0;
+    if(opt.type == "counting"){
+        if(body.size() < numBits){
+            throw std::runtime_error("truncated filter file " + opt.args[0]);
+        }
+        for(size_t i = 0; i < numBits; i++){
+            uint8_t c = body[i];
+            set += c != 0;
+            maxCount = c > maxCount ? c : maxCount;
+        }
+    }
+    else {
+        size_t halves = opt.type == "paired" ? 2 : 1;
+        if(body.size() < (halves * numBits + 7) / 8){
+            throw std::runtime_error("truncated filter file " + opt.args[0]);
+        }
+        for(size_t i = 0; i < numBits; i++){
+            set += bit(i);
+            if(halves == 2){
+                negative += bit(numBits + i);
+            }
+        }
+    }
+
+    double fill = (double) set / numBits;
+    std::cout << "type:            " << opt.type << "\n"
+              << "hashes:          " << (unsigned) numHashes << "\n"
+              << "bits:            " << numBits << "\n"
+              << "fill ratio:      " << fill << "\n"
+              << "estimated items: ";
+    // with every bit set, the estimate is unbounded
+    if(set == numBits){
+        std::cout << "saturated\n";
+    } else {
+        std::cout << -(double) numBits / numHashes * std::log(1 - fill) << "\n";
+    }
+    std::cout << "estimated fpr:   " << std::pow(fill, numHashes) << "\n";
+    if(opt.type == "paired"){
+        std::cout << "negative fill:   " << (double) negative / numBits << "\n";
+    }
+    if(opt.type == "counting"){
+        std::cout << "max counter:     " << maxCount << "\n";
+    }
+    return 0;
+}
+
+template <template <typename> class BF>
+int Dispatch(std::string const& command, Options const& opt){
+    if(command == "build"){
+        return Build<BF<std::string>>(opt);
+    }
+    if(command == "query"){
+        return Query<BF<std::string>>(opt);
+    }
+    if(command == "union"){
+        return Union<BF<std::string>>(opt);
+    }
+    throw std::runtime_error("unknown command " + command);
+}
+
+void Usage(){
+    std::cerr <<
+        "usage: bloomtool COMMAND [options] ARGS...\n"
+        "\n"
+        "commands:\n"
+        "  build KEYS OUT        build a filter from a key file\n"
+        "  query FILTER KEYS     print 1 or 0 for each key in a key file\n"
+        "  union OUT IN...       merge filters with the same geometry\n"
+        "  compress IN OUT       halve an ordinary filter\n"
+        "  stats FILTER          print geometry and occupancy\n"
+        "\n"
+        "options:\n"
+        "  -t TYPE     ordinary (default), counting or paired\n"
+        "  -k HASHES   number of hashes for build (default 4)\n"
+        "  -m BITS     number of bits for build, at most 65535\n"
+        "  -j THREADS  number of worker threads (default: all cores)\n"
+        "  -b          keys are length-prefixed binary records, not lines\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]){
+
+    if(argc < 2){
+        Usage();
+        return 2;
+    }
+
+    std::string command = argv[1];
+    Options opt;
+
+    try {
+        for(int i = 2; i < argc; i++){
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if(i + 1 >= argc){
+                    throw std::runtime_error("missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if(arg == "-t"){
+                opt.type = value();
+            }
+            else if(arg == "-k"){
+                opt.numHashes = std::stoul(value());
+            }
+            else if(arg == "-m"){
+                opt.numBits = std::stoul(value());
+            }
+            else if(arg == "-j"){
+                opt.numThreads = std::stoul(value());
+            }
+            else if(arg == "-b"){
+                opt.binary = true;
+            }
+            else {
+                opt.args.push_back(arg);
+            }
+        }
+        if(opt.numThreads == 0){
+            opt.numThreads = 1;
+        }
+        if(opt.numHashes == 0 || opt.numHashes > 255 || opt.numBits > 65535){
+            throw std::runtime_error("hashes must be in [1, 255] and bits in [1, 65535]");
+        }
+
+        if(command == "compress"){
+            return Compress(opt);
+        }
+        if(command == "stats"){
+            return Stats(opt);
+        }
+        if(opt.type == "ordinary"){
+            return Dispatch<bloom::OrdinaryBloomFilter>(command, opt);
+        }
+        if(opt.type == "counting"){
+            return Dispatch<bloom::CountingBloomFilter>(command, opt);
+        }
+        if(opt.type == "paired"){
+            return Dispatch<bloom::PairedBloomFilter>(command, opt);
+        }
+        throw std::runtime_error("unknown filter type " + opt.type);
+    }
+    catch(std::exception const& e){
+        std::cerr << "bloomtool: " << e.what() << std::endl;
+        return 1;
+    }
+}